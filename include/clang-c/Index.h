@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 6
+#define CINDEX_VERSION_MINOR 7
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -4715,6 +4715,42 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             unsigned num_unsaved_files,
                                             unsigned options);
 
+/**
+ * \brief Perform code completion at a given location, returning only the
+ * results that match the given filter text.
+ *
+ * This routine behaves like \c clang_codeCompleteAt(), except that results
+ * whose typed text does not match \p filter are dropped. A result matches if
+ * \p filter is a prefix of its typed text or, ignoring case, a subsequence
+ * of it (e.g., "gfb" matches "getFooBar"). The matching results are returned
+ * best match first, followed by completion priority, and only the best
+ * \p max_results of them are returned.
+ *
+ * Member-access and qualified-name results are retained unfiltered by the
+ * translation unit, so that later requests at the same location, with a
+ * different filter as the user types, are answered without reparsing.
+ *
+ * \param filter the text to match, typically what the user has typed so
+ * far. If NULL or empty, no results are dropped because of their name.
+ *
+ * \param max_results the maximum number of results to return; zero means no
+ * limit.
+ *
+ * The remaining parameters and the result are as for
+ * \c clang_codeCompleteAt().
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *
+clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line,
+                               unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files,
+                               unsigned options,
+                               const char *filter,
+                               unsigned max_results);
+
 /**
  * \brief Sort the code-completion results in case-insensitive alphabetical 
  * order.
@@ -4812,6 +4848,50 @@ CXString clang_codeCompleteGetContainerUSR(CXCodeCompleteResults *Results);
  */
 CINDEX_LINKAGE
 CXString clang_codeCompleteGetObjCSelector(CXCodeCompleteResults *Results);
+
+/**
+ * \brief Retrieve a histogram of the time taken by the code-completion
+ * requests performed on the given translation unit.
+ *
+ * Bucket 0 counts requests that took less than one millisecond, and bucket
+ * \c i counts requests that took at least 2^(i-1) and less than 2^i
+ * milliseconds. libclang keeps 16 buckets; the last one also counts all
+ * requests slower than that, and any further buckets requested are zero.
+ *
+ * \param TU the translation unit to query.
+ *
+ * \param Buckets if non-NULL, an array of \p NumBuckets elements that will
+ * receive the histogram.
+ *
+ * \param NumBuckets the number of elements in \p Buckets.
+ *
+ * \returns the total number of code-completion requests performed on the
+ * translation unit since it was created or the histogram was last reset.
+ */
+CINDEX_LINKAGE
+unsigned clang_codeCompleteGetLatencyHistogram(CXTranslationUnit TU,
+                                               unsigned *Buckets,
+                                               unsigned NumBuckets);
+
+/**
+ * \brief Retrieve the number of code-completion requests on the given
+ * translation unit that were answered by reusing the results of the previous
+ * request, without reparsing.
+ *
+ * Member-access and qualified-name completion results are retained by the
+ * translation unit, and reused by a request at the same position for which
+ * the unsaved files differ at most by the identifier following the
+ * completion point, i.e., while the user is typing the name being completed.
+ */
+CINDEX_LINKAGE
+unsigned clang_codeCompleteGetNumCacheHits(CXTranslationUnit TU);
+
+/**
+ * \brief Reset the code-completion latency histogram and cache hit count of
+ * the given translation unit.
+ */
+CINDEX_LINKAGE
+void clang_codeCompleteResetLatencyHistogram(CXTranslationUnit TU);
   
 /**
  * @}
@@ -17,8 +17,11 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace clang {
   class AddrLabelExpr;
@@ -27,6 +30,7 @@ namespace clang {
   class DiagnosticBuilder;
   class Expr;
   class FieldDecl;
+  class FunctionDecl;
   class Decl;
   class ValueDecl;
   class CXXRecordDecl;
@@ -290,6 +294,13 @@ public:
     return ((const Arr*)(const void *)Data)->ArrSize;
   }
 
+  /// \brief Represent the trailing initialized elements of this array that
+  /// are all the same integer or floating-point value by the array filler.
+  ///
+  /// Tables computed at compile time are often padded with a repeated value;
+  /// this keeps one APValue for the padding instead of one per element.
+  void compactArray();
+
   unsigned getStructNumBases() const {
     assert(isStruct() && "Invalid accessor");
     return ((const StructData*)(const char*)Data)->NumBases;
@@ -441,6 +452,39 @@ private:
   }
 };
 
+/// \brief The memoized result of a call to a constexpr function.
+///
+/// Calls whose arguments are all integer or floating-point values, and which
+/// evaluate to a constant expression without looking at anything outside
+/// their own frame, are remembered by the ASTContext so that repeating the
+/// call with the same arguments does not evaluate the body again.
+class ConstexprCallResult : public llvm::FoldingSetNode {
+  const FunctionDecl *Callee;
+  SmallVector<APValue, 4> Args;
+
+public:
+  /// \brief The value returned by the call.
+  APValue Result;
+
+  /// \brief The depth of the constexpr call stack needed to evaluate the
+  /// call, counting the call itself.
+  unsigned Depth;
+
+  ConstexprCallResult(const FunctionDecl *Callee, ArrayRef<APValue> Args,
+                      const APValue &Result, unsigned Depth)
+    : Callee(Callee), Args(Args.begin(), Args.end()), Result(Result),
+      Depth(Depth) {}
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Callee, Args);
+  }
+
+  /// \brief Profile a call to \p Callee with the given integer and
+  /// floating-point arguments.
+  static void Profile(llvm::FoldingSetNodeID &ID, const FunctionDecl *Callee,
+                      ArrayRef<APValue> Args);
+};
+
 } // end namespace clang.
 
 #endif
@@ -154,6 +154,13 @@ class ASTContext : public RefCountedBase<ASTContext> {
   mutable llvm::DenseMap<const ObjCContainerDecl*, const ASTRecordLayout*>
     ObjCLayouts;
 
+  /// \brief The memoized results of constexpr function calls, keyed by the
+  /// callee and the values of the arguments.
+  ///
+  /// This is lazily populated by the constant evaluator.  This is
+  /// intentionally not serialized.
+  mutable llvm::FoldingSet<ConstexprCallResult> ConstexprCallResults;
+
   /// \brief A cache from types to size and alignment information.
   typedef llvm::DenseMap<const Type*,
                          std::pair<uint64_t, unsigned> > TypeInfoMap;
@@ -370,6 +377,30 @@ class ASTContext : public RefCountedBase<ASTContext> {
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief Whether the statements of each function body are allocated
+  /// separately, so that releaseFunctionBody() can free them.
+  bool SeparateBodyAllocation;
+
+  /// \brief The function bodies being built, innermost last, along with the
+  /// allocator for their statements.
+  ///
+  /// Template instantiations and implicitly-defined functions push an entry
+  /// with a null allocator: the statements they create can outlive the body
+  /// being built, so they come from the main allocator.
+  typedef std::pair<const FunctionDecl *, llvm::BumpPtrAllocator *>
+    BodyAllocatorEntry;
+  SmallVector<BodyAllocatorEntry, 4> BodyAllocatorStack;
+
+  /// \brief The allocator for the statements of each function body that was
+  /// allocated separately.
+  llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>
+    BodyAllocators;
+
+  /// \brief The number of function bodies freed by releaseFunctionBody(),
+  /// and the memory they used.
+  unsigned NumReleasedBodies;
+  size_t ReleasedBodyMemory;
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -415,6 +446,37 @@ public:
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
+
+  /// \brief Allocate memory for a statement, from the allocator of the
+  /// function body being built if it has one.
+  void *AllocateStmt(unsigned Size, unsigned Align = 8) const {
+    if (BodyAllocatorStack.empty() || !BodyAllocatorStack.back().second)
+      return BumpAlloc.Allocate(Size, Align);
+    return BodyAllocatorStack.back().second->Allocate(Size, Align);
+  }
+
+  /// \brief Allocate the statements of each function body separately, so
+  /// that they can be freed with releaseFunctionBody().
+  void setSeparateBodyAllocation(bool Separate) {
+    SeparateBodyAllocation = Separate;
+  }
+
+  /// \brief Note that Sema starts building the body of \p FD.
+  void startFunctionBody(const FunctionDecl *FD);
+
+  /// \brief Note that Sema is done building the body of \p FD.
+  void finishFunctionBody(const FunctionDecl *FD);
+
+  /// \brief Allocate the statements created from now on, until the matching
+  /// finishSharedStatements(), from the main allocator.
+  void startSharedStatements();
+  void finishSharedStatements();
+
+  /// \brief Replace the body of \p FD with an empty compound statement, and
+  /// free the memory of the old body if it was allocated separately.
+  ///
+  /// Nothing may refer to the statements of the old body afterwards.
+  void releaseFunctionBody(FunctionDecl *FD);
   
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
@@ -2005,6 +2067,20 @@ public:
 
   /// \brief Retrieve the lambda mangling number for a lambda expression.
   unsigned getLambdaManglingNumber(CXXMethodDecl *CallOperator);
+
+  /// \brief Get the memoized result of calling the constexpr function
+  /// \p Callee with the integer and floating-point arguments \p Args, or
+  /// NULL if there is none.
+  const ConstexprCallResult *
+  getConstexprCallResult(const FunctionDecl *Callee,
+                         ArrayRef<APValue> Args) const;
+
+  /// \brief Remember that calling the constexpr function \p Callee with
+  /// \p Args produced \p Result, using \p Depth levels of the constexpr call
+  /// stack.
+  void setConstexprCallResult(const FunctionDecl *Callee,
+                              ArrayRef<APValue> Args, const APValue &Result,
+                              unsigned Depth) const;
   
   /// \brief Used by ParmVarDecl to store on the side the
   /// index of the parameter when it exceeds the size of the normal bitfield.
@@ -17,6 +17,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclarationName.h"
 #include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
@@ -26,17 +27,100 @@ namespace clang {
 
 class DependentDiagnostic;
 
+/// \brief The vector form of a StoredDeclsList.
+///
+/// Overload sets can hold tens of thousands of functions, e.g., in namespace
+/// std or in generated code. Once a list is longer than a few decls, we also
+/// keep the position of each decl in a hash table, so that the decl a new
+/// declaration replaces can be found without scanning the whole list.
+class StoredDeclsVector : public SmallVector<NamedDecl *, 4> {
+  typedef llvm::DenseMap<NamedDecl *, unsigned> PositionsTy;
+
+  /// \brief The position of each decl, or empty if not built yet.
+  PositionsTy Positions;
+
+  /// \brief Lists of at most this many decls are searched linearly.
+  enum { MaxLinearSearchSize = 16 };
+
+  /// \brief Record the positions of the decls starting at \p I.
+  void updatePositions(iterator I) {
+    if (Positions.empty())
+      return;
+    for (iterator E = end(); I != E; ++I)
+      Positions[*I] = I - begin();
+  }
+
+public:
+  /// \brief Return the position of \p D, or end() if it is not in the list.
+  iterator findDecl(NamedDecl *D) {
+    if (size() <= MaxLinearSearchSize)
+      return std::find(begin(), end(), D);
+
+    if (Positions.empty()) {
+      for (iterator I = begin(), E = end(); I != E; ++I)
+        Positions[*I] = I - begin();
+    }
+    PositionsTy::iterator Pos = Positions.find(D);
+    if (Pos == Positions.end())
+      return end();
+    return begin() + Pos->second;
+  }
+
+  /// \brief Add \p D at the end of the list.
+  void addDecl(NamedDecl *D) {
+    push_back(D);
+    updatePositions(end() - 1);
+  }
+
+  /// \brief Insert \p D before position \p I.
+  void insertDecl(iterator I, NamedDecl *D) {
+    I = insert(I, D);
+    updatePositions(I);
+  }
+
+  /// \brief Put \p D at position \p I, replacing the decl that is there.
+  void replaceDecl(iterator I, NamedDecl *D) {
+    if (!Positions.empty()) {
+      Positions.erase(*I);
+      Positions[D] = I - begin();
+    }
+    *I = D;
+  }
+
+  /// \brief Remove the decl at position \p I.
+  void eraseDecl(iterator I) {
+    Positions.erase(*I);
+    I = erase(I);
+    updatePositions(I);
+  }
+};
+
 /// StoredDeclsList - This is an array of decls optimized a common case of only
 /// containing one entry.
 struct StoredDeclsList {
 
   /// DeclsTy - When in vector form, this is what the Data pointer points to.
-  typedef SmallVector<NamedDecl *, 4> DeclsTy;
+  typedef StoredDeclsVector DeclsTy;
 
   /// \brief The stored data, which will be either a pointer to a NamedDecl,
   /// or a pointer to a vector.
   llvm::PointerUnion<NamedDecl *, DeclsTy *> Data;
 
+  /// \brief If \p D can only replace the declaration it redeclares, set
+  /// \p PrevD to that declaration (or null) and return true.
+  static bool getReplacedDecl(NamedDecl *D, NamedDecl *&PrevD) {
+    if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+      PrevD = FD->getPreviousDecl();
+      return true;
+    }
+    if (FunctionTemplateDecl *FTD = dyn_cast<FunctionTemplateDecl>(D)) {
+      FunctionDecl *PrevFD = FTD->getTemplatedDecl()->getPreviousDecl();
+      PrevD = PrevFD ? PrevFD->getDescribedFunctionTemplate() : 0;
+      return true;
+    }
+    return false;
+  }
+
 public:
   StoredDeclsList() {}
 
@@ -89,9 +173,9 @@ public:
     }
 
     DeclsTy &Vec = *getAsVector();
-    DeclsTy::iterator I = std::find(Vec.begin(), Vec.end(), D);
+    DeclsTy::iterator I = Vec.findDecl(D);
     assert(I != Vec.end() && "list does not contain decl");
-    Vec.erase(I);
+    Vec.eraseDecl(I);
 
     assert(std::find(Vec.begin(), Vec.end(), D)
              == Vec.end() && "list still contains decl");
@@ -131,13 +215,28 @@ public:
       return true;
     }
 
-    // Determine if this declaration is actually a redeclaration.
     DeclsTy &Vec = *getAsVector();
+
+    // Functions and function templates only replace the declaration they
+    // redeclare, which we can look up directly instead of trying every
+    // overload.
+    NamedDecl *PrevD;
+    if (getReplacedDecl(D, PrevD)) {
+      if (!PrevD)
+        return false;
+      DeclsTy::iterator OD = Vec.findDecl(PrevD);
+      if (OD == Vec.end())
+        return false;
+      Vec.replaceDecl(OD, D);
+      return true;
+    }
+
+    // Determine if this declaration is actually a redeclaration.
     for (DeclsTy::iterator OD = Vec.begin(), ODEnd = Vec.end();
          OD != ODEnd; ++OD) {
       NamedDecl *OldD = *OD;
       if (D->declarationReplaces(OldD)) {
-        *OD = D;
+        Vec.replaceDecl(OD, D);
         return true;
       }
     }
@@ -153,7 +252,7 @@ public:
     // form.
     if (NamedDecl *OldD = getAsDecl()) {
       DeclsTy *VT = new DeclsTy();
-      VT->push_back(OldD);
+      VT->addDecl(OldD);
       Data = VT;
     }
 
@@ -168,7 +267,7 @@ public:
     // iterator which points at the first tag will start a span of
     // decls that only contains tags.
     if (D->hasTagIdentifierNamespace())
-      Vec.push_back(D);
+      Vec.addDecl(D);
 
     // Resolved using declarations go at the front of the list so that
     // they won't show up in other lookup results.  Unresolved using
@@ -181,17 +280,17 @@ public:
                (*I)->getIdentifierNamespace() == Decl::IDNS_Using)
           ++I;
       }
-      Vec.insert(I, D);
+      Vec.insertDecl(I, D);
 
     // All other declarations go at the end of the list, but before any
     // tag declarations.  But we can be clever about tag declarations
     // because there can only ever be one in a scope.
     } else if (Vec.back()->hasTagIdentifierNamespace()) {
       NamedDecl *TagD = Vec.back();
-      Vec.back() = D;
-      Vec.push_back(TagD);
+      Vec.replaceDecl(Vec.end() - 1, D);
+      Vec.addDecl(TagD);
     } else
-      Vec.push_back(D);
+      Vec.addDecl(D);
   }
 };
 
@@ -21,6 +21,7 @@
 namespace clang {
 
 class ASTConsumer;
+class ASTRecordLayout;
 class CXXBaseSpecifier;
 class DeclarationName;
 class ExternalSemaSource; // layering violation required for downcasting
@@ -28,6 +29,7 @@ class NamedDecl;
 class Selector;
 class Stmt;
 class TagDecl;
+class VTableContext;
 
 /// \brief Enumeration describing the result of loading information from
 /// an external source.
@@ -244,6 +246,25 @@ public:
   { 
     return false;
   }
+
+  /// \brief Retrieve the layout of the given record that was computed when
+  /// the external source was built.
+  ///
+  /// Unlike layoutRecordType(), this provides the complete layout, so the
+  /// record is not laid out again.
+  ///
+  /// \returns the layout, allocated in the ASTContext, or null if the
+  /// external source did not store one.
+  virtual const ASTRecordLayout *
+  getStoredRecordLayout(const RecordDecl *Record);
+
+  /// \brief Add to \p VTContext the vtable layout, thunks, method vtable
+  /// indices and virtual base offset offsets of the given class that were
+  /// computed when the external source was built.
+  ///
+  /// \returns true if the external source stored this information.
+  virtual bool loadStoredVTableInformation(const CXXRecordDecl *Record,
+                                           VTableContext &VTContext);
   
   //===--------------------------------------------------------------------===//
   // Queries for performance analysis.
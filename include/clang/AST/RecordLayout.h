@@ -113,6 +113,7 @@ private:
   CXXRecordLayoutInfo *CXXInfo;
 
   friend class ASTContext;
+  friend class ASTReader;
 
   ASTRecordLayout(const ASTContext &Ctx, CharUnits size, CharUnits alignment,
                   CharUnits datasize, const uint64_t *fieldoffsets,
@@ -20,6 +20,7 @@
 #include "clang/AST/RecordLayout.h"
 #include "clang/Basic/ABI.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include <utility>
 
 namespace clang {
@@ -265,6 +266,8 @@ public:
 class VTableContext {
   ASTContext &Context;
 
+  friend class ASTReader;
+
 public:
   typedef SmallVector<std::pair<uint64_t, ThunkInfo>, 1>
     VTableThunksTy;
@@ -299,6 +302,15 @@ private:
   /// Thunks - Contains all thunks that a given method decl will need.
   ThunksMapTy Thunks;
 
+  /// StoredInfoLookups - The classes for which the external AST source has
+  /// been asked for stored vtable information.
+  llvm::SmallPtrSet<const CXXRecordDecl *, 16> StoredInfoLookups;
+
+  /// LoadStoredVTableInformation - Load the vtable related information of
+  /// the given record decl from the AST file that defines it, if it was
+  /// stored there. Returns true if it was.
+  bool LoadStoredVTableInformation(const CXXRecordDecl *RD);
+
   void ComputeMethodVTableIndices(const CXXRecordDecl *RD);
 
   /// ComputeVTableRelatedInformation - Compute and store all vtable related
@@ -0,0 +1,189 @@
+//===- BitVectorDataflow.h - Dense bit-vector dataflow solver ---*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines BitVectorDataflow, a solver for forward and backward
+// dataflow problems over source-level CFGs whose values are dense bit vectors,
+// and DataflowNumbering, which numbers the variables of such a problem.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BITVECTOR_DATAFLOW_H
+#define LLVM_CLANG_BITVECTOR_DATAFLOW_H
+
+#include "clang/Analysis/Analyses/DataflowWorklist.h"
+#include "clang/Analysis/CFG.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include <vector>
+
+namespace clang {
+
+class VarDecl;
+
+/// \brief Assigns compact, consecutive indices to the entities tracked by a
+/// dataflow analysis (usually variables), so that their values can be stored
+/// in bit vectors.
+template <typename KeyT>
+class DataflowNumbering {
+  llvm::DenseMap<KeyT, unsigned> Indices;
+  SmallVector<KeyT, 16> Keys;
+
+public:
+  /// \brief Return the index of the given key, numbering it if it has not
+  /// been seen before.
+  unsigned getOrAddIndex(KeyT K) {
+    std::pair<typename llvm::DenseMap<KeyT, unsigned>::iterator, bool> R =
+      Indices.insert(std::make_pair(K, Keys.size()));
+    if (R.second)
+      Keys.push_back(K);
+    return R.first->second;
+  }
+
+  /// \brief Return the index of the given key, if it has been numbered.
+  llvm::Optional<unsigned> getIndex(KeyT K) const {
+    typename llvm::DenseMap<KeyT, unsigned>::const_iterator I = Indices.find(K);
+    if (I == Indices.end())
+      return llvm::Optional<unsigned>();
+    return I->second;
+  }
+
+  KeyT getKey(unsigned Index) const { return Keys[Index]; }
+
+  unsigned size() const { return Keys.size(); }
+  bool empty() const { return Keys.empty(); }
+};
+
+typedef DataflowNumbering<const VarDecl *> DataflowVarNumbering;
+
+/// \brief Computes the fixed point of a dataflow problem whose values are
+/// bit vectors, merging the values along the incoming edges of a block with
+/// set union.
+///
+/// Bits beyond the end of a vector are treated as zero, so an analysis that
+/// numbers its variables lazily may grow the vectors it is handed.
+///
+/// A forward analysis only visits the blocks reachable from the entry block;
+/// a backward analysis visits every block, so that the values of blocks which
+/// never reach the exit (e.g., infinite loops) are computed too.
+class BitVectorDataflow {
+public:
+  typedef DataflowWorklist::Direction Direction;
+
+private:
+  const CFG &cfg;
+  const FlatCFGView &View;
+  Direction Dir;
+
+  /// \brief The values at the start of each block, indexed by the block's
+  /// index in \c View.
+  std::vector<llvm::BitVector> EntryValues;
+
+  /// \brief The values at the end of each block, indexed by the block's
+  /// index in \c View.
+  std::vector<llvm::BitVector> ExitValues;
+
+  llvm::BitVector Boundary;
+  llvm::BitVector Analyzed;
+  unsigned NumBlockVisits;
+
+  bool isForward() const { return Dir == DataflowWorklist::Forward; }
+
+  /// \brief The values flowing into a block, in the direction of analysis.
+  llvm::BitVector &getInValues(unsigned Index) {
+    return isForward() ? EntryValues[Index] : ExitValues[Index];
+  }
+
+  /// \brief The values flowing out of a block, in the direction of analysis.
+  llvm::BitVector &getOutValues(unsigned Index) {
+    return isForward() ? ExitValues[Index] : EntryValues[Index];
+  }
+
+  /// \brief Merge the values flowing into a block into \p Vals.
+  void computeInValues(unsigned Index, llvm::BitVector &Vals);
+
+public:
+  BitVectorDataflow(const CFG &cfg, const FlatCFGView &View, Direction Dir);
+
+  /// \brief Set the values that flow into the entry block of a forward
+  /// analysis, or out of the exit block of a backward analysis.
+  void setBoundaryValues(const llvm::BitVector &V) { Boundary = V; }
+
+  /// \brief Run the analysis to a fixed point.
+  ///
+  /// \p Transfer must provide a method
+  /// \code
+  ///   void transferBlock(const CFGBlock *B, llvm::BitVector &Vals);
+  /// \endcode
+  /// which applies the effect of \p B, in the direction of analysis, to the
+  /// values in \p Vals. It must only depend on the incoming values.
+  template <typename TransferTy>
+  void solve(TransferTy &Transfer) {
+    DataflowWorklist Worklist(View, Dir);
+    if (isForward()) {
+      Worklist.enqueueBlock(View.getIndex(&cfg.getEntry()));
+    } else {
+      for (unsigned Index = 0, N = View.size(); Index != N; ++Index)
+        Worklist.enqueueBlock(Index);
+    }
+
+    llvm::BitVector Vals;
+    while (!Worklist.empty()) {
+      unsigned Index = Worklist.dequeue();
+      computeInValues(Index, Vals);
+
+      // The values flowing out of a block only change when the values flowing
+      // into it do.
+      bool FirstVisit = !Analyzed[Index];
+      llvm::BitVector &In = getInValues(Index);
+      if (!FirstVisit && In == Vals)
+        continue;
+      In = Vals;
+
+      Transfer.transferBlock(View.getBlock(Index), Vals);
+      Analyzed[Index] = true;
+      ++NumBlockVisits;
+
+      llvm::BitVector &Out = getOutValues(Index);
+      if (!FirstVisit && Out == Vals)
+        continue;
+      Out = Vals;
+
+      if (isForward())
+        Worklist.enqueueSuccessors(Index);
+      else
+        Worklist.enqueuePredecessors(Index);
+    }
+  }
+
+  /// \brief Return the values at the start of the given block.
+  const llvm::BitVector &getEntryValues(const CFGBlock *B) const {
+    return EntryValues[View.getIndex(B)];
+  }
+
+  /// \brief Return the values at the end of the given block.
+  const llvm::BitVector &getExitValues(const CFGBlock *B) const {
+    return ExitValues[View.getIndex(B)];
+  }
+
+  /// \brief Return true if the transfer function has been applied to the
+  /// given block, i.e., if its values are meaningful.
+  bool wasAnalyzed(const CFGBlock *B) const {
+    return Analyzed[View.getIndex(B)];
+  }
+
+  /// \brief Return the number of times the transfer function was applied.
+  unsigned getNumBlockVisits() const { return NumBlockVisits; }
+};
+
+} // end namespace clang
+
+#endif
@@ -0,0 +1,63 @@
+//===- DataflowWorklist.h - Worklist for dataflow analyses ------*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines DataflowWorklist, a worklist of CFG blocks that is shared
+// by the intraprocedural dataflow analyses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_DATAFLOW_WORKLIST_H
+#define LLVM_CLANG_DATAFLOW_WORKLIST_H
+
+#include "clang/Analysis/Analyses/FlatCFGView.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+
+/// \brief A worklist of CFG blocks which dequeues blocks in the order that
+/// makes a dataflow analysis converge quickly.
+///
+/// Blocks are identified by their index in a FlatCFGView. They are dequeued
+/// in reverse post-order for a forward analysis and in post-order for a
+/// backward analysis, so that a block is usually visited after the blocks
+/// whose values flow into it. A block is never in the worklist more than once.
+class DataflowWorklist {
+public:
+  enum Direction { Forward, Backward };
+
+private:
+  const FlatCFGView &View;
+
+  /// \brief The enqueued block indices, kept as a heap whose top is the
+  /// block to visit next.
+  SmallVector<unsigned, 20> Heap;
+  llvm::BitVector EnqueuedBlocks;
+  bool IsForward;
+
+public:
+  DataflowWorklist(const FlatCFGView &View, Direction Dir);
+
+  /// \brief Add a block to the worklist, unless it is already enqueued or
+  /// the index is FlatCFGView::InvalidIndex.
+  void enqueueBlock(unsigned Index);
+  void enqueueSuccessors(unsigned Index);
+  void enqueuePredecessors(unsigned Index);
+
+  /// \brief Remove and return the index of the next block to visit, or
+  /// FlatCFGView::InvalidIndex if the worklist is empty.
+  unsigned dequeue();
+
+  bool empty() const { return Heap.empty(); }
+};
+
+} // end namespace clang
+
+#endif
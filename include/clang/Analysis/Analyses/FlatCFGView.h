@@ -0,0 +1,116 @@
+//===- FlatCFGView.h - Flattened, RPO-numbered layout of a CFG --*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines FlatCFGView, a read-only copy of a finalized CFG laid out
+// in a few contiguous arrays so that analyses walking the graph many times
+// access memory sequentially.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FLATCFGVIEW_H
+#define LLVM_CLANG_FLATCFGVIEW_H
+
+#include "clang/Analysis/AnalysisContext.h"
+#include "clang/Analysis/CFG.h"
+#include <iterator>
+#include <vector>
+
+namespace clang {
+
+/// \brief A flattened layout of a CFG.
+///
+/// Blocks are numbered densely in reverse post-order from the entry block,
+/// followed by the blocks that are unreachable from the entry in the order of
+/// the CFG. The elements of all blocks are stored in one array, in block
+/// order, and the edges are stored in compressed sparse row form: the
+/// successors (or predecessors) of block \c I are the indices between the
+/// offsets of \c I and \c I+1.
+///
+/// Edges that were pruned from the CFG (null successors) keep their position
+/// and are represented by \c InvalidIndex.
+class FlatCFGView : public ManagedAnalysis {
+  virtual void anchor();
+public:
+  static const unsigned InvalidIndex = ~0U;
+
+  typedef const CFGElement *element_iterator;
+  typedef std::reverse_iterator<element_iterator> reverse_element_iterator;
+  typedef const unsigned *edge_iterator;
+
+private:
+  /// \brief The blocks, by index.
+  std::vector<const CFGBlock *> Blocks;
+
+  /// \brief The index of each block, by block ID.
+  std::vector<unsigned> BlockIndices;
+
+  std::vector<CFGElement> Elements;
+  std::vector<unsigned> ElementOffsets;
+
+  std::vector<unsigned> Succs;
+  std::vector<unsigned> SuccOffsets;
+
+  std::vector<unsigned> Preds;
+  std::vector<unsigned> PredOffsets;
+
+  unsigned NumReachableBlocks;
+
+public:
+  FlatCFGView(const CFG &cfg);
+
+  /// \brief Return the number of blocks.
+  unsigned size() const { return Blocks.size(); }
+
+  /// \brief Return the number of blocks that are reachable from the entry
+  /// block. These are the blocks with indices below this number.
+  unsigned getNumReachableBlocks() const { return NumReachableBlocks; }
+
+  const CFGBlock *getBlock(unsigned Index) const { return Blocks[Index]; }
+
+  unsigned getIndex(const CFGBlock *B) const {
+    return BlockIndices[B->getBlockID()];
+  }
+
+  element_iterator element_begin(unsigned Index) const {
+    return Elements.empty() ? 0 : &Elements[0] + ElementOffsets[Index];
+  }
+  element_iterator element_end(unsigned Index) const {
+    return Elements.empty() ? 0 : &Elements[0] + ElementOffsets[Index + 1];
+  }
+
+  reverse_element_iterator element_rbegin(unsigned Index) const {
+    return reverse_element_iterator(element_end(Index));
+  }
+  reverse_element_iterator element_rend(unsigned Index) const {
+    return reverse_element_iterator(element_begin(Index));
+  }
+
+  edge_iterator succ_begin(unsigned Index) const {
+    return Succs.empty() ? 0 : &Succs[0] + SuccOffsets[Index];
+  }
+  edge_iterator succ_end(unsigned Index) const {
+    return Succs.empty() ? 0 : &Succs[0] + SuccOffsets[Index + 1];
+  }
+
+  edge_iterator pred_begin(unsigned Index) const {
+    return Preds.empty() ? 0 : &Preds[0] + PredOffsets[Index];
+  }
+  edge_iterator pred_end(unsigned Index) const {
+    return Preds.empty() ? 0 : &Preds[0] + PredOffsets[Index + 1];
+  }
+
+  // Used by AnalysisDeclContext to construct this object.
+  static const void *getTag();
+
+  static FlatCFGView *create(AnalysisDeclContext &analysisContext);
+};
+
+} // end clang namespace
+
+#endif
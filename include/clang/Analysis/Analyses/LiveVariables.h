@@ -16,6 +16,7 @@
 
 #include "clang/Analysis/AnalysisContext.h"
 #include "clang/AST/Decl.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/ImmutableSet.h"
 
@@ -29,20 +30,26 @@ class SourceManager;
   
 class LiveVariables : public ManagedAnalysis {
 public:
+  /// \brief Assigns dense indices to the variables and expressions whose
+  /// liveness is tracked.
+  class ValueNumbering;
+
   class LivenessValues {
   public:
 
-    llvm::ImmutableSet<const Stmt *> liveStmts;
-    llvm::ImmutableSet<const VarDecl *> liveDecls;
+    /// \brief The live block-level expressions and variables, indexed by
+    /// their number in \c numbering.
+    llvm::BitVector live;
+    const ValueNumbering *numbering;
     
     bool equals(const LivenessValues &V) const;
 
     LivenessValues()
-      : liveStmts(0), liveDecls(0) {}
+      : numbering(0) {}
 
-    LivenessValues(llvm::ImmutableSet<const Stmt *> LiveStmts,
-                   llvm::ImmutableSet<const VarDecl *> LiveDecls)
-      : liveStmts(LiveStmts), liveDecls(LiveDecls) {}
+    LivenessValues(const llvm::BitVector &Live,
+                   const ValueNumbering *Numbering)
+      : live(Live), numbering(Numbering) {}
 
     ~LivenessValues() {}
     
@@ -88,6 +95,12 @@ public:
   /// Returns true the block-level expression "value" is live
   ///  before the given block-level expression (see runOnAllBlocks).
   bool isLive(const Stmt *Loc, const Stmt *StmtVal);
+
+  /// Returns a number which is the same for two statements exactly when the
+  ///  same block-level expressions and variables are live before both of
+  ///  them, so that clients can tell when liveness queries at one statement
+  ///  give the same answers as at another.
+  unsigned getLivenessClass(const Stmt *Loc);
     
   /// Print to stderr the liveness information associated with
   /// each basic block.
@@ -145,13 +145,34 @@ public:
                                      SourceLocation Loc) {}
 };
 
+/// \brief Statistics about a single run of the thread safety analysis.
+struct ThreadSafetyStats {
+  /// \brief Number of locksets joined at merge points and back edges.
+  unsigned NumJoins;
+  /// \brief Number of joins of a lockset with itself, which were skipped.
+  unsigned NumTrivialJoins;
+  /// \brief Number of joins answered from the cache of earlier joins.
+  unsigned NumCachedJoins;
+  /// \brief Number of distinct mutex expressions.
+  unsigned NumMutexes;
+  /// \brief Number of distinct locksets.
+  unsigned NumLocksets;
+  /// \brief Time spent computing local variable contexts, in seconds.
+  double ContextTime;
+  /// \brief Time spent computing and checking locksets, in seconds.
+  double LocksetTime;
+};
+
 /// \brief Check a function's CFG for thread-safety violations.
 ///
 /// We traverse the blocks in the CFG, compute the set of mutexes that are held
 /// at the end of each block, and issue warnings for thread safety violations.
 /// Each block in the CFG is traversed exactly once.
+///
+/// If \p Stats is non-null, statistics about the analysis are added to it.
 void runThreadSafetyAnalysis(AnalysisDeclContext &AC,
-                             ThreadSafetyHandler &Handler);
+                             ThreadSafetyHandler &Handler,
+                             ThreadSafetyStats *Stats = 0);
 
 /// \brief Helper function that returns a LockKind required for the given level
 /// of access.
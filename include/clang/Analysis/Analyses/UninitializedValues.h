@@ -103,5 +103,18 @@ void runUninitializedVariablesAnalysis(const DeclContext &dc, const CFG &cfg,
                                        UninitVariablesHandler &handler,
                                        UninitVariablesAnalysisStats &stats);
 
+/// Determine, without building a CFG, whether the uninitialized variables
+/// analysis of the given declaration context could possibly find a use of an
+/// uninitialized variable.
+///
+/// This is a cheap, conservative check over the variables declared in the
+/// context: a variable with an initializer that does not refer to the
+/// variable itself can only be used uninitialized if a jump bypasses its
+/// declaration.
+///
+/// \param mayBypassDecls Whether the body contains a switch or goto that could
+/// jump over the declaration of a variable.
+bool mayHaveUninitializedUses(const DeclContext &dc, bool mayBypassDecls);
+
 }
 #endif
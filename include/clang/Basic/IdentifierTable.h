@@ -19,6 +19,7 @@
 #include "clang/Basic/OperatorKinds.h"
 #include "clang/Basic/TokenKinds.h"
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/PointerLikeTypeTraits.h"
@@ -426,6 +427,10 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// \brief If non-null, the identifiers added to the table are appended to
+  /// this list.
+  SmallVectorImpl<IdentifierInfo *> *NewIdentifiers;
+
 public:
   /// \brief Create the identifier table, populating it with info about the
   /// language keywords for the language specified by \p LangOpts.
@@ -446,6 +451,15 @@ public:
     return HashTable.getAllocator();
   }
 
+  /// \brief Append the identifiers added to the table from now on to
+  /// \p List, or stop doing so if \p List is null.
+  ///
+  /// This lets clients that index the identifiers keep up with the table
+  /// without walking all of it again.
+  void setNewIdentifierList(SmallVectorImpl<IdentifierInfo *> *List) {
+    NewIdentifiers = List;
+  }
+
   /// \brief Return the identifier token info for the specified named
   /// identifier.
   IdentifierInfo &get(StringRef Name) {
@@ -474,6 +488,8 @@ public:
     // contents.
     II->Entry = &Entry;
 
+    if (NewIdentifiers)
+      NewIdentifiers->push_back(II);
     return *II;
   }
 
@@ -509,6 +525,9 @@ public:
       // If this is the 'import' contextual keyword, mark it as such.
       if (Name.equals("import"))
         II->setModulesImport(true);
+
+      if (NewIdentifiers)
+        NewIdentifiers->push_back(II);
     }
 
     return *II;
@@ -11,9 +11,14 @@
 #define LLVM_CLANG_CODEGEN_BACKEND_UTIL_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
 
 namespace llvm {
+  class Function;
+  class FunctionPassManager;
   class Module;
+  class TargetMachine;
 }
 
 namespace clang {
@@ -31,10 +36,46 @@ namespace clang {
     Backend_EmitObj        ///< Emit native object files
   };
   
+  /// FunctionOptimizer - Runs the per-function optimizations of the backend
+  /// on each function of a module as soon as it has been generated, rather
+  /// than when the whole module is handed to EmitBackendOutput.
+  ///
+  /// This parses the backend options, which EmitBackendOutput then does not
+  /// do again.
+  class FunctionOptimizer {
+    OwningPtr<llvm::TargetMachine> TM;
+    OwningPtr<llvm::FunctionPassManager> Passes;
+    llvm::SmallPtrSet<const llvm::Function *, 16> Optimized;
+    bool Initialized;
+
+  public:
+    FunctionOptimizer(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
+                      const TargetOptions &TOpts, const LangOptions &LOpts,
+                      llvm::Module *M);
+    ~FunctionOptimizer();
+
+    /// optimize - Run the per-function optimizations on \p F, unless they
+    /// have already been run on it.
+    void optimize(llvm::Function *F);
+
+    /// isOptimized - Whether the per-function optimizations have been run on
+    /// \p F.
+    bool isOptimized(const llvm::Function *F) const {
+      return Optimized.count(F);
+    }
+
+    /// finish - Finish optimizing; no function can be optimized afterwards.
+    void finish();
+  };
+
+  /// EmitBackendOutput - Optimize \p M and emit it as requested by
+  /// \p Action. If \p Optimizer is given, the functions it has optimized are
+  /// not run through the per-function optimizations again.
   void EmitBackendOutput(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
                          const TargetOptions &TOpts, const LangOptions &LOpts,
                          llvm::Module *M,
-                         BackendAction Action, raw_ostream *OS);
+                         BackendAction Action, raw_ostream *OS,
+                         const FunctionOptimizer *Optimizer = 0);
 }
 
 #endif
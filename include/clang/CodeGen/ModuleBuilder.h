@@ -26,12 +26,17 @@ namespace clang {
   class DiagnosticsEngine;
   class LangOptions;
   class CodeGenOptions;
+  class FunctionOptimizer;
 
   class CodeGenerator : public ASTConsumer {
     virtual void anchor();
   public:
     virtual llvm::Module* GetModule() = 0;
     virtual llvm::Module* ReleaseModule() = 0;
+
+    /// getFunctionOptimizer - Returns the optimizer that has already run the
+    /// per-function optimizations on some functions of the module, if any.
+    virtual const FunctionOptimizer *getFunctionOptimizer() = 0;
   };
 
   /// CreateLLVMCodeGen - Create a CodeGenerator instance.
@@ -137,6 +137,8 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned UseGlobalModuleIndex : 1;       ///< Whether we can use and build
+                                           /// the global module index.
 
   CodeCompleteOptions CodeCompleteOpts;
 
@@ -216,6 +218,7 @@ public:
     ARCMTAction = ARCMT_None;
     ARCMTMigrateEmitARCErrors = 0;
     SkipFunctionBodies = 0;
+    UseGlobalModuleIndex = 1;
     ObjCMTAction = ObjCMT_None;
   }
 
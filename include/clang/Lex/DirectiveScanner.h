@@ -0,0 +1,97 @@
+//===--- DirectiveScanner.h - Find lines without directives -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the DirectiveScanCache class and the
+// scanSkippableRanges() function, which together allow the lexer to skip over
+// the lines of a source file that cannot contain preprocessor directives when
+// only the directives matter, e.g., when scanning for dependencies.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_DIRECTIVESCANNER_H
+#define LLVM_CLANG_LEX_DIRECTIVESCANNER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include <vector>
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace clang {
+
+class LangOptions;
+
+/// \brief A range of a source buffer that contains no preprocessor directives.
+///
+/// The range begins at the first token (or comment) of a line and ends at the
+/// first token of the next line that needs to be lexed, or at the end of the
+/// buffer. A lexer that only cares about directives can jump from the
+/// beginning of the range to its end.
+struct SkippableRange {
+  /// \brief The offset of the beginning of the range within the buffer.
+  unsigned Begin;
+
+  /// \brief The offset just past the end of the range.
+  unsigned End;
+
+  /// \brief Whether the range contains any tokens, as opposed to only
+  /// whitespace and comments.
+  bool HasTokens;
+};
+
+typedef std::vector<SkippableRange> SkippableRangeList;
+
+/// \brief Scan the given buffer for the ranges of lines that contain no
+/// preprocessor directives.
+///
+/// Lines whose interpretation the scanner cannot be certain of (e.g., lines
+/// that use \c _Pragma or continue with an escaped newline) are never part of
+/// a skippable range, so that the lexer sees them as usual.
+///
+/// \returns false if the buffer cannot be scanned reliably under the given
+/// language options, in which case the entire buffer must be lexed.
+bool scanSkippableRanges(StringRef Buffer, const LangOptions &LangOpts,
+                         SkippableRangeList &Ranges);
+
+/// \brief A cache of the skippable ranges of source buffers, so that each
+/// header is only scanned once no matter how many times it is included.
+///
+/// The cache is keyed by the buffer itself: the SourceManager keeps a single
+/// buffer per file for its whole lifetime, so every inclusion of a file sees
+/// the same buffer. A cache must only be used with one set of language
+/// options.
+class DirectiveScanCache {
+  /// \brief The skippable ranges of each buffer scanned so far, or null if
+  /// the buffer cannot be scanned.
+  llvm::DenseMap<const llvm::MemoryBuffer *, SkippableRangeList *> Entries;
+
+  DirectiveScanCache(const DirectiveScanCache &) LLVM_DELETED_FUNCTION;
+  void operator=(const DirectiveScanCache &) LLVM_DELETED_FUNCTION;
+
+public:
+  DirectiveScanCache() { }
+  ~DirectiveScanCache();
+
+  /// \brief Retrieve the skippable ranges of the given buffer, scanning it if
+  /// it has not been scanned before.
+  ///
+  /// \returns the skippable ranges, or null if the buffer cannot be scanned
+  /// reliably.
+  const SkippableRangeList *getSkippableRanges(const llvm::MemoryBuffer *Buffer,
+                                               const LangOptions &LangOpts);
+};
+
+} // end namespace clang
+
+#endif
@@ -15,6 +15,7 @@
 #define LLVM_CLANG_LEXER_H
 
 #include "clang/Lex/PreprocessorLexer.h"
+#include "clang/Lex/DirectiveScanner.h"
 #include "clang/Basic/LangOptions.h"
 #include "llvm/ADT/SmallVector.h"
 #include <string>
@@ -83,6 +84,16 @@ class Lexer : public PreprocessorLexer {
   // CurrentConflictMarkerState - The kind of conflict marker we are handling.
   ConflictMarkerKind CurrentConflictMarkerState;
 
+  // SkippableRanges - If non-null, the ranges of the buffer that contain no
+  // preprocessor directives, which the lexer jumps over when it reaches them
+  // at the start of a line.  This is used when only the directives of a file
+  // are of interest, e.g., when scanning for dependencies.
+  const SkippableRangeList *SkippableRanges;
+
+  // NextSkippableRange - The index of the first range in SkippableRanges that
+  // does not begin before BufferPtr.
+  unsigned NextSkippableRange;
+
   Lexer(const Lexer &) LLVM_DELETED_FUNCTION;
   void operator=(const Lexer &) LLVM_DELETED_FUNCTION;
   friend class Preprocessor;
@@ -196,6 +207,15 @@ public:
 
   const char *getBufferStart() const { return BufferStart; }
 
+  /// \brief Provide the ranges of the buffer that contain no preprocessor
+  /// directives, which the lexer will skip over rather than lexing them.
+  ///
+  /// The ranges must be sorted and must outlive the lexer.
+  void setSkippableRanges(const SkippableRangeList *Ranges) {
+    SkippableRanges = Ranges;
+    NextSkippableRange = 0;
+  }
+
   /// ReadToEndOfLine - Read the rest of the current preprocessor line as an
   /// uninterpreted string.  This switches the lexer out of directive mode.
   void ReadToEndOfLine(SmallVectorImpl<char> *Result = 0);
@@ -102,6 +102,10 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   ///  a token cache rather than lexing the original source file.
   OwningPtr<PTHManager> PTH;
 
+  /// \brief The ranges of each source file that contain no directives, which
+  /// are skipped in fast dependency scanning mode.
+  OwningPtr<DirectiveScanCache> DirectiveCache;
+
   /// BP - A BumpPtrAllocator object used to quickly allocate and release
   ///  objects internal to the Preprocessor.
   llvm::BumpPtrAllocator BP;
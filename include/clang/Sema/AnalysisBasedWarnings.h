@@ -60,6 +60,10 @@ private:
   /// built.
   unsigned NumFunctionsWithBadCFGs;
 
+  /// \brief Number of functions for which no CFG was built, because none of
+  /// the enabled analyses could find anything in them.
+  unsigned NumFunctionsSkipped;
+
   /// \brief Total number of blocks across all CFGs.
   unsigned NumCFGBlocks;
 
@@ -84,6 +88,46 @@ private:
   /// a single function.
   unsigned MaxUninitAnalysisBlockVisitsPerFunction;
 
+  /// \brief Total number of functions checked for thread safety.
+  unsigned NumThreadSafetyFunctions;
+
+  /// \brief Total number of lockset joins during thread safety analysis.
+  unsigned NumThreadSafetyJoins;
+
+  /// \brief Number of those joins which were of a lockset with itself.
+  unsigned NumThreadSafetyTrivialJoins;
+
+  /// \brief Number of those joins which were answered from the join cache.
+  unsigned NumThreadSafetyCachedJoins;
+
+  /// \brief Total number of distinct locksets built by thread safety
+  /// analysis.
+  unsigned NumThreadSafetyLocksets;
+
+  /// \brief Total number of distinct mutex expressions seen by thread safety
+  /// analysis.
+  unsigned NumThreadSafetyMutexes;
+
+  /// \brief Time spent building CFGs, in seconds.
+  double CFGBuildTime;
+
+  /// \brief Time spent checking for missing returns, in seconds.
+  double FallThroughTime;
+
+  /// \brief Time spent checking for unreachable code, in seconds.
+  double UnreachableTime;
+
+  /// \brief Time spent in the thread safety analysis, in seconds.
+  double ThreadSafetyTime;
+
+  /// \brief Part of ThreadSafetyTime spent computing local variable contexts
+  /// and locksets, respectively, in seconds.
+  double ThreadSafetyContextTime;
+  double ThreadSafetyLocksetTime;
+
+  /// \brief Time spent in the uninitialized values analysis, in seconds.
+  double UninitTime;
+
   /// @}
 
 public:
@@ -819,6 +819,40 @@ inline bool operator>=(const CodeCompletionResult &X,
 raw_ostream &operator<<(raw_ostream &OS,
                               const CodeCompletionString &CCS);
 
+/// \brief A code-completion result that matches the filter text, along with
+/// the information used to rank it against the other matching results.
+struct RankedCodeCompletionResult {
+  /// \brief How well the name of the result matches the filter text, as
+  /// computed by \c getCodeCompletionFilterQuality().
+  unsigned Quality;
+
+  /// \brief The priority of the result.
+  unsigned Priority;
+
+  /// \brief The length of the name of the result.
+  unsigned Length;
+
+  /// \brief The index of the result in the results being filtered.
+  unsigned Index;
+};
+
+/// \brief Determine how well the name of a code-completion result matches
+/// the filter text.
+///
+/// \returns zero if the name does not match at all; otherwise, a larger
+/// value indicates a better match.
+unsigned getCodeCompletionFilterQuality(StringRef Name, StringRef Filter);
+
+/// \brief Rank the given matching results by the quality of the match, then
+/// by priority, then shorter names first.
+///
+/// \returns the number of results kept, which is at most \p MaxResults
+/// unless it is zero. The kept results are moved to the front of \p Ranked
+/// in rank order.
+unsigned rankCodeCompletionResults(
+                       SmallVectorImpl<RankedCodeCompletionResult> &Ranked,
+                       unsigned MaxResults);
+
 /// \brief Abstract interface for a consumer of code-completion
 /// information.
 class CodeCompleteConsumer {
@@ -922,6 +956,30 @@ public:
     return CodeCompleteOpts.IncludeBriefComments;
   }
 
+  /// \brief Retrieve the options that control code completion.
+  const CodeCompleteOptions &getCodeCompleteOpts() const {
+    return CodeCompleteOpts;
+  }
+
+  /// \brief Whether the code-completion consumer wants only some of the
+  /// results, as determined by the filter text and result limit.
+  bool hasResultFilter() const {
+    return !CodeCompleteOpts.Filter.empty() || CodeCompleteOpts.MaxResults;
+  }
+
+  /// \brief Filter and rank the given code-completion results, so that only
+  /// the results the consumer wants are turned into code-completion strings.
+  ///
+  /// Results whose typed text does not match the filter text are dropped.
+  /// The remaining results are ranked by the quality of the match and then by
+  /// priority, and only the best \c MaxResults of them are kept.
+  ///
+  /// \returns the number of results kept, which are moved to the front of
+  /// \p Results in rank order. If there is no result filter, the results are
+  /// left untouched.
+  unsigned filterResults(CodeCompletionResult *Results,
+                         unsigned NumResults) const;
+
   /// \brief Determine whether the output of this consumer is binary.
   bool isOutputBinary() const { return OutputIsBinary; }
 
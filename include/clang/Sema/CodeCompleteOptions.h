@@ -10,6 +10,8 @@
 #ifndef LLVM_CLANG_SEMA_CODECOMPLETEOPTIONS_H
 #define LLVM_CLANG_SEMA_CODECOMPLETEOPTIONS_H
 
+#include <string>
+
 /// Options controlling the behavior of code completion.
 class CodeCompleteOptions {
 public:
@@ -25,11 +27,20 @@ public:
   ///< Show brief documentation comments in code completion results.
   unsigned IncludeBriefComments : 1;
 
+  ///< The maximum number of code completion results to show, keeping the
+  ///< best-ranked ones; zero means no limit.
+  unsigned MaxResults;
+
+  ///< Only show code completion results whose typed text matches this text,
+  ///< either as a prefix or as a subsequence; empty means no filtering.
+  std::string Filter;
+
   CodeCompleteOptions() :
       IncludeMacros(0),
       IncludeCodePatterns(0),
       IncludeGlobals(1),
-      IncludeBriefComments(0)
+      IncludeBriefComments(0),
+      MaxResults(0)
   { }
 };
 
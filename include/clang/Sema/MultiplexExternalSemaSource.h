@@ -231,6 +231,16 @@ public:
                  llvm::DenseMap<const CXXRecordDecl *, CharUnits> &BaseOffsets,
           llvm::DenseMap<const CXXRecordDecl *, CharUnits> &VirtualBaseOffsets);
 
+  /// \brief Retrieve the layout of the given record that was computed when
+  /// the external source was built.
+  virtual const ASTRecordLayout *
+  getStoredRecordLayout(const RecordDecl *Record);
+
+  /// \brief Load the vtable related information of the given class that was
+  /// computed when the external source was built.
+  virtual bool loadStoredVTableInformation(const CXXRecordDecl *Record,
+                                           VTableContext &VTContext);
+
   /// Return the amount of memory used by memory buffers, breaking down
   /// by heap-backed versus mmap'ed memory.
   virtual void getMemoryBufferSizes(MemoryBufferSizes &sizes) const;
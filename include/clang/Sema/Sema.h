@@ -154,6 +154,7 @@ namespace clang {
   class TypedefDecl;
   class TypedefNameDecl;
   class TypeLoc;
+  class TypoNameIndex;
   class UnqualifiedId;
   class UnresolvedLookupExpr;
   class UnresolvedMemberExpr;
@@ -473,17 +474,8 @@ public:
     Sema::ContextRAII SavedContext;
     
   public:
-    SynthesizedFunctionScope(Sema &S, DeclContext *DC)
-      : S(S), SavedContext(S, DC) 
-    {
-      S.PushFunctionScope();
-      S.PushExpressionEvaluationContext(Sema::PotentiallyEvaluated);
-    }
-    
-    ~SynthesizedFunctionScope() {
-      S.PopExpressionEvaluationContext();
-      S.PopFunctionScopeInfo();
-    }
+    SynthesizedFunctionScope(Sema &S, DeclContext *DC);
+    ~SynthesizedFunctionScope();
   };
 
   /// WeakUndeclaredIdentifiers - Identifiers contained in
@@ -5858,6 +5850,17 @@ public:
   /// string represents a keyword.
   UnqualifiedTyposCorrectedMap UnqualifiedTyposCorrected;
 
+  /// \brief Whether CorrectTypo has computed the edit distance to every
+  /// identifier in the translation unit once already.
+  bool ScannedIdentifiersForTypos;
+
+  /// \brief An index of the identifiers in the translation unit, built by
+  /// CorrectTypo when it has to look for similar names more than once.
+  OwningPtr<TypoNameIndex> TypoNames;
+
+  /// \brief The time spent in CorrectTypo, in seconds.
+  double TypoCorrectionTime;
+
   /// \brief Worker object for performing CFG-based warnings.
   sema::AnalysisBasedWarnings AnalysisWarnings;
 
@@ -35,7 +35,7 @@ namespace clang {
     /// Version 4 of AST files also requires that the version control branch and
     /// revision match exactly, since there is no backward compatibility of
     /// AST files at this time.
-    const unsigned VERSION_MAJOR = 4;
+    const unsigned VERSION_MAJOR = 6;
 
     /// \brief AST file minor version number supported by this version of
     /// Clang.
@@ -515,7 +515,15 @@ namespace clang {
 
       /// \brief Record of updates for a macro that was modified after
       /// being deserialized.
-      MACRO_UPDATES = 48
+      MACRO_UPDATES = 48,
+
+      /// \brief Record code for the offsets of the DECL_RECORD_LAYOUT
+      /// records, as (declaration ID, offset) pairs.
+      RECORD_LAYOUT_OFFSETS = 49,
+
+      /// \brief Record code for the offsets of the DECL_VTABLE_LAYOUT
+      /// records, as (declaration ID, offset) pairs.
+      VTABLE_LAYOUT_OFFSETS = 50
     };
 
     /// \brief Record types used within a source manager block.
@@ -1000,7 +1008,12 @@ namespace clang {
       /// function specialization. (Microsoft extension).
       DECL_CLASS_SCOPE_FUNCTION_SPECIALIZATION,
       /// \brief An ImportDecl recording a module import.
-      DECL_IMPORT
+      DECL_IMPORT,
+      /// \brief A record containing the layout of a RecordDecl.
+      DECL_RECORD_LAYOUT,
+      /// \brief A record containing the vtable layout and the vtable indices
+      /// of the virtual methods of a dynamic CXXRecordDecl.
+      DECL_VTABLE_LAYOUT
     };
 
     /// \brief Record codes for each kind of statement or expression.
@@ -68,6 +68,7 @@ class NestedNameSpecifier;
 class CXXBaseSpecifier;
 class CXXConstructorDecl;
 class CXXCtorInitializer;
+class GlobalModuleIndex;
 class GotoStmt;
 class MacroDefinition;
 class NamedDecl;
@@ -291,6 +292,17 @@ private:
   /// \brief The module manager which manages modules and their dependencies
   ModuleManager ModuleMgr;
 
+  /// \brief The global module index, if loaded.
+  llvm::OwningPtr<GlobalModuleIndex> GlobalIndex;
+
+  /// \brief Whether we have already tried (and possibly failed) to load the
+  /// global module index from the module cache.
+  bool TriedLoadingGlobalIndex;
+
+  /// \brief Whether to consult the global module index for identifier
+  /// lookups.
+  bool UseGlobalIndex;
+
   /// \brief A map of global bit offsets to the module that stores entities
   /// at those bit offsets.
   ContinuousRangeMap<uint64_t, ModuleFile*, 4> GlobalBitOffsetsMap;
@@ -340,6 +352,17 @@ private:
   /// in the chain.
   DeclUpdateOffsetsMap DeclUpdateOffsets;
 
+  typedef llvm::DenseMap<serialization::DeclID, FileOffset>
+      RecordLayoutOffsetsMap;
+
+  /// \brief The location of the stored layout of each record definition,
+  /// which is only read when the layout is needed.
+  RecordLayoutOffsetsMap RecordLayoutOffsets;
+
+  /// \brief The location of the stored vtable layout of each dynamic class,
+  /// which is only read when the class's vtable information is needed.
+  RecordLayoutOffsetsMap VTableLayoutOffsets;
+
   struct ReplacedDeclInfo {
     ModuleFile *Mod;
     uint64_t Offset;
@@ -761,6 +784,12 @@ private:
   /// Number of CXX base specifiers currently loaded
   unsigned NumCXXBaseSpecifiersLoaded;
 
+  /// \brief The number of record layouts read from the chain.
+  unsigned NumRecordLayoutsRead;
+
+  /// \brief The number of vtable layouts read from the chain.
+  unsigned NumVTableLayoutsRead;
+
   /// \brief An IdentifierInfo that has been loaded but whose top-level
   /// declarations of the same name have not (yet) been loaded.
   struct PendingIdentifierInfo {
@@ -1065,9 +1094,14 @@ public:
   /// \param AllowASTWithCompilerErrors If true, the AST reader will accept an
   /// AST file the was created out of an AST with compiler errors,
   /// otherwise it will reject it.
+  ///
+  /// \param UseGlobalIndex If true, the AST reader will consult the global
+  /// module index in the module cache (if there is one) to avoid searching
+  /// module files that cannot contain a given identifier.
   ASTReader(Preprocessor &PP, ASTContext &Context, StringRef isysroot = "",
             bool DisableValidation = false,
-            bool AllowASTWithCompilerErrors = false);
+            bool AllowASTWithCompilerErrors = false,
+            bool UseGlobalIndex = true);
 
   ~ASTReader();
 
@@ -1404,7 +1438,7 @@ public:
   /// \brief Notify ASTReader that we started deserialization of
   /// a decl or type so until FinishedDeserializing is called there may be
   /// decls that are initializing. Must be paired with FinishedDeserializing.
-  virtual void StartedDeserializing() { ++NumCurrentElementsDeserializing; }
+  virtual void StartedDeserializing();
 
   /// \brief Notify ASTReader that we finished the deserialization of
   /// a decl or type. Must be paired with StartedDeserializing.
@@ -1427,6 +1461,16 @@ public:
   /// by heap-backed versus mmap'ed memory.
   virtual void getMemoryBufferSizes(MemoryBufferSizes &sizes) const;
 
+  /// \brief Read the layout of the given record, if the AST file that
+  /// defines it stored one.
+  virtual const ASTRecordLayout *
+  getStoredRecordLayout(const RecordDecl *Record);
+
+  /// \brief Load the vtable information of the given dynamic class into
+  /// \p VTContext, if the AST file that defines the class stored it.
+  virtual bool loadStoredVTableInformation(const CXXRecordDecl *Record,
+                                           VTableContext &VTContext);
+
   /// \brief Initialize the semantic source with the Sema instance
   /// being used to perform semantic analysis on the abstract syntax
   /// tree.
@@ -1694,6 +1738,19 @@ public:
   /// \brief Note that this identifier is up-to-date.
   void markIdentifierUpToDate(IdentifierInfo *II);
 
+  /// \brief Attempts to load the global module index from the module cache.
+  ///
+  /// \returns true if the global module index is not available, false
+  /// otherwise.
+  bool loadGlobalIndex();
+
+  /// \brief Discard the global module index, e.g., because it has been
+  /// rewritten after a module was built. It will be reloaded on demand.
+  void resetGlobalIndex();
+
+  /// \brief Retrieve the global module index, if it has been loaded.
+  GlobalModuleIndex *getGlobalIndex() { return GlobalIndex.get(); }
+
   /// \brief Load all external visible decls in the given DeclContext.
   void completeVisibleDeclsMap(const DeclContext *DC);
 
@@ -45,6 +45,7 @@ class ASTContext;
 class NestedNameSpecifier;
 class CXXBaseSpecifier;
 class CXXCtorInitializer;
+class CXXRecordDecl;
 class FileEntry;
 class FPOptions;
 class HeaderSearch;
@@ -63,6 +64,7 @@ class SourceManager;
 class SwitchCase;
 class TargetInfo;
 class VersionTuple;
+class VTableContext;
 
 namespace SrcMgr { class SLocEntry; }
 
@@ -400,6 +402,18 @@ private:
   /// in the order they should be written.
   SmallVector<QueuedCXXBaseSpecifiers, 2> CXXBaseSpecifiersToWrite;
 
+  /// \brief The record definitions written to the AST file, in order. Their
+  /// layouts are written once all declarations have been written.
+  SmallVector<RecordDecl *, 16> RecordsToLayout;
+
+  /// \brief The (declaration ID, offset) pair of each DECL_RECORD_LAYOUT
+  /// record.
+  RecordData RecordLayoutOffsets;
+
+  /// \brief The (declaration ID, offset) pair of each DECL_VTABLE_LAYOUT
+  /// record.
+  RecordData VTableLayoutOffsets;
+
   /// \brief A mapping from each known submodule to its ID number, which will
   /// be a positive integer.
   llvm::DenseMap<Module *, unsigned> SubmoduleIDs;
@@ -426,6 +440,8 @@ private:
                                         
   void WritePragmaDiagnosticMappings(const DiagnosticsEngine &Diag);
   void WriteCXXBaseSpecifiersOffsets();
+  void WriteVTableLayout(VTableContext &VTContext, const CXXRecordDecl *RD);
+  void WriteRecordLayouts(ASTContext &Context, VTableContext *VTContext);
   void WriteType(QualType T);
   uint64_t WriteDeclContextLexicalBlock(ASTContext &Context, DeclContext *DC);
   uint64_t WriteDeclContextVisibleBlock(ASTContext &Context, DeclContext *DC);
@@ -193,6 +193,21 @@ private:
   /// \sa getGraphTrimInterval
   llvm::Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldShareReportGraph
+  llvm::Optional<bool> ShareReportGraph;
+
+  /// \sa shouldUseCompactRangeSets
+  llvm::Optional<bool> UseCompactRangeSets;
+
+  /// \sa shouldRemoveDeadSymbolsIncrementally
+  llvm::Optional<bool> RemoveDeadSymbolsIncrementally;
+
+  /// \sa getMaxTranslationUnitTime
+  llvm::Optional<unsigned> MaxTranslationUnitTime;
+
+  /// \sa getMaxTranslationUnitSteps
+  llvm::Optional<unsigned> MaxTranslationUnitSteps;
+
   /// Interprets an option's string value as a boolean.
   ///
   /// Accepts the strings "true" and "false".
@@ -276,6 +291,53 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns whether the bug reporter should trim the ExplodedGraph once for
+  /// all the reports of a function, and find the paths of all of them with a
+  /// single shortest-path search, rather than trimming the graph again for
+  /// each report.
+  ///
+  /// When several paths to a report are equally short, the path chosen may
+  /// differ from the one chosen without this option.
+  ///
+  /// This is controlled by the 'shared-report-graph' config option, which
+  /// accepts the values "true" and "false".
+  bool shouldShareReportGraph();
+
+  /// Returns whether the range constraint manager should store the ranges of
+  /// each symbol in a uniqued, sorted array, and memoize their intersections,
+  /// rather than keeping them in an immutable tree.
+  ///
+  /// This is controlled by the 'compact-range-sets' config option, which
+  /// accepts the values "true" and "false".
+  bool shouldUseCompactRangeSets();
+
+  /// Returns whether the analyzer should reuse the result of removing dead
+  /// bindings and symbols from a state when the same state is cleaned up
+  /// again at a statement where the same expressions and variables are live.
+  ///
+  /// This is controlled by the 'incremental-dead-symbols' config option,
+  /// which accepts the values "true" and "false".
+  bool shouldRemoveDeadSymbolsIncrementally();
+
+  /// Returns the wall-clock time, in seconds, which the path-sensitive
+  /// analysis of a translation unit may take, or 0 if it is not limited.
+  ///
+  /// When the translation unit has a time or step budget, the most central
+  /// functions of the call graph are analyzed first, inlining becomes
+  /// shallower as the budget runs out, and the functions which are left when
+  /// it is exhausted are reported and skipped.
+  ///
+  /// This is controlled by the 'max-tu-time' config option.
+  unsigned getMaxTranslationUnitTime();
+
+  /// Returns the number of work list steps which the path-sensitive analysis
+  /// of a translation unit may take, or 0 if it is not limited.
+  ///
+  /// \sa getMaxTranslationUnitTime
+  ///
+  /// This is controlled by the 'max-tu-steps' config option.
+  unsigned getMaxTranslationUnitSteps();
+
 public:
   AnalyzerOptions() : CXXMemberInliningMode() {
     AnalysisStoreOpt = RegionStoreModel;
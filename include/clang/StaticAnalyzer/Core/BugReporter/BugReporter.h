@@ -23,6 +23,7 @@
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallSet.h"
 
@@ -43,6 +44,7 @@ class BugReporter;
 class BugReporterContext;
 class ExprEngine;
 class BugType;
+class TrimmedReportGraph;
 
 //===----------------------------------------------------------------------===//
 // Interface for individual bug reports.
@@ -402,6 +404,13 @@ protected:
   BugReporter(BugReporterData& d, Kind k) : BugTypes(F.getEmptySet()), kind(k),
                                             D(d) {}
 
+  /// \brief Called by FlushReports() with the error nodes of all the reports,
+  /// before any of them is flushed.
+  virtual void willFlushReports(ArrayRef<const ExplodedNode *> ErrorNodes) {}
+
+  /// \brief Called by FlushReports() after all the reports were flushed.
+  virtual void didFlushReports() {}
+
 public:
   BugReporter(BugReporterData& d) : BugTypes(F.getEmptySet()), kind(BaseBRKind),
                                     D(d) {}
@@ -485,9 +494,17 @@ private:
 // FIXME: Get rid of GRBugReporter.  It's the wrong abstraction.
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
+
+  /// The graph of the paths to all the reports being flushed, when it is
+  /// shared between them.  \sa AnalyzerOptions::shouldShareReportGraph
+  OwningPtr<TrimmedReportGraph> ReportGraph;
+
+protected:
+  virtual void willFlushReports(ArrayRef<const ExplodedNode *> ErrorNodes);
+  virtual void didFlushReports();
+
 public:
-  GRBugReporter(BugReporterData& d, ExprEngine& eng)
-    : BugReporter(d, GRBugReporterKind), Eng(eng) {}
+  GRBugReporter(BugReporterData& d, ExprEngine& eng);
 
   virtual ~GRBugReporter();
 
@@ -30,6 +30,10 @@ void createHTMLDiagnosticConsumer(PathDiagnosticConsumers &C,
                                   const std::string& prefix,
                                   const Preprocessor &PP);
 
+void createJSONLinesDiagnosticConsumer(PathDiagnosticConsumers &C,
+                                       const std::string& prefix,
+                                       const Preprocessor &PP);
+
 void createPlistDiagnosticConsumer(PathDiagnosticConsumers &C,
                                    const std::string& prefix,
                                    const Preprocessor &PP);
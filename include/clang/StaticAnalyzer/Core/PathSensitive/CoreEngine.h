@@ -84,6 +84,9 @@ private:
   /// (This data is owned by AnalysisConsumer.)
   FunctionSummariesTy *FunctionSummaries;
 
+  /// The number of work list items processed so far.
+  unsigned NumStepsTaken;
+
   void generateNode(const ProgramPoint &Loc,
                     ProgramStateRef State,
                     ExplodedNode *Pred);
@@ -109,7 +112,7 @@ public:
     : SubEng(subengine), G(new ExplodedGraph()),
       WList(WorkList::makeDFS()),
       BCounterFactory(G->getAllocator()),
-      FunctionSummaries(FS){}
+      FunctionSummaries(FS), NumStepsTaken(0) {}
 
   /// getGraph - Returns the exploded graph.
   ExplodedGraph& getGraph() { return *G.get(); }
@@ -128,6 +131,9 @@ public:
                                        ProgramStateRef InitState, 
                                        ExplodedNodeSet &Dst);
 
+  /// Returns the number of work list items processed so far.
+  unsigned getNumSteps() const { return NumStepsTaken; }
+
   /// Dispatch the work list item based on the given location information.
   /// Use Pred parameter as the predecessor state.
   void dispatchWorkItem(ExplodedNode* Pred, ProgramPoint Loc,
@@ -25,6 +25,7 @@
 #include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/Type.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace clang {
 
@@ -83,6 +84,21 @@ class ExprEngine : public SubEngine {
   /// Whether or not GC is enabled in this analysis.
   bool ObjCGCEnabled;
 
+  /// Whether removeDead may reuse the result of an earlier cleanup.
+  /// \sa AnalyzerOptions::shouldRemoveDeadSymbolsIncrementally
+  bool IncrementalRemoveDead;
+
+  /// A state, a stack frame, and the liveness class of a statement in it.
+  typedef std::pair<const ProgramState *,
+                    std::pair<const StackFrameContext *, unsigned> >
+    RemoveDeadKey;
+
+  /// The cleanups which found no dead symbols, keyed by the state they
+  /// started from. Each entry also keeps its key state alive, so that the
+  /// key is not reused by another state.
+  llvm::DenseMap<RemoveDeadKey, std::pair<ProgramStateRef, ProgramStateRef> >
+    RemoveDeadCache;
+
   /// The BugReporter associated with this engine.  It is important that
   ///  this object be placed at the very end of member variables so that its
   ///  destructor is called before the rest of the ExprEngine is destroyed.
@@ -220,6 +220,60 @@ void APValue::swap(APValue &RHS) {
   memcpy(RHS.Data, TmpData, MaxSize);
 }
 
+/// \brief Determine whether \p LHS and \p RHS are the same integer or
+/// floating-point value.
+static bool isSameScalar(const APValue &LHS, const APValue &RHS) {
+  if (LHS.getKind() != RHS.getKind())
+    return false;
+  if (LHS.isInt())
+    return LHS.getInt().getBitWidth() == RHS.getInt().getBitWidth() &&
+           LHS.getInt().isSigned() == RHS.getInt().isSigned() &&
+           LHS.getInt() == RHS.getInt();
+  if (LHS.isFloat())
+    return LHS.getFloat().bitwiseIsEqual(RHS.getFloat());
+  return false;
+}
+
+void APValue::compactArray() {
+  unsigned InitElts = getArrayInitializedElts();
+  if (!InitElts)
+    return;
+
+  APValue &Filler = hasArrayFiller() ? getArrayFiller()
+                                     : getArrayInitializedElt(InitElts - 1);
+  unsigned NewInitElts = InitElts;
+  while (NewInitElts &&
+         isSameScalar(getArrayInitializedElt(NewInitElts - 1), Filler))
+    --NewInitElts;
+
+  // Without a filler, the first element of the run becomes the filler, so
+  // this only saves space if the run has at least two elements.
+  if (NewInitElts == InitElts ||
+      (!hasArrayFiller() && NewInitElts + 1 == InitElts))
+    return;
+
+  APValue Result(UninitArray(), NewInitElts, getArraySize());
+  for (unsigned I = 0; I != NewInitElts; ++I)
+    Result.getArrayInitializedElt(I).swap(getArrayInitializedElt(I));
+  Result.getArrayFiller().swap(Filler);
+  swap(Result);
+}
+
+void ConstexprCallResult::Profile(llvm::FoldingSetNodeID &ID,
+                                  const FunctionDecl *Callee,
+                                  ArrayRef<APValue> Args) {
+  ID.AddPointer(Callee);
+  for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+    ID.AddInteger(Args[I].getKind());
+    if (Args[I].isInt())
+      Args[I].getInt().Profile(ID);
+    else {
+      assert(Args[I].isFloat() && "can only profile scalar arguments");
+      Args[I].getFloat().Profile(ID);
+    }
+  }
+}
+
 void APValue::dump() const {
   dump(llvm::errs());
   llvm::errs() << '\n';
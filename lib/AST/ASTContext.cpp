@@ -623,7 +623,8 @@ ASTContext::ASTContext(LangOptions& LOpts, SourceManager &SM,
     cudaConfigureCallDecl(0),
     NullTypeSourceInfo(QualType()), 
     FirstLocalImport(), LastLocalImport(),
-    SourceMgr(SM), LangOpts(LOpts), 
+    SourceMgr(SM), LangOpts(LOpts), SeparateBodyAllocation(false),
+    NumReleasedBodies(0), ReleasedBodyMemory(0),
     AddrSpaceMap(0), Target(t), PrintingPolicy(LOpts),
     Idents(idents), Selectors(sels),
     BuiltinInfo(builtins),
@@ -672,6 +673,92 @@ ASTContext::~ASTContext() {
                                                     AEnd = DeclAttrs.end();
        A != AEnd; ++A)
     A->second->~AttrVec();
+
+  for (llvm::FoldingSet<ConstexprCallResult>::iterator
+         I = ConstexprCallResults.begin(), E = ConstexprCallResults.end();
+       I != E; )
+    // Increment in loop to prevent using deallocated memory.
+    delete &*I++;
+
+  for (llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>::iterator
+         I = BodyAllocators.begin(), E = BodyAllocators.end(); I != E; ++I)
+    delete I->second;
+}
+
+void ASTContext::startFunctionBody(const FunctionDecl *FD) {
+  if (!SeparateBodyAllocation)
+    return;
+
+  // The bodies of inline, constexpr and template functions are never
+  // released, so don't give each of them a slab of its own. Neither are the
+  // bodies of functions without external linkage: their generation is
+  // deferred to the end of the translation unit.
+  if (FD->isInlined() || FD->isConstexpr() || FD->isDependentContext() ||
+      FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate ||
+      FD->getLinkage() != ExternalLinkage) {
+    BodyAllocatorStack.push_back(BodyAllocatorEntry(FD, 0));
+    return;
+  }
+
+  llvm::BumpPtrAllocator *&Allocator = BodyAllocators[FD];
+  if (!Allocator)
+    Allocator = new llvm::BumpPtrAllocator();
+  BodyAllocatorStack.push_back(BodyAllocatorEntry(FD, Allocator));
+}
+
+void ASTContext::finishFunctionBody(const FunctionDecl *FD) {
+  // Lambda call operators are finished without being started.
+  if (!BodyAllocatorStack.empty() && BodyAllocatorStack.back().first == FD)
+    BodyAllocatorStack.pop_back();
+}
+
+void ASTContext::startSharedStatements() {
+  if (SeparateBodyAllocation)
+    BodyAllocatorStack.push_back(BodyAllocatorEntry(0, 0));
+}
+
+void ASTContext::finishSharedStatements() {
+  if (!SeparateBodyAllocation)
+    return;
+
+  for (unsigned I = BodyAllocatorStack.size(); I != 0; --I) {
+    if (!BodyAllocatorStack[I - 1].first) {
+      BodyAllocatorStack.erase(BodyAllocatorStack.begin() + I - 1);
+      return;
+    }
+  }
+}
+
+void ASTContext::releaseFunctionBody(FunctionDecl *FD) {
+  Stmt *Body = FD->getBody();
+  if (!Body)
+    return;
+
+  // Keep the function defined.
+  FD->setBody(new (*this) CompoundStmt(*this, 0, 0, Body->getLocStart(),
+                                       Body->getLocEnd()));
+
+  // The initializers of a constructor are built along with its body.
+  if (CXXConstructorDecl *Ctor = dyn_cast<CXXConstructorDecl>(FD)) {
+    Ctor->setNumCtorInitializers(0);
+    Ctor->setCtorInitializers(0);
+  }
+
+  llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>::iterator
+    Pos = BodyAllocators.find(FD);
+  if (Pos == BodyAllocators.end())
+    return;
+
+  // If Sema never finished the body, statements of other functions may have
+  // been allocated with it.
+  for (unsigned I = 0, N = BodyAllocatorStack.size(); I != N; ++I)
+    if (BodyAllocatorStack[I].second == Pos->second)
+      return;
+
+  ++NumReleasedBodies;
+  ReleasedBodyMemory += Pos->second->getTotalMemory();
+  delete Pos->second;
+  BodyAllocators.erase(Pos);
 }
 
 void ASTContext::AddDeallocation(void (*Callback)(void*), void *Data) {
@@ -734,6 +821,14 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (getLangOpts().CPlusPlus0x)
+    llvm::errs() << ConstexprCallResults.size()
+                 << " constexpr call results memoized\n";
+
+  if (SeparateBodyAllocation)
+    llvm::errs() << NumReleasedBodies << " function bodies released ("
+                 << ReleasedBodyMemory << " bytes)\n";
+
   if (ExternalSource.get()) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -7571,6 +7666,31 @@ unsigned ASTContext::getLambdaManglingNumber(CXXMethodDecl *CallOperator) {
            .getManglingNumber(CallOperator);
 }
 
+const ConstexprCallResult *
+ASTContext::getConstexprCallResult(const FunctionDecl *Callee,
+                                   ArrayRef<APValue> Args) const {
+  llvm::FoldingSetNodeID ID;
+  ConstexprCallResult::Profile(ID, Callee, Args);
+  void *InsertPos = 0;
+  return ConstexprCallResults.FindNodeOrInsertPos(ID, InsertPos);
+}
+
+void ASTContext::setConstexprCallResult(const FunctionDecl *Callee,
+                                        ArrayRef<APValue> Args,
+                                        const APValue &Result,
+                                        unsigned Depth) const {
+  llvm::FoldingSetNodeID ID;
+  ConstexprCallResult::Profile(ID, Callee, Args);
+  void *InsertPos = 0;
+  if (ConstexprCallResult *Existing =
+        ConstexprCallResults.FindNodeOrInsertPos(ID, InsertPos)) {
+    // Keep the entry that needs the shallowest call stack.
+    Existing->Depth = std::min(Existing->Depth, Depth);
+    return;
+  }
+  ConstexprCallResults.InsertNode(
+    new ConstexprCallResult(Callee, Args, Result, Depth), InsertPos);
+}
 
 void ASTContext::setParameterIndex(const ParmVarDecl *D, unsigned int index) {
   ParamIndices[D] = index;
@@ -421,7 +421,7 @@ DeclRefExpr *DeclRefExpr::Create(ASTContext &Context,
   else if (TemplateKWLoc.isValid())
     Size += ASTTemplateKWAndArgsInfo::sizeFor(0);
 
-  void *Mem = Context.Allocate(Size, llvm::alignOf<DeclRefExpr>());
+  void *Mem = Context.AllocateStmt(Size, llvm::alignOf<DeclRefExpr>());
   return new (Mem) DeclRefExpr(Context, QualifierLoc, TemplateKWLoc, D,
                                RefersToEnclosingLocal,
                                NameInfo, FoundD, TemplateArgs, T, VK);
@@ -1001,7 +1001,8 @@ CallExpr::CallExpr(ASTContext& C, StmtClass SC, Expr *fn, unsigned NumPreArgs,
          fn->containsUnexpandedParameterPack()),
     NumArgs(args.size()) {
 
-  SubExprs = new (C) Stmt*[args.size()+PREARGS_START+NumPreArgs];
+  SubExprs = static_cast<Stmt **>(C.AllocateStmt(
+      sizeof(Stmt *) * (args.size() + PREARGS_START + NumPreArgs)));
   SubExprs[FN] = fn;
   for (unsigned i = 0; i != args.size(); ++i) {
     if (args[i]->isTypeDependent())
@@ -1029,7 +1030,8 @@ CallExpr::CallExpr(ASTContext& C, Expr *fn, ArrayRef<Expr*> args,
          fn->containsUnexpandedParameterPack()),
     NumArgs(args.size()) {
 
-  SubExprs = new (C) Stmt*[args.size()+PREARGS_START];
+  SubExprs = static_cast<Stmt **>(C.AllocateStmt(
+      sizeof(Stmt *) * (args.size() + PREARGS_START)));
   SubExprs[FN] = fn;
   for (unsigned i = 0; i != args.size(); ++i) {
     if (args[i]->isTypeDependent())
@@ -1268,7 +1270,7 @@ MemberExpr *MemberExpr::Create(ASTContext &C, Expr *base, bool isarrow,
   else if (TemplateKWLoc.isValid())
     Size += ASTTemplateKWAndArgsInfo::sizeFor(0);
 
-  void *Mem = C.Allocate(Size, llvm::alignOf<MemberExpr>());
+  void *Mem = C.AllocateStmt(Size, llvm::alignOf<MemberExpr>());
   MemberExpr *E = new (Mem) MemberExpr(base, isarrow, memberdecl, nameinfo,
                                        ty, vk, ok);
 
@@ -1604,8 +1606,8 @@ ImplicitCastExpr *ImplicitCastExpr::Create(ASTContext &C, QualType T,
                                            const CXXCastPath *BasePath,
                                            ExprValueKind VK) {
   unsigned PathSize = (BasePath ? BasePath->size() : 0);
-  void *Buffer =
-    C.Allocate(sizeof(ImplicitCastExpr) + PathSize * sizeof(CXXBaseSpecifier*));
+  void *Buffer = C.AllocateStmt(sizeof(ImplicitCastExpr) +
+                                PathSize * sizeof(CXXBaseSpecifier*));
   ImplicitCastExpr *E =
     new (Buffer) ImplicitCastExpr(T, Kind, Operand, PathSize, VK);
   if (PathSize) E->setCastPath(*BasePath);
@@ -1626,8 +1628,8 @@ CStyleCastExpr *CStyleCastExpr::Create(ASTContext &C, QualType T,
                                        TypeSourceInfo *WrittenTy,
                                        SourceLocation L, SourceLocation R) {
   unsigned PathSize = (BasePath ? BasePath->size() : 0);
-  void *Buffer =
-    C.Allocate(sizeof(CStyleCastExpr) + PathSize * sizeof(CXXBaseSpecifier*));
+  void *Buffer = C.AllocateStmt(sizeof(CStyleCastExpr) +
+                                PathSize * sizeof(CXXBaseSpecifier*));
   CStyleCastExpr *E =
     new (Buffer) CStyleCastExpr(T, VK, K, Op, PathSize, WrittenTy, L, R);
   if (PathSize) E->setCastPath(*BasePath);
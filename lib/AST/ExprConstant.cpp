@@ -363,6 +363,10 @@ namespace {
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
+    /// MaxCallStackDepth - The largest number of calls in the call stack since
+    /// this was last reset. Used to find the depth a memoized call needs.
+    unsigned MaxCallStackDepth;
+
     /// BottomFrame - The frame in which evaluation started. This must be
     /// initialized after CurrentCall and CallStackDepth.
     CallStackFrame BottomFrame;
@@ -384,12 +388,17 @@ namespace {
     /// are suppressed.
     bool CheckingPotentialConstantExpression;
 
+    /// NumDiagsRequested - The number of diagnostics the evaluation asked for,
+    /// whether or not they were stored. If this does not change while a call
+    /// is evaluated, the call is a constant expression.
+    unsigned NumDiagsRequested;
+
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S)
       : Ctx(const_cast<ASTContext&>(C)), EvalStatus(S), CurrentCall(0),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), NextCallIndex(1), MaxCallStackDepth(0),
         BottomFrame(*this, SourceLocation(), 0, 0, 0),
         EvaluatingDecl(0), EvaluatingDeclValue(0), HasActiveDiagnostic(false),
-        CheckingPotentialConstantExpression(false) {}
+        CheckingPotentialConstantExpression(false), NumDiagsRequested(0) {}
 
     void setEvaluatingDecl(const VarDecl *VD, APValue &Value) {
       EvaluatingDecl = VD;
@@ -441,6 +450,7 @@ namespace {
     OptionalDiagnostic Diag(SourceLocation Loc, diag::kind DiagId
                               = diag::note_invalid_subexpr_in_const_expr,
                             unsigned ExtraNotes = 0) {
+      ++NumDiagsRequested;
       // If we have a prior diagnostic, it will be noting that the expression
       // isn't a constant expression. This diagnostic is more important.
       // FIXME: We might want to show both diagnostics to the user.
@@ -469,6 +479,7 @@ namespace {
                             unsigned ExtraNotes = 0) {
       if (EvalStatus.Diag)
         return Diag(E->getExprLoc(), DiagId, ExtraNotes);
+      ++NumDiagsRequested;
       HasActiveDiagnostic = false;
       return OptionalDiagnostic();
     }
@@ -479,6 +490,7 @@ namespace {
     OptionalDiagnostic CCEDiag(LocArg Loc, diag::kind DiagId
                                  = diag::note_invalid_subexpr_in_const_expr,
                                unsigned ExtraNotes = 0) {
+      ++NumDiagsRequested;
       // Don't override a previous diagnostic.
       if (!EvalStatus.Diag || !EvalStatus.Diag->empty()) {
         HasActiveDiagnostic = false;
@@ -577,6 +589,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Index(Info.NextCallIndex++), This(This), Arguments(Arguments) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                    Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -2143,6 +2157,58 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+/// Determine whether the result of a call with the given arguments can be
+/// memoized. We only memoize calls to non-member functions whose arguments
+/// are integers and floating-point values, so that the result cannot depend
+/// on any object which the caller can see.
+static bool isMemoizableCall(EvalInfo &Info, const LValue *This,
+                             ArrayRef<APValue> Args) {
+  if (This || Info.CheckingPotentialConstantExpression)
+    return false;
+  for (unsigned I = 0, N = Args.size(); I != N; ++I)
+    if (!Args[I].isInt() && !Args[I].isFloat())
+      return false;
+  return true;
+}
+
+/// Determine whether the value V contains no lvalues, and so means the same
+/// thing in any evaluation.
+static bool isSelfContainedValue(const APValue &V) {
+  switch (V.getKind()) {
+  case APValue::Int:
+  case APValue::Float:
+  case APValue::ComplexInt:
+  case APValue::ComplexFloat:
+    return true;
+  case APValue::Vector:
+    for (unsigned I = 0, N = V.getVectorLength(); I != N; ++I)
+      if (!isSelfContainedValue(V.getVectorElt(I)))
+        return false;
+    return true;
+  case APValue::Array:
+    for (unsigned I = 0, N = V.getArrayInitializedElts(); I != N; ++I)
+      if (!isSelfContainedValue(V.getArrayInitializedElt(I)))
+        return false;
+    return !V.hasArrayFiller() || isSelfContainedValue(V.getArrayFiller());
+  case APValue::Struct:
+    for (unsigned I = 0, N = V.getStructNumBases(); I != N; ++I)
+      if (!isSelfContainedValue(V.getStructBase(I)))
+        return false;
+    for (unsigned I = 0, N = V.getStructNumFields(); I != N; ++I)
+      if (!isSelfContainedValue(V.getStructField(I)))
+        return false;
+    return true;
+  case APValue::Union:
+    return !V.getUnionField() || isSelfContainedValue(V.getUnionValue());
+  case APValue::Uninitialized:
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -2155,8 +2221,39 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
-  CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
-  return EvaluateStmt(Result, Info, Body) == ESR_Returned;
+  bool Memoize = isMemoizableCall(Info, This, ArgValues);
+  if (Memoize) {
+    // Reuse a previous result, unless evaluating the call from here would
+    // have exceeded the depth limit.
+    if (const ConstexprCallResult *Memo =
+          Info.Ctx.getConstexprCallResult(Callee, ArgValues)) {
+      unsigned Depth = Info.CallStackDepth + Memo->Depth;
+      if (Depth <= Info.getLangOpts().ConstexprCallDepth + 1) {
+        Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth, Depth);
+        Result = Memo->Result;
+        return true;
+      }
+    }
+    Memoize = !Info.EvalStatus.HasSideEffects;
+  }
+
+  unsigned OldNumDiagsRequested = Info.NumDiagsRequested;
+  unsigned OldMaxCallStackDepth = Info.MaxCallStackDepth;
+  Info.MaxCallStackDepth = 0;
+  bool Success;
+  {
+    CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
+    Success = EvaluateStmt(Result, Info, Body) == ESR_Returned;
+  }
+  unsigned Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(OldMaxCallStackDepth,
+                                    Info.MaxCallStackDepth);
+
+  // Only remember calls which are constant expressions, not merely foldable.
+  if (Success && Memoize && Info.NumDiagsRequested == OldNumDiagsRequested &&
+      !Info.EvalStatus.HasSideEffects && isSelfContainedValue(Result))
+    Info.Ctx.setConstexprCallResult(Callee, ArgValues, Result, Depth);
+  return Success;
 }
 
 /// Evaluate a constructor call.
@@ -3829,14 +3926,19 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
     }
   }
 
-  if (!Result.hasArrayFiller()) return Success;
-  assert(E->hasArrayFiller() && "no array filler for incomplete init list");
-  // FIXME: The Subobject here isn't necessarily right. This rarely matters,
-  // but sometimes does:
-  //   struct S { constexpr S() : p(&p) {} void *p; };
-  //   S s[10] = {};
-  return EvaluateInPlace(Result.getArrayFiller(), Info,
-                         Subobject, E->getArrayFiller()) && Success;
+  if (Result.hasArrayFiller()) {
+    assert(E->hasArrayFiller() && "no array filler for incomplete init list");
+    // FIXME: The Subobject here isn't necessarily right. This rarely matters,
+    // but sometimes does:
+    //   struct S { constexpr S() : p(&p) {} void *p; };
+    //   S s[10] = {};
+    Success = EvaluateInPlace(Result.getArrayFiller(), Info,
+                              Subobject, E->getArrayFiller()) && Success;
+  }
+
+  if (Success)
+    Result.compactArray();
+  return Success;
 }
 
 bool ArrayExprEvaluator::VisitCXXConstructExpr(const CXXConstructExpr *E) {
@@ -59,4 +59,15 @@ ExternalASTSource::FindExternalLexicalDecls(const DeclContext *DC,
   return ELR_AlreadyLoaded;
 }
 
+const ASTRecordLayout *
+ExternalASTSource::getStoredRecordLayout(const RecordDecl *Record) {
+  return 0;
+}
+
+bool
+ExternalASTSource::loadStoredVTableInformation(const CXXRecordDecl *Record,
+                                               VTableContext &VTContext) {
+  return false;
+}
+
 void ExternalASTSource::getMemoryBufferSizes(MemoryBufferSizes &sizes) const { }
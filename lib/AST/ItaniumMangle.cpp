@@ -94,7 +94,25 @@ class ItaniumMangleContext : public MangleContext {
   llvm::DenseMap<const TagDecl *, uint64_t> AnonStructIds;
   unsigned Discriminator;
   llvm::DenseMap<const NamedDecl*, unsigned> Uniquifier;
-  
+
+public:
+  /// \brief The mangling of a prefix that was mangled with an empty
+  /// substitution table, together with the substitution candidates it
+  /// added, in order.
+  struct PrefixMangling {
+    std::string Mangling;
+    SmallVector<uintptr_t, 8> Substitutions;
+  };
+
+private:
+  /// \brief The prefixes mangled so far in this translation unit.
+  ///
+  /// Template-heavy code mangles many names that share a long prefix, such
+  /// as the members of a class template specialization nested in several
+  /// namespaces. The mangling of the prefix only depends on the substitutions
+  /// made before it, so when it comes first it can be reused as-is.
+  llvm::DenseMap<const DeclContext *, PrefixMangling> PrefixManglings;
+
 public:
   explicit ItaniumMangleContext(ASTContext &Context,
                                 DiagnosticsEngine &Diags)
@@ -107,6 +125,16 @@ public:
     return Result.first->second;
   }
 
+  const PrefixMangling *getPrefixMangling(const DeclContext *DC) const {
+    llvm::DenseMap<const DeclContext *, PrefixMangling>::const_iterator I
+      = PrefixManglings.find(DC);
+    return I == PrefixManglings.end() ? 0 : &I->second;
+  }
+
+  PrefixMangling &getOrCreatePrefixMangling(const DeclContext *DC) {
+    return PrefixManglings[DC];
+  }
+
   void startNewFunction() {
     MangleContext::startNewFunction();
     mangleInitDiscriminator();
@@ -238,6 +266,12 @@ public:
                  const CXXDestructorDecl *D, CXXDtorType Type)
     : Context(C), Out(Out_), Structor(getStructor(D)), StructorType(Type),
       SeqID(0) { }
+  /// \brief Create a mangler that writes part of the name being mangled by
+  /// \p Outer to a separate stream, starting with no substitutions.
+  CXXNameMangler(CXXNameMangler &Outer, raw_ostream &Out_)
+    : Context(Outer.Context), Out(Out_), Structor(Outer.Structor),
+      StructorType(Outer.StructorType), SeqID(0),
+      FunctionTypeDepth(Outer.FunctionTypeDepth) { }
 
 #if MANGLE_CHECKER
   ~CXXNameMangler() {
@@ -311,6 +345,8 @@ private:
                         unsigned NumTemplateArgs);
   void manglePrefix(NestedNameSpecifier *qualifier);
   void manglePrefix(const DeclContext *DC, bool NoFunction=false);
+  void mangleUncachedPrefix(const DeclContext *DC, bool NoFunction);
+  bool isCacheablePrefix(const DeclContext *DC) const;
   void manglePrefix(QualType type);
   void mangleTemplatePrefix(const TemplateDecl *ND);
   void mangleTemplatePrefix(TemplateName Template);
@@ -1388,7 +1424,69 @@ void CXXNameMangler::manglePrefix(NestedNameSpecifier *qualifier) {
   llvm_unreachable("unexpected nested name specifier");
 }
 
+/// \brief Whether the mangling of \p DC as a prefix can be reused by later
+/// manglings that start with it.
+///
+/// This is the case for non-dependent contexts made of namespaces and
+/// classes only; the manglings of local entities, blocks and lambdas depend
+/// on the function being mangled.
+bool CXXNameMangler::isCacheablePrefix(const DeclContext *DC) const {
+  if (DC->isDependentContext())
+    return false;
+
+  for (; !DC->isTranslationUnit();
+       DC = IgnoreLinkageSpecDecls(getEffectiveParentContext(DC))) {
+    if (isa<NamespaceDecl>(DC))
+      continue;
+    const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(DC);
+    if (!RD || RD->isLambda())
+      return false;
+  }
+  return true;
+}
+
 void CXXNameMangler::manglePrefix(const DeclContext *DC, bool NoFunction) {
+  DC = IgnoreLinkageSpecDecls(DC);
+
+  // The mangling of a prefix that comes first in the substitution table does
+  // not depend on anything else in the name, so reuse it if we have seen it
+  // before.
+  if (SeqID != 0 || NoFunction || DC->isTranslationUnit() ||
+      !isCacheablePrefix(DC)) {
+    mangleUncachedPrefix(DC, NoFunction);
+    return;
+  }
+
+  if (const ItaniumMangleContext::PrefixMangling *Cached
+        = Context.getPrefixMangling(DC)) {
+    Out << Cached->Mangling;
+    for (unsigned I = 0, N = Cached->Substitutions.size(); I != N; ++I)
+      addSubstitution(Cached->Substitutions[I]);
+    return;
+  }
+
+  SmallString<128> Buffer;
+  llvm::raw_svector_ostream Stream(Buffer);
+  CXXNameMangler PrefixMangler(*this, Stream);
+  PrefixMangler.mangleUncachedPrefix(DC, NoFunction);
+  Stream.flush();
+
+  ItaniumMangleContext::PrefixMangling &Entry
+    = Context.getOrCreatePrefixMangling(DC);
+  Entry.Mangling = Buffer.str();
+  Entry.Substitutions.resize(PrefixMangler.SeqID);
+  for (llvm::DenseMap<uintptr_t, unsigned>::const_iterator
+         I = PrefixMangler.Substitutions.begin(),
+         E = PrefixMangler.Substitutions.end(); I != E; ++I)
+    Entry.Substitutions[I->second] = I->first;
+
+  Out << Entry.Mangling;
+  for (unsigned I = 0, N = Entry.Substitutions.size(); I != N; ++I)
+    addSubstitution(Entry.Substitutions[I]);
+}
+
+void CXXNameMangler::mangleUncachedPrefix(const DeclContext *DC,
+                                          bool NoFunction) {
   //  <prefix> ::= <prefix> <unqualified-name>
   //           ::= <template-prefix> <template-args>
   //           ::= <template-param>
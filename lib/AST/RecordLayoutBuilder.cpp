@@ -2422,9 +2422,16 @@ ASTContext::getASTRecordLayout(const RecordDecl *D) const {
   const ASTRecordLayout *Entry = ASTRecordLayouts[D];
   if (Entry) return *Entry;
 
-  const ASTRecordLayout *NewEntry;
+  const ASTRecordLayout *NewEntry = 0;
 
-  if (const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
+  // Records from an AST file may have been laid out when it was built.
+  if (D->isFromASTFile())
+    if (ExternalASTSource *External = getExternalSource())
+      NewEntry = External->getStoredRecordLayout(D);
+
+  if (NewEntry) {
+    // The stored layout is complete.
+  } else if (const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
     EmptySubobjectMap EmptySubobjects(*this, RD);
     RecordLayoutBuilder Builder(*this, &EmptySubobjects);
     Builder.Layout(RD);
@@ -46,6 +46,11 @@ static StmtClassNameTable &getStmtInfoTableEntry(Stmt::StmtClass E) {
   return StmtClassInfo[E];
 }
 
+void *Stmt::operator new(size_t bytes, ASTContext &C,
+                          unsigned alignment) throw() {
+  return C.AllocateStmt(bytes, alignment);
+}
+
 const char *Stmt::getStmtClassName() const {
   return getStmtInfoTableEntry((StmtClass) StmtBits.sClass).Name;
 }
@@ -257,7 +262,7 @@ CompoundStmt::CompoundStmt(ASTContext &C, Stmt **StmtStart, unsigned NumStmts,
     return;
   }
 
-  Body = new (C) Stmt*[NumStmts];
+  Body = static_cast<Stmt **>(C.AllocateStmt(NumStmts * sizeof(Stmt *)));
   memcpy(Body, StmtStart, NumStmts * sizeof(*Body));
 }
 
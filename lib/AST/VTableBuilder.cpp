@@ -14,6 +14,7 @@
 #include "clang/AST/VTableBuilder.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/CXXInheritance.h"
+#include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/Basic/TargetInfo.h"
 #include "llvm/Support/Format.h"
@@ -2187,8 +2188,21 @@ CollectPrimaryBases(const CXXRecordDecl *RD, ASTContext &Context,
     llvm_unreachable("Found a duplicate primary base!");
 }
 
+bool VTableContext::LoadStoredVTableInformation(const CXXRecordDecl *RD) {
+  if (!RD->isFromASTFile())
+    return false;
+
+  ExternalASTSource *Source = Context.getExternalSource();
+  if (!Source || !StoredInfoLookups.insert(RD))
+    return false;
+
+  return Source->loadStoredVTableInformation(RD, *this);
+}
+
 void VTableContext::ComputeMethodVTableIndices(const CXXRecordDecl *RD) {
-  
+  if (LoadStoredVTableInformation(RD))
+    return;
+
   // Itanium C++ ABI 2.5.2:
   //   The order of the virtual function pointers in a virtual table is the 
   //   order of declaration of the corresponding member functions in the class.
@@ -2326,6 +2340,12 @@ VTableContext::getVirtualBaseOffsetOffset(const CXXRecordDecl *RD,
     VirtualBaseClassOffsetOffsets.find(ClassPair);
   if (I != VirtualBaseClassOffsetOffsets.end())
     return I->second;
+
+  if (LoadStoredVTableInformation(RD)) {
+    I = VirtualBaseClassOffsetOffsets.find(ClassPair);
+    assert(I != VirtualBaseClassOffsetOffsets.end() && "Did not find index!");
+    return I->second;
+  }
   
   VCallAndVBaseOffsetBuilder Builder(RD, RD, /*FinalOverriders=*/0,
                                      BaseSubobject(RD, CharUnits::Zero()),
@@ -2361,12 +2381,14 @@ static VTableLayout *CreateVTableLayout(const VTableBuilder &Builder) {
 }
 
 void VTableContext::ComputeVTableRelatedInformation(const CXXRecordDecl *RD) {
-  const VTableLayout *&Entry = VTableLayouts[RD];
-
   // Check if we've computed this information before.
-  if (Entry)
+  if (VTableLayouts.lookup(RD))
+    return;
+
+  if (LoadStoredVTableInformation(RD))
     return;
 
+  const VTableLayout *&Entry = VTableLayouts[RD];
   VTableBuilder Builder(*this, RD, CharUnits::Zero(), 
                         /*MostDerivedClassIsVirtual=*/0, RD);
   Entry = CreateVTableLayout(Builder);
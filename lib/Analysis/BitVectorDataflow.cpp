@@ -0,0 +1,51 @@
+//===- BitVectorDataflow.cpp - Dense bit-vector dataflow solver -*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the non-template parts of BitVectorDataflow.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/BitVectorDataflow.h"
+
+using namespace clang;
+
+BitVectorDataflow::BitVectorDataflow(const CFG &cfg, const FlatCFGView &View,
+                                     Direction Dir)
+  : cfg(cfg), View(View), Dir(Dir),
+    EntryValues(View.size()), ExitValues(View.size()),
+    Analyzed(View.size()), NumBlockVisits(0) {}
+
+/// \brief Union \p Src into \p Dst, treating missing bits as zero.
+static void mergeValues(llvm::BitVector &Dst, const llvm::BitVector &Src) {
+  if (Dst.size() < Src.size())
+    Dst.resize(Src.size());
+  Dst |= Src;
+}
+
+void BitVectorDataflow::computeInValues(unsigned Index,
+                                        llvm::BitVector &Vals) {
+  Vals.reset();
+  const CFGBlock *BoundaryBlock = isForward() ? &cfg.getEntry()
+                                              : &cfg.getExit();
+  if (Index == View.getIndex(BoundaryBlock))
+    mergeValues(Vals, Boundary);
+
+  // Blocks that have not been analyzed yet contribute nothing.
+  if (isForward()) {
+    for (FlatCFGView::edge_iterator I = View.pred_begin(Index),
+         E = View.pred_end(Index); I != E; ++I)
+      if (*I != FlatCFGView::InvalidIndex)
+        mergeValues(Vals, ExitValues[*I]);
+  } else {
+    for (FlatCFGView::edge_iterator I = View.succ_begin(Index),
+         E = View.succ_end(Index); I != E; ++I)
+      if (*I != FlatCFGView::InvalidIndex)
+        mergeValues(Vals, EntryValues[*I]);
+  }
+}
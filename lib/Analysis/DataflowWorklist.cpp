@@ -0,0 +1,58 @@
+//===- DataflowWorklist.cpp - Worklist for dataflow analyses ----*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements DataflowWorklist.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/DataflowWorklist.h"
+#include <algorithm>
+#include <functional>
+
+using namespace clang;
+
+DataflowWorklist::DataflowWorklist(const FlatCFGView &View, Direction Dir)
+  : View(View), EnqueuedBlocks(View.size()), IsForward(Dir == Forward) {}
+
+void DataflowWorklist::enqueueBlock(unsigned Index) {
+  if (Index == FlatCFGView::InvalidIndex || EnqueuedBlocks[Index])
+    return;
+  EnqueuedBlocks[Index] = true;
+  Heap.push_back(Index);
+  // Reverse post-order is increasing index order.
+  if (IsForward)
+    std::push_heap(Heap.begin(), Heap.end(), std::greater<unsigned>());
+  else
+    std::push_heap(Heap.begin(), Heap.end(), std::less<unsigned>());
+}
+
+void DataflowWorklist::enqueueSuccessors(unsigned Index) {
+  for (FlatCFGView::edge_iterator I = View.succ_begin(Index),
+       E = View.succ_end(Index); I != E; ++I)
+    enqueueBlock(*I);
+}
+
+void DataflowWorklist::enqueuePredecessors(unsigned Index) {
+  for (FlatCFGView::edge_iterator I = View.pred_begin(Index),
+       E = View.pred_end(Index); I != E; ++I)
+    enqueueBlock(*I);
+}
+
+unsigned DataflowWorklist::dequeue() {
+  if (Heap.empty())
+    return FlatCFGView::InvalidIndex;
+  if (IsForward)
+    std::pop_heap(Heap.begin(), Heap.end(), std::greater<unsigned>());
+  else
+    std::pop_heap(Heap.begin(), Heap.end(), std::less<unsigned>());
+  unsigned Index = Heap.back();
+  Heap.pop_back();
+  EnqueuedBlocks[Index] = false;
+  return Index;
+}
@@ -0,0 +1,89 @@
+//===- FlatCFGView.cpp - Flattened, RPO-numbered layout of a CFG -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements FlatCFGView.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/FlatCFGView.h"
+#include "clang/Analysis/Analyses/PostOrderCFGView.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include <algorithm>
+
+using namespace clang;
+
+const unsigned FlatCFGView::InvalidIndex;
+
+void FlatCFGView::anchor() { }
+
+FlatCFGView::FlatCFGView(const CFG &cfg)
+  : BlockIndices(cfg.getNumBlockIDs(), InvalidIndex) {
+  typedef llvm::po_iterator<const CFG*, PostOrderCFGView::CFGBlockSet, true>
+    po_iterator;
+
+  // Number the reachable blocks in reverse post-order.
+  Blocks.reserve(cfg.getNumBlockIDs());
+  PostOrderCFGView::CFGBlockSet BSet(&cfg);
+  for (po_iterator I = po_iterator::begin(&cfg, BSet),
+                   E = po_iterator::end(&cfg, BSet); I != E; ++I)
+    Blocks.push_back(*I);
+  std::reverse(Blocks.begin(), Blocks.end());
+  NumReachableBlocks = Blocks.size();
+
+  // Then the rest.
+  for (CFG::const_iterator I = cfg.begin(), E = cfg.end(); I != E; ++I)
+    if (BSet.insert(*I))
+      Blocks.push_back(*I);
+
+  for (unsigned Index = 0, N = Blocks.size(); Index != N; ++Index)
+    BlockIndices[Blocks[Index]->getBlockID()] = Index;
+
+  // Lay out the elements and edges of each block after those of the previous
+  // one.
+  unsigned NumElements = 0, NumSuccs = 0, NumPreds = 0;
+  for (unsigned Index = 0, N = Blocks.size(); Index != N; ++Index) {
+    NumElements += Blocks[Index]->size();
+    NumSuccs += Blocks[Index]->succ_size();
+    NumPreds += Blocks[Index]->pred_size();
+  }
+  Elements.reserve(NumElements);
+  Succs.reserve(NumSuccs);
+  Preds.reserve(NumPreds);
+  ElementOffsets.reserve(Blocks.size() + 1);
+  SuccOffsets.reserve(Blocks.size() + 1);
+  PredOffsets.reserve(Blocks.size() + 1);
+
+  for (unsigned Index = 0, N = Blocks.size(); Index != N; ++Index) {
+    const CFGBlock *B = Blocks[Index];
+    ElementOffsets.push_back(Elements.size());
+    Elements.insert(Elements.end(), B->begin(), B->end());
+
+    SuccOffsets.push_back(Succs.size());
+    for (CFGBlock::const_succ_iterator SI = B->succ_begin(),
+         SE = B->succ_end(); SI != SE; ++SI)
+      Succs.push_back(*SI ? getIndex(*SI) : InvalidIndex);
+
+    PredOffsets.push_back(Preds.size());
+    for (CFGBlock::const_pred_iterator PI = B->pred_begin(),
+         PE = B->pred_end(); PI != PE; ++PI)
+      Preds.push_back(*PI ? getIndex(*PI) : InvalidIndex);
+  }
+  ElementOffsets.push_back(Elements.size());
+  SuccOffsets.push_back(Succs.size());
+  PredOffsets.push_back(Preds.size());
+}
+
+FlatCFGView *FlatCFGView::create(AnalysisDeclContext &ctx) {
+  const CFG *cfg = ctx.getCFG();
+  if (!cfg)
+    return 0;
+  return new FlatCFGView(*cfg);
+}
+
+const void *FlatCFGView::getTag() { static int x; return &x; }
@@ -1,116 +1,113 @@
 #include "clang/Analysis/Analyses/LiveVariables.h"
-#include "clang/Analysis/Analyses/PostOrderCFGView.h"
+#include "clang/Analysis/Analyses/BitVectorDataflow.h"
+#include "clang/Analysis/Analyses/FlatCFGView.h"
 
 #include "clang/AST/Stmt.h"
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/AnalysisContext.h"
 #include "clang/AST/StmtVisitor.h"
 
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
 
-#include <deque>
 #include <algorithm>
+#include <map>
 #include <vector>
 
 using namespace clang;
 
-namespace {
-
-class DataflowWorklist {
-  SmallVector<const CFGBlock *, 20> worklist;
-  llvm::BitVector enqueuedBlocks;
-  PostOrderCFGView *POV;
-public:
-  DataflowWorklist(const CFG &cfg, AnalysisDeclContext &Ctx)
-    : enqueuedBlocks(cfg.getNumBlockIDs()),
-      POV(Ctx.getAnalysis<PostOrderCFGView>()) {}
-  
-  void enqueueBlock(const CFGBlock *block);
-  void enqueueSuccessors(const CFGBlock *block);
-  void enqueuePredecessors(const CFGBlock *block);
-
-  const CFGBlock *dequeue();
-
-  void sortWorklist();
-};
+//===----------------------------------------------------------------------===//
+// Numbering of the values tracked by the analysis.
+//===----------------------------------------------------------------------===//
 
-}
+/// Variables are numbered when they are first seen. Block-level expressions
+/// are numbered in the same index space when they are first made live, so
+/// that the liveness of both is kept in one bit vector.
+class LiveVariables::ValueNumbering {
+  DataflowNumbering<const void *> values;
+  llvm::BitVector stmtIndices;
 
-void DataflowWorklist::enqueueBlock(const clang::CFGBlock *block) {
-  if (block && !enqueuedBlocks[block->getBlockID()]) {
-    enqueuedBlocks[block->getBlockID()] = true;
-    worklist.push_back(block);
-  }
-}
-  
-void DataflowWorklist::enqueueSuccessors(const clang::CFGBlock *block) {
-  const unsigned OldWorklistSize = worklist.size();
-  for (CFGBlock::const_succ_iterator I = block->succ_begin(),
-       E = block->succ_end(); I != E; ++I) {
-    enqueueBlock(*I);
+public:
+  unsigned getIndex(const VarDecl *D) {
+    return values.getOrAddIndex(D);
   }
 
-  if (OldWorklistSize == 0 || OldWorklistSize == worklist.size())
-    return;
-
-  sortWorklist();
-}
+  unsigned getIndex(const Stmt *S) {
+    unsigned Index = values.getOrAddIndex(S);
+    if (Index >= stmtIndices.size())
+      stmtIndices.resize(Index + 1);
+    stmtIndices.set(Index);
+    return Index;
+  }
 
-void DataflowWorklist::enqueuePredecessors(const clang::CFGBlock *block) {
-  const unsigned OldWorklistSize = worklist.size();
-  for (CFGBlock::const_pred_iterator I = block->pred_begin(),
-       E = block->pred_end(); I != E; ++I) {
-    enqueueBlock(*I);
+  llvm::Optional<unsigned> lookup(const void *V) const {
+    return values.getIndex(V);
   }
-  
-  if (OldWorklistSize == 0 || OldWorklistSize == worklist.size())
-    return;
 
-  sortWorklist();
-}
+  bool isStmt(unsigned Index) const {
+    return Index < stmtIndices.size() && stmtIndices.test(Index);
+  }
 
-void DataflowWorklist::sortWorklist() {
-  std::sort(worklist.begin(), worklist.end(), POV->getComparator());
-}
+  const VarDecl *getDecl(unsigned Index) const {
+    return static_cast<const VarDecl *>(values.getKey(Index));
+  }
 
-const CFGBlock *DataflowWorklist::dequeue() {
-  if (worklist.empty())
-    return 0;
-  const CFGBlock *b = worklist.back();
-  worklist.pop_back();
-  enqueuedBlocks[b->getBlockID()] = false;
-  return b;
-}
+  bool isLive(const llvm::BitVector &Bits, const void *V) const {
+    llvm::Optional<unsigned> Index = lookup(V);
+    return Index && *Index < Bits.size() && Bits.test(*Index);
+  }
+};
 
 namespace {
 class LiveVariablesImpl {
 public:  
   AnalysisDeclContext &analysisContext;
-  std::vector<LiveVariables::LivenessValues> cfgBlockValues;
-  llvm::ImmutableSet<const Stmt *>::Factory SSetFact;
-  llvm::ImmutableSet<const VarDecl *>::Factory DSetFact;
-  llvm::DenseMap<const CFGBlock *, LiveVariables::LivenessValues> blocksEndToLiveness;
-  llvm::DenseMap<const CFGBlock *, LiveVariables::LivenessValues> blocksBeginToLiveness;
-  llvm::DenseMap<const Stmt *, LiveVariables::LivenessValues> stmtsToLiveness;
+  const FlatCFGView &view;
+  LiveVariables::ValueNumbering numbering;
+  BitVectorDataflow dataflow;
   llvm::DenseMap<const DeclRefExpr *, unsigned> inAssignment;
   const bool killAtAssign;
+
+  /// The block containing each statement, for the statement-level queries.
+  llvm::DenseMap<const Stmt *, const CFGBlock *> stmtBlocks;
+
+  /// The block whose statement-level liveness was computed last, and the
+  /// liveness before each of its statements. Clients query the statements of
+  /// a block one after the other, so only one block is kept.
+  const CFGBlock *currentBlock;
+  llvm::DenseMap<const Stmt *, llvm::BitVector> currentBlockLiveness;
+
+  /// The liveness class of each statement queried so far, the profile of the
+  /// live values of each class, and the classes with each profile hash.
+  llvm::DenseMap<const Stmt *, unsigned> livenessClasses;
+  std::vector<llvm::FoldingSetNodeID> classProfiles;
+  std::map<unsigned, SmallVector<unsigned, 1> > classesByHash;
   
-  LiveVariables::LivenessValues
-  merge(LiveVariables::LivenessValues valsA,
-        LiveVariables::LivenessValues valsB);
-      
-  LiveVariables::LivenessValues runOnBlock(const CFGBlock *block,
-                                           LiveVariables::LivenessValues val,
-                                           LiveVariables::Observer *obs = 0);
+  void addLive(LiveVariables::LivenessValues &val, unsigned Index);
+  void addLiveDecl(LiveVariables::LivenessValues &val, const VarDecl *D);
+  void addLiveStmt(LiveVariables::LivenessValues &val, const Stmt *S);
+  void removeLive(LiveVariables::LivenessValues &val, const void *V);
+
+  /// Return the values live before the given statement, or null if the
+  /// statement is not in the CFG.
+  const llvm::BitVector *getStmtLiveness(const Stmt *S);
+
+  /// Apply the transfer function of a block to the liveness values at its
+  /// end, optionally recording the liveness before each statement in
+  /// \c currentBlockLiveness.
+  void runOnBlock(const CFGBlock *block, LiveVariables::LivenessValues &val,
+                  LiveVariables::Observer *obs, bool recordStmts);
+
+  /// The transfer function of a whole block, as applied by the solver.
+  void transferBlock(const CFGBlock *block, llvm::BitVector &bits);
 
   void dumpBlockLiveness(const SourceManager& M);
 
-  LiveVariablesImpl(AnalysisDeclContext &ac, bool KillAtAssign)
-    : analysisContext(ac),
-      SSetFact(false), // Do not canonicalize ImmutableSets by default.
-      DSetFact(false), // This is a *major* performance win.
-      killAtAssign(KillAtAssign) {}
+  LiveVariablesImpl(AnalysisDeclContext &ac, const CFG &cfg,
+                    const FlatCFGView &View, bool KillAtAssign)
+    : analysisContext(ac), view(View),
+      dataflow(cfg, View, DataflowWorklist::Backward),
+      killAtAssign(KillAtAssign), currentBlock(0) {}
 };
 }
 
@@ -123,53 +120,58 @@ static LiveVariablesImpl &getImpl(void *x) {
 //===----------------------------------------------------------------------===//
 
 bool LiveVariables::LivenessValues::isLive(const Stmt *S) const {
-  return liveStmts.contains(S);
+  return numbering && numbering->isLive(live, S);
 }
 
 bool LiveVariables::LivenessValues::isLive(const VarDecl *D) const {
-  return liveDecls.contains(D);
+  return numbering && numbering->isLive(live, D);
 }
 
-namespace {
-  template <typename SET>
-  SET mergeSets(SET A, SET B) {
-    if (A.isEmpty())
-      return B;
-    
-    for (typename SET::iterator it = B.begin(), ei = B.end(); it != ei; ++it) {
-      A = A.add(*it);
-    }
-    return A;
-  }
+void LiveVariables::Observer::anchor() { }
+
+bool LiveVariables::LivenessValues::equals(const LivenessValues &V) const {
+  return live == V.live;
 }
 
-void LiveVariables::Observer::anchor() { }
+void LiveVariablesImpl::addLive(LiveVariables::LivenessValues &val,
+                                unsigned Index) {
+  if (Index >= val.live.size())
+    val.live.resize(Index + 1);
+  val.live.set(Index);
+}
 
-LiveVariables::LivenessValues
-LiveVariablesImpl::merge(LiveVariables::LivenessValues valsA,
-                         LiveVariables::LivenessValues valsB) {  
-  
-  llvm::ImmutableSetRef<const Stmt *>
-    SSetRefA(valsA.liveStmts.getRootWithoutRetain(), SSetFact.getTreeFactory()),
-    SSetRefB(valsB.liveStmts.getRootWithoutRetain(), SSetFact.getTreeFactory());
-                                                
-  
-  llvm::ImmutableSetRef<const VarDecl *>
-    DSetRefA(valsA.liveDecls.getRootWithoutRetain(), DSetFact.getTreeFactory()),
-    DSetRefB(valsB.liveDecls.getRootWithoutRetain(), DSetFact.getTreeFactory());
-  
+void LiveVariablesImpl::addLiveDecl(LiveVariables::LivenessValues &val,
+                                    const VarDecl *D) {
+  addLive(val, numbering.getIndex(D));
+}
 
-  SSetRefA = mergeSets(SSetRefA, SSetRefB);
-  DSetRefA = mergeSets(DSetRefA, DSetRefB);
-  
-  // asImmutableSet() canonicalizes the tree, allowing us to do an easy
-  // comparison afterwards.
-  return LiveVariables::LivenessValues(SSetRefA.asImmutableSet(),
-                                       DSetRefA.asImmutableSet());  
+void LiveVariablesImpl::addLiveStmt(LiveVariables::LivenessValues &val,
+                                    const Stmt *S) {
+  addLive(val, numbering.getIndex(S));
 }
 
-bool LiveVariables::LivenessValues::equals(const LivenessValues &V) const {
-  return liveStmts == V.liveStmts && liveDecls == V.liveDecls;
+void LiveVariablesImpl::removeLive(LiveVariables::LivenessValues &val,
+                                   const void *V) {
+  llvm::Optional<unsigned> Index = numbering.lookup(V);
+  if (Index && *Index < val.live.size())
+    val.live.reset(*Index);
+}
+
+const llvm::BitVector *LiveVariablesImpl::getStmtLiveness(const Stmt *S) {
+  llvm::DenseMap<const Stmt *, const CFGBlock *>::iterator I =
+    stmtBlocks.find(S);
+  if (I == stmtBlocks.end())
+    return 0;
+
+  // Recompute the liveness within the block from the values at its end.
+  if (I->second != currentBlock) {
+    currentBlock = I->second;
+    currentBlockLiveness.clear();
+    LiveVariables::LivenessValues val(dataflow.getExitValues(currentBlock),
+                                      &numbering);
+    runOnBlock(currentBlock, val, 0, true);
+  }
+  return &currentBlockLiveness[S];
 }
 
 //===----------------------------------------------------------------------===//
@@ -181,15 +183,53 @@ static bool isAlwaysAlive(const VarDecl *D) {
 }
 
 bool LiveVariables::isLive(const CFGBlock *B, const VarDecl *D) {
-  return isAlwaysAlive(D) || getImpl(impl).blocksEndToLiveness[B].isLive(D);
+  LiveVariablesImpl &LV = getImpl(impl);
+  return isAlwaysAlive(D) ||
+         LV.numbering.isLive(LV.dataflow.getExitValues(B), D);
 }
 
 bool LiveVariables::isLive(const Stmt *S, const VarDecl *D) {
-  return isAlwaysAlive(D) || getImpl(impl).stmtsToLiveness[S].isLive(D);
+  if (isAlwaysAlive(D))
+    return true;
+  LiveVariablesImpl &LV = getImpl(impl);
+  const llvm::BitVector *Live = LV.getStmtLiveness(S);
+  return Live && LV.numbering.isLive(*Live, D);
 }
 
 bool LiveVariables::isLive(const Stmt *Loc, const Stmt *S) {
-  return getImpl(impl).stmtsToLiveness[Loc].isLive(S);
+  LiveVariablesImpl &LV = getImpl(impl);
+  const llvm::BitVector *Live = LV.getStmtLiveness(Loc);
+  return Live && LV.numbering.isLive(*Live, S);
+}
+
+unsigned LiveVariables::getLivenessClass(const Stmt *Loc) {
+  LiveVariablesImpl &LV = getImpl(impl);
+  llvm::DenseMap<const Stmt *, unsigned>::iterator Known =
+    LV.livenessClasses.find(Loc);
+  if (Known != LV.livenessClasses.end())
+    return Known->second;
+
+  // The live values are identified by their number, so equal values have
+  // equal profiles.
+  llvm::FoldingSetNodeID ID;
+  if (const llvm::BitVector *Live = LV.getStmtLiveness(Loc))
+    for (int I = Live->find_first(); I != -1; I = Live->find_next(I))
+      ID.AddInteger(I);
+
+  unsigned Class = LV.classProfiles.size();
+  SmallVectorImpl<unsigned> &Bucket = LV.classesByHash[ID.ComputeHash()];
+  for (unsigned i = 0, n = Bucket.size(); i != n; ++i)
+    if (LV.classProfiles[Bucket[i]] == ID) {
+      Class = Bucket[i];
+      break;
+    }
+
+  if (Class == LV.classProfiles.size()) {
+    LV.classProfiles.push_back(ID);
+    Bucket.push_back(Class);
+  }
+  LV.livenessClasses[Loc] = Class;
+  return Class;
 }
 
 //===----------------------------------------------------------------------===//
@@ -250,12 +290,6 @@ static const Stmt *LookThroughStmt(const Stmt *S) {
   return S;
 }
 
-static void AddLiveStmt(llvm::ImmutableSet<const Stmt *> &Set,
-                        llvm::ImmutableSet<const Stmt *>::Factory &F,
-                        const Stmt *S) {
-  Set = F.add(Set, LookThroughStmt(S));
-}
-
 void TransferFunctions::Visit(Stmt *S) {
   if (observer)
     observer->observeStmt(S, currentBlock, val);
@@ -263,7 +297,7 @@ void TransferFunctions::Visit(Stmt *S) {
   StmtVisitor<TransferFunctions>::Visit(S);
   
   if (isa<Expr>(S)) {
-    val.liveStmts = LV.SSetFact.remove(val.liveStmts, S);
+    LV.removeLive(val, S);
   }
 
   // Mark all children expressions live.
@@ -280,7 +314,7 @@ void TransferFunctions::Visit(Stmt *S) {
       // Include the implicit "this" pointer as being live.
       CXXMemberCallExpr *CE = cast<CXXMemberCallExpr>(S);
       if (Expr *ImplicitObj = CE->getImplicitObjectArgument()) {
-        AddLiveStmt(val.liveStmts, LV.SSetFact, ImplicitObj);
+        LV.addLiveStmt(val, LookThroughStmt(ImplicitObj));
       }
       break;
     }
@@ -288,8 +322,7 @@ void TransferFunctions::Visit(Stmt *S) {
       // In calls to super, include the implicit "self" pointer as being live.
       ObjCMessageExpr *CE = cast<ObjCMessageExpr>(S);
       if (CE->getReceiverKind() == ObjCMessageExpr::SuperInstance)
-        val.liveDecls = LV.DSetFact.add(val.liveDecls,
-                                        LV.analysisContext.getSelfDecl());
+        LV.addLiveDecl(val, LV.analysisContext.getSelfDecl());
       break;
     }
     case Stmt::DeclStmtClass: {
@@ -297,7 +330,7 @@ void TransferFunctions::Visit(Stmt *S) {
       if (const VarDecl *VD = dyn_cast<VarDecl>(DS->getSingleDecl())) {
         for (const VariableArrayType* VA = FindVA(VD->getType());
              VA != 0; VA = FindVA(VA->getElementType())) {
-          AddLiveStmt(val.liveStmts, LV.SSetFact, VA->getSizeExpr());
+          LV.addLiveStmt(val, LookThroughStmt(VA->getSizeExpr()));
         }
       }
       break;
@@ -310,7 +343,7 @@ void TransferFunctions::Visit(Stmt *S) {
       if (OpaqueValueExpr *OV = dyn_cast<OpaqueValueExpr>(child))
         child = OV->getSourceExpr();
       child = child->IgnoreParens();
-      val.liveStmts = LV.SSetFact.add(val.liveStmts, child);
+      LV.addLiveStmt(val, child);
       return;
     }
 
@@ -332,7 +365,7 @@ void TransferFunctions::Visit(Stmt *S) {
   for (Stmt::child_iterator it = S->child_begin(), ei = S->child_end();
        it != ei; ++it) {
     if (Stmt *child = *it)
-      AddLiveStmt(val.liveStmts, LV.SSetFact, child);
+      LV.addLiveStmt(val, LookThroughStmt(child));
   }
 }
 
@@ -352,7 +385,7 @@ void TransferFunctions::VisitBinaryOperator(BinaryOperator *B) {
 
         if (!isAlwaysAlive(VD)) {
           // The variable is now dead.
-          val.liveDecls = LV.DSetFact.remove(val.liveDecls, VD);
+          LV.removeLive(val, VD);
         }
 
         if (observer)
@@ -369,14 +402,14 @@ void TransferFunctions::VisitBlockExpr(BlockExpr *BE) {
     const VarDecl *VD = *I;
     if (isAlwaysAlive(VD))
       continue;
-    val.liveDecls = LV.DSetFact.add(val.liveDecls, VD);
+    LV.addLiveDecl(val, VD);
   }
 }
 
 void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *DR) {
   if (const VarDecl *D = dyn_cast<VarDecl>(DR->getDecl()))
     if (!isAlwaysAlive(D) && LV.inAssignment.find(DR) == LV.inAssignment.end())
-      val.liveDecls = LV.DSetFact.add(val.liveDecls, D);
+      LV.addLiveDecl(val, D);
 }
 
 void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
@@ -384,7 +417,7 @@ void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
        DI != DE; ++DI)
     if (VarDecl *VD = dyn_cast<VarDecl>(*DI)) {
       if (!isAlwaysAlive(VD))
-        val.liveDecls = LV.DSetFact.remove(val.liveDecls, VD);
+        LV.removeLive(val, VD);
     }
 }
 
@@ -402,7 +435,7 @@ void TransferFunctions::VisitObjCForCollectionStmt(ObjCForCollectionStmt *OS) {
   }
   
   if (VD) {
-    val.liveDecls = LV.DSetFact.remove(val.liveDecls, VD);
+    LV.removeLive(val, VD);
     if (observer && DR)
       observer->observerKill(DR);
   }
@@ -420,7 +453,7 @@ VisitUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *UE)
   const Expr *subEx = UE->getArgumentExpr();
   if (subEx->getType()->isVariableArrayType()) {
     assert(subEx->isLValue());
-    val.liveStmts = LV.SSetFact.add(val.liveStmts, subEx->IgnoreParens());
+    LV.addLiveStmt(val, subEx->IgnoreParens());
   }
 }
 
@@ -448,10 +481,10 @@ void TransferFunctions::VisitUnaryOperator(UnaryOperator *UO) {
     }
 }
 
-LiveVariables::LivenessValues
-LiveVariablesImpl::runOnBlock(const CFGBlock *block,
-                              LiveVariables::LivenessValues val,
-                              LiveVariables::Observer *obs) {
+void LiveVariablesImpl::runOnBlock(const CFGBlock *block,
+                                   LiveVariables::LivenessValues &val,
+                                   LiveVariables::Observer *obs,
+                                   bool recordStmts) {
 
   TransferFunctions TF(*this, val, obs, block);
   
@@ -460,12 +493,13 @@ LiveVariablesImpl::runOnBlock(const CFGBlock *block,
     TF.Visit(const_cast<Stmt*>(term));
   
   // Apply the transfer function for all Stmts in the block.
-  for (CFGBlock::const_reverse_iterator it = block->rbegin(),
-       ei = block->rend(); it != ei; ++it) {
+  unsigned index = view.getIndex(block);
+  for (FlatCFGView::reverse_element_iterator it = view.element_rbegin(index),
+       ei = view.element_rend(index); it != ei; ++it) {
     const CFGElement &elem = *it;
 
     if (const CFGAutomaticObjDtor *Dtor = dyn_cast<CFGAutomaticObjDtor>(&elem)){
-      val.liveDecls = DSetFact.add(val.liveDecls, Dtor->getVarDecl());
+      addLiveDecl(val, Dtor->getVarDecl());
       continue;
     }
 
@@ -474,15 +508,25 @@ LiveVariablesImpl::runOnBlock(const CFGBlock *block,
     
     const Stmt *S = cast<CFGStmt>(elem).getStmt();
     TF.Visit(const_cast<Stmt*>(S));
-    stmtsToLiveness[S] = val;
+    if (recordStmts)
+      currentBlockLiveness[S] = val.live;
   }
-  return val;
+}
+
+void LiveVariablesImpl::transferBlock(const CFGBlock *block,
+                                      llvm::BitVector &bits) {
+  LiveVariables::LivenessValues val(bits, &numbering);
+  runOnBlock(block, val, 0, false);
+  bits = val.live;
 }
 
 void LiveVariables::runOnAllBlocks(LiveVariables::Observer &obs) {
-  const CFG *cfg = getImpl(impl).analysisContext.getCFG();
-  for (CFG::const_iterator it = cfg->begin(), ei = cfg->end(); it != ei; ++it)
-    getImpl(impl).runOnBlock(*it, getImpl(impl).blocksEndToLiveness[*it], &obs);    
+  LiveVariablesImpl &LV = getImpl(impl);
+  const CFG *cfg = LV.analysisContext.getCFG();
+  for (CFG::const_iterator it = cfg->begin(), ei = cfg->end(); it != ei; ++it) {
+    LivenessValues val(LV.dataflow.getExitValues(*it), &LV.numbering);
+    LV.runOnBlock(*it, val, &obs, false);
+  }
 }
 
 LiveVariables::LiveVariables(void *im) : impl(im) {} 
@@ -505,25 +549,20 @@ LiveVariables::computeLiveness(AnalysisDeclContext &AC,
   if (cfg->getNumBlockIDs() > 300000)
     return 0;
 
-  LiveVariablesImpl *LV = new LiveVariablesImpl(AC, killAtAssign);
+  const FlatCFGView *View = AC.getAnalysis<FlatCFGView>();
+  if (!View)
+    return 0;
 
-  // Construct the dataflow worklist.  Enqueue the exit block as the
-  // start of the analysis.
-  DataflowWorklist worklist(*cfg, AC);
-  llvm::BitVector everAnalyzedBlock(cfg->getNumBlockIDs());
+  LiveVariablesImpl *LV = new LiveVariablesImpl(AC, *cfg, *View, killAtAssign);
 
-  // FIXME: we should enqueue using post order.
-  for (CFG::const_iterator it = cfg->begin(), ei = cfg->end(); it != ei; ++it) {
-    const CFGBlock *block = *it;
-    worklist.enqueueBlock(block);
-    
-    // FIXME: Scan for DeclRefExprs using in the LHS of an assignment.
-    // We need to do this because we lack context in the reverse analysis
-    // to determine if a DeclRefExpr appears in such a context, and thus
-    // doesn't constitute a "use".
-    if (killAtAssign)
-      for (CFGBlock::const_iterator bi = block->begin(), be = block->end();
-           bi != be; ++bi) {
+  // FIXME: Scan for DeclRefExprs using in the LHS of an assignment.
+  // We need to do this because we lack context in the reverse analysis
+  // to determine if a DeclRefExpr appears in such a context, and thus
+  // doesn't constitute a "use".
+  if (killAtAssign)
+    for (unsigned i = 0, n = View->size(); i != n; ++i) {
+      for (FlatCFGView::element_iterator bi = View->element_begin(i),
+           be = View->element_end(i); bi != be; ++bi) {
         if (const CFGStmt *cs = bi->getAs<CFGStmt>()) {
           if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(cs->getStmt())) {
             if (BO->getOpcode() == BO_Assign) {
@@ -535,36 +574,17 @@ LiveVariables::computeLiveness(AnalysisDeclContext &AC,
           }
         }
       }
-  }
-  
-  worklist.sortWorklist();
-  
-  while (const CFGBlock *block = worklist.dequeue()) {
-    // Determine if the block's end value has changed.  If not, we
-    // have nothing left to do for this block.
-    LivenessValues &prevVal = LV->blocksEndToLiveness[block];
-    
-    // Merge the values of all successor blocks.
-    LivenessValues val;
-    for (CFGBlock::const_succ_iterator it = block->succ_begin(),
-                                       ei = block->succ_end(); it != ei; ++it) {
-      if (const CFGBlock *succ = *it) {     
-        val = LV->merge(val, LV->blocksBeginToLiveness[succ]);
-      }
     }
-    
-    if (!everAnalyzedBlock[block->getBlockID()])
-      everAnalyzedBlock[block->getBlockID()] = true;
-    else if (prevVal.equals(val))
-      continue;
-
-    prevVal = val;
-    
-    // Update the dataflow value for the start of this block.
-    LV->blocksBeginToLiveness[block] = LV->runOnBlock(block, val);
-    
-    // Enqueue the value to the predecessors.
-    worklist.enqueuePredecessors(block);
+  
+  // Compute the liveness at the boundaries of each block. The liveness
+  // before each statement is recomputed from it when queried.
+  LV->dataflow.solve(*LV);
+  for (CFG::const_iterator it = cfg->begin(), ei = cfg->end(); it != ei; ++it) {
+    unsigned index = View->getIndex(*it);
+    for (FlatCFGView::element_iterator bi = View->element_begin(index),
+         be = View->element_end(index); bi != be; ++bi)
+      if (const CFGStmt *cs = bi->getAs<CFGStmt>())
+        LV->stmtBlocks[cs->getStmt()] = *it;
   }
   
   return new LiveVariables(LV);
@@ -585,33 +605,26 @@ void LiveVariables::dumpBlockLiveness(const SourceManager &M) {
 }
 
 void LiveVariablesImpl::dumpBlockLiveness(const SourceManager &M) {
-  std::vector<const CFGBlock *> vec;
-  for (llvm::DenseMap<const CFGBlock *, LiveVariables::LivenessValues>::iterator
-       it = blocksEndToLiveness.begin(), ei = blocksEndToLiveness.end();
-       it != ei; ++it) {
-    vec.push_back(it->first);    
-  }
+  const CFG *cfg = analysisContext.getCFG();
+  std::vector<const CFGBlock *> vec(cfg->begin(), cfg->end());
   std::sort(vec.begin(), vec.end(), compare_entries);
 
-  std::vector<const VarDecl*> declVec;
+  SmallVector<const VarDecl*, 16> declVec;
 
   for (std::vector<const CFGBlock *>::iterator
         it = vec.begin(), ei = vec.end(); it != ei; ++it) {
     llvm::errs() << "\n[ B" << (*it)->getBlockID()
                  << " (live variables at block exit) ]\n";
     
-    LiveVariables::LivenessValues vals = blocksEndToLiveness[*it];
     declVec.clear();
-    
-    for (llvm::ImmutableSet<const VarDecl *>::iterator si =
-          vals.liveDecls.begin(),
-          se = vals.liveDecls.end(); si != se; ++si) {
-      declVec.push_back(*si);      
-    }
+    const llvm::BitVector &live = dataflow.getExitValues(*it);
+    for (int i = live.find_first(); i != -1; i = live.find_next(i))
+      if (!numbering.isStmt(i))
+        declVec.push_back(numbering.getDecl(i));
     
     std::sort(declVec.begin(), declVec.end(), compare_vd_entries);
     
-    for (std::vector<const VarDecl*>::iterator di = declVec.begin(),
+    for (SmallVectorImpl<const VarDecl*>::iterator di = declVec.begin(),
          de = declVec.end(); di != de; ++di) {
       llvm::errs() << " " << (*di)->getDeclName().getAsString()
                    << " <";
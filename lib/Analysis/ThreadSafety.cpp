@@ -28,11 +28,15 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/OperatorKinds.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <utility>
@@ -151,6 +155,13 @@ private:
              (Op == EOP_Wildcard) ||
              (Other.Op == EOP_Wildcard);
     }
+
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      ID.AddInteger(Op);
+      ID.AddInteger(Flags);
+      ID.AddInteger(Sz);
+      ID.AddPointer(Data);
+    }
   };
 
 
@@ -602,6 +613,23 @@ public:
     return false;
   }
 
+  /// \brief Return true if some node of this expression is a wildcard, which
+  /// matches any subexpression.
+  bool hasWildcard() const {
+    for (unsigned i = 0, n = NodeVec.size(); i < n; ++i)
+      if (NodeVec[i].kind() == EOP_Wildcard)
+        return true;
+    return false;
+  }
+
+  /// \brief Profile the exact structure of this expression.  Unlike
+  /// matches(), this distinguishes every flag and size, so expressions with
+  /// the same profile are interchangeable.
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    for (unsigned i = 0, n = NodeVec.size(); i < n; ++i)
+      NodeVec[i].Profile(ID);
+  }
+
   // A partial match between a.mu and b.mu returns true a and b have the same
   // type (and thus mu refers to the same mutex declaration), regardless of
   // whether a and b are different objects or not.
@@ -768,7 +796,7 @@ struct LockData {
     ID.AddInteger(LKind);
   }
 
-  bool isAtLeast(LockKind LK) {
+  bool isAtLeast(LockKind LK) const {
     return (LK == LK_Shared) || (LKind == LK_Exclusive);
   }
 };
@@ -776,33 +804,193 @@ struct LockData {
 
 /// \brief A FactEntry stores a single fact that is known at a particular point
 /// in the program execution.  Currently, this is information regarding a lock
-/// that is held at that point.  
+/// that is held at that point.  Facts are never modified once created.
 struct FactEntry {
   SExpr    MutID;
+  unsigned MutexID;   // The interned ID of MutID.
   LockData LDat;
 
-  FactEntry(const SExpr& M, const LockData& L)
-    : MutID(M), LDat(L)
+  FactEntry(const SExpr& M, unsigned MID, const LockData& L)
+    : MutID(M), MutexID(MID), LDat(L)
   { }
 };
 
 
 typedef unsigned short FactID;
+typedef SmallVector<FactID, 4> FactVec;
 
 /// \brief FactManager manages the memory for all facts that are created during 
 /// the analysis of a single routine.
+///
+/// It also interns the mutex expressions and the locksets (FactSets) that the
+/// analysis builds, so that they can be identified by number.  Two mutexes or
+/// locksets with the same ID are identical, which lets the analysis compare
+/// them in constant time, and cache the results of matching two mutexes and
+/// of joining two locksets.
 class FactManager {
 private:
+  /// \brief A mutex expression, interned by its exact structure.
+  struct MutexNode : public llvm::FoldingSetNode {
+    SExpr    Mutex;
+    unsigned ID;
+    bool     HasWildcard;
+
+    MutexNode(const SExpr &M, unsigned I)
+      : Mutex(M), ID(I), HasWildcard(M.hasWildcard())
+    { }
+
+    void Profile(llvm::FoldingSetNodeID &FID) const { Mutex.Profile(FID); }
+  };
+
+  /// \brief A lockset, interned by its list of facts.  Locksets are ordered,
+  /// because the order of a FactSet determines the order of lookups in it.
+  struct LocksetNode : public llvm::FoldingSetNode {
+    FactVec  Facts;
+    unsigned ID;
+    bool     HasWildcard;
+
+    LocksetNode(ArrayRef<FactID> F, unsigned I, bool W)
+      : Facts(F.begin(), F.end()), ID(I), HasWildcard(W)
+    { }
+
+    void Profile(llvm::FoldingSetNodeID &FID) const { Profile(FID, Facts); }
+
+    static void Profile(llvm::FoldingSetNodeID &FID, ArrayRef<FactID> F) {
+      for (unsigned i = 0, n = F.size(); i < n; ++i)
+        FID.AddInteger(F[i]);
+    }
+  };
+
+  typedef std::pair<unsigned, unsigned> IDPair;
+
   std::vector<FactEntry> Facts;
 
+  llvm::SpecificBumpPtrAllocator<MutexNode> MutexAllocator;
+  llvm::FoldingSet<MutexNode> MutexSet;
+  std::vector<MutexNode*> Mutexes;
+
+  llvm::SpecificBumpPtrAllocator<LocksetNode> LocksetAllocator;
+  llvm::FoldingSet<LocksetNode> LocksetSet;
+  std::vector<LocksetNode*> Locksets;
+
+  /// \brief Results of SExpr::matches(), keyed by ordered pairs of mutex IDs.
+  llvm::DenseMap<IDPair, bool> MatchCache;
+
+  /// \brief Joins of two locksets which issued no warnings, mapped to the
+  /// resulting lockset.  Joins which do not modify the first lockset are kept
+  /// separately, and have no result.
+  llvm::DenseMap<IDPair, unsigned> JoinCache;
+  llvm::DenseSet<IDPair> CheckCache;
+
 public:
+  enum { InvalidMutexID = ~0U };
+
   FactID newLock(const SExpr& M, const LockData& L) {
-    Facts.push_back(FactEntry(M,L));
+    Facts.push_back(FactEntry(M, getMutexID(M), L));
     return static_cast<unsigned short>(Facts.size() - 1);
   }
 
   const FactEntry& operator[](FactID F) const { return Facts[F]; }
   FactEntry&       operator[](FactID F)       { return Facts[F]; }
+
+  /// \brief Return the ID of the interned copy of M, interning it if needed.
+  unsigned getMutexID(const SExpr &M) {
+    llvm::FoldingSetNodeID FID;
+    M.Profile(FID);
+    void *InsertPos;
+    if (MutexNode *N = MutexSet.FindNodeOrInsertPos(FID, InsertPos))
+      return N->ID;
+    MutexNode *N = new (MutexAllocator.Allocate()) MutexNode(M, Mutexes.size());
+    MutexSet.InsertNode(N, InsertPos);
+    Mutexes.push_back(N);
+    return N->ID;
+  }
+
+  /// \brief Return the ID of the interned copy of M, or InvalidMutexID if M
+  /// has not been interned.  Unlike getMutexID(), this never interns M, so
+  /// lookups of mutexes that are not held do not grow the table.
+  unsigned findMutexID(const SExpr &M) {
+    llvm::FoldingSetNodeID FID;
+    M.Profile(FID);
+    void *InsertPos;
+    if (MutexNode *N = MutexSet.FindNodeOrInsertPos(FID, InsertPos))
+      return N->ID;
+    return InvalidMutexID;
+  }
+
+  /// \brief Equivalent to SExpr::matches() of the interned mutex MID1 and M,
+  /// where MID2 is the result of findMutexID(M).
+  bool matches(unsigned MID1, const SExpr &M, unsigned MID2) {
+    if (MID2 == InvalidMutexID)
+      return Mutexes[MID1]->Mutex.matches(M);
+    return matches(MID1, MID2);
+  }
+
+  /// \brief Equivalent to SExpr::matches() on the interned mutexes.
+  bool matches(unsigned MID1, unsigned MID2) {
+    if (MID1 == MID2)
+      return true;
+    // matches() is symmetric.
+    IDPair Key = MID1 < MID2 ? IDPair(MID1, MID2) : IDPair(MID2, MID1);
+    llvm::DenseMap<IDPair, bool>::iterator I = MatchCache.find(Key);
+    if (I != MatchCache.end())
+      return I->second;
+    bool Result = Mutexes[MID1]->Mutex.matches(Mutexes[MID2]->Mutex);
+    MatchCache[Key] = Result;
+    return Result;
+  }
+
+  /// \brief Return the ID of the interned lockset holding the facts F.
+  unsigned getLocksetID(ArrayRef<FactID> F) {
+    llvm::FoldingSetNodeID FID;
+    LocksetNode::Profile(FID, F);
+    void *InsertPos;
+    if (LocksetNode *N = LocksetSet.FindNodeOrInsertPos(FID, InsertPos))
+      return N->ID;
+    bool HasWildcard = false;
+    for (unsigned i = 0, n = F.size(); i < n; ++i)
+      HasWildcard |= Mutexes[Facts[F[i]].MutexID]->HasWildcard;
+    LocksetNode *N = new (LocksetAllocator.Allocate())
+      LocksetNode(F, Locksets.size(), HasWildcard);
+    LocksetSet.InsertNode(N, InsertPos);
+    Locksets.push_back(N);
+    return N->ID;
+  }
+
+  const FactVec &getLockset(unsigned LID) const {
+    return Locksets[LID]->Facts;
+  }
+
+  /// \brief Return true if some mutex in the lockset contains a wildcard, and
+  /// so may match more than one lock in the lockset.
+  bool locksetHasWildcard(unsigned LID) const {
+    return Locksets[LID]->HasWildcard;
+  }
+
+  /// \brief Look up a join of two locksets which issued no warnings.  On
+  /// success, Result is set to the joined lockset if Modify is true.
+  bool lookupJoin(unsigned LID1, unsigned LID2, bool Modify,
+                  unsigned &Result) const {
+    IDPair Key(LID1, LID2);
+    if (!Modify)
+      return CheckCache.count(Key);
+    llvm::DenseMap<IDPair, unsigned>::const_iterator I = JoinCache.find(Key);
+    if (I == JoinCache.end())
+      return false;
+    Result = I->second;
+    return true;
+  }
+
+  void recordJoin(unsigned LID1, unsigned LID2, bool Modify, unsigned Result) {
+    IDPair Key(LID1, LID2);
+    if (Modify)
+      JoinCache[Key] = Result;
+    else
+      CheckCache.insert(Key);
+  }
+
+  unsigned getNumMutexes() const { return Mutexes.size(); }
+  unsigned getNumLocksets() const { return Locksets.size(); }
 };
 
 
@@ -813,27 +1001,42 @@ public:
 /// locks, so we can get away with doing a linear search for lookup.  Note
 /// that a hashtable or map is inappropriate in this case, because lookups
 /// may involve partial pattern matches, rather than exact matches.
+///
+/// A FactSet remembers its interned lockset ID until it is modified.
 class FactSet {
 private:
-  typedef SmallVector<FactID, 4> FactVec;
+  enum { InvalidLocksetID = ~0U };
 
   FactVec FactIDs;
+  mutable unsigned LocksetID;
 
 public:
-  typedef FactVec::iterator       iterator;
   typedef FactVec::const_iterator const_iterator;
 
-  iterator       begin()       { return FactIDs.begin(); }
-  const_iterator begin() const { return FactIDs.begin(); }
+  FactSet() : LocksetID(InvalidLocksetID) { }
 
-  iterator       end()       { return FactIDs.end(); }
+  const_iterator begin() const { return FactIDs.begin(); }
   const_iterator end() const { return FactIDs.end(); }
 
   bool isEmpty() const { return FactIDs.size() == 0; }
 
+  /// \brief Return the interned ID of this lockset.
+  unsigned getLocksetID(FactManager &FM) const {
+    if (LocksetID == InvalidLocksetID)
+      LocksetID = FM.getLocksetID(FactIDs);
+    return LocksetID;
+  }
+
+  /// \brief Replace the contents of this set with an interned lockset.
+  void setLockset(FactManager &FM, unsigned LID) {
+    FactIDs = FM.getLockset(LID);
+    LocksetID = LID;
+  }
+
   FactID addLock(FactManager& FM, const SExpr& M, const LockData& L) {
     FactID F = FM.newLock(M, L);
     FactIDs.push_back(F);
+    LocksetID = InvalidLocksetID;
     return F;
   }
 
@@ -842,39 +1045,43 @@ public:
     if (n == 0)
       return false;
 
+    unsigned MID = FM.findMutexID(M);
     for (unsigned i = 0; i < n-1; ++i) {
-      if (FM[FactIDs[i]].MutID.matches(M)) {
+      if (FM.matches(FM[FactIDs[i]].MutexID, M, MID)) {
         FactIDs[i] = FactIDs[n-1];
         FactIDs.pop_back();
+        LocksetID = InvalidLocksetID;
         return true;
       }
     }
-    if (FM[FactIDs[n-1]].MutID.matches(M)) {
+    if (FM.matches(FM[FactIDs[n-1]].MutexID, M, MID)) {
       FactIDs.pop_back();
+      LocksetID = InvalidLocksetID;
       return true;
     }
     return false;
   }
 
-  LockData* findLock(FactManager &FM, const SExpr &M) const {
+  const LockData* findLock(FactManager &FM, const SExpr &M) const {
+    unsigned MID = FM.findMutexID(M);
     for (const_iterator I = begin(), E = end(); I != E; ++I) {
-      const SExpr &Exp = FM[*I].MutID;
-      if (Exp.matches(M))
+      if (FM.matches(FM[*I].MutexID, M, MID))
         return &FM[*I].LDat;
     }
     return 0;
   }
 
-  LockData* findLockUniv(FactManager &FM, const SExpr &M) const {
+  const LockData* findLockUniv(FactManager &FM, const SExpr &M) const {
+    unsigned MID = FM.findMutexID(M);
     for (const_iterator I = begin(), E = end(); I != E; ++I) {
-      const SExpr &Exp = FM[*I].MutID;
-      if (Exp.matches(M) || Exp.isUniversal())
-        return &FM[*I].LDat;
+      const FactEntry &Entry = FM[*I];
+      if (FM.matches(Entry.MutexID, M, MID) || Entry.MutID.isUniversal())
+        return &Entry.LDat;
     }
     return 0;
   }
 
-  FactEntry* findPartialMatch(FactManager &FM, const SExpr &M) const {
+  const FactEntry* findPartialMatch(FactManager &FM, const SExpr &M) const {
     for (const_iterator I=begin(), E=end(); I != E; ++I) {
       const SExpr& Exp = FM[*I].MutID;
       if (Exp.partiallyMatches(M)) return &FM[*I];
@@ -1422,12 +1629,14 @@ class ThreadSafetyAnalyzer {
   friend class BuildLockset;
 
   ThreadSafetyHandler       &Handler;
+  ThreadSafetyStats         *Stats;
   LocalVariableMap          LocalVarMap;
   FactManager               FactMan;
   std::vector<CFGBlockInfo> BlockInfo;
 
 public:
-  ThreadSafetyAnalyzer(ThreadSafetyHandler &H) : Handler(H) {}
+  ThreadSafetyAnalyzer(ThreadSafetyHandler &H, ThreadSafetyStats *S)
+    : Handler(H), Stats(S) {}
 
   void addLock(FactSet &FSet, const SExpr &Mutex, const LockData &LDat);
   void removeLock(FactSet &FSet, const SExpr &Mutex,
@@ -1462,6 +1671,8 @@ public:
   }
 
   void runAnalysis(AnalysisDeclContext &AC);
+
+  const FactManager &getFactManager() const { return FactMan; }
 };
 
 
@@ -1787,11 +1998,11 @@ void BuildLockset::warnIfMutexNotHeld(const NamedDecl *D, Expr *Exp,
     return;
   }
 
-  LockData* LDat = FSet.findLockUniv(Analyzer->FactMan, Mutex);
+  const LockData* LDat = FSet.findLockUniv(Analyzer->FactMan, Mutex);
   bool NoError = true;
   if (!LDat) {
     // No exact match found.  Look for a partial match.
-    FactEntry* FEntry = FSet.findPartialMatch(Analyzer->FactMan, Mutex);
+    const FactEntry* FEntry = FSet.findPartialMatch(Analyzer->FactMan, Mutex);
     if (FEntry) {
       // Warn that there's no precise match.
       LDat = &FEntry->LDat;
@@ -1821,7 +2032,7 @@ void BuildLockset::warnIfMutexHeld(const NamedDecl *D, Expr* Exp,
     return;
   }
 
-  LockData* LDat = FSet.findLock(Analyzer->FactMan, Mutex);
+  const LockData* LDat = FSet.findLock(Analyzer->FactMan, Mutex);
   if (LDat) {
     std::string DeclName = D->getNameAsString();
     StringRef   DeclNameSR (DeclName);
@@ -2102,6 +2313,33 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
                                             LockErrorKind LEK1,
                                             LockErrorKind LEK2,
                                             bool Modify) {
+  if (Stats)
+    ++Stats->NumJoins;
+
+  unsigned LID1 = FSet1.getLocksetID(FactMan);
+  unsigned LID2 = FSet2.getLocksetID(FactMan);
+
+  // A lockset joined with itself is unchanged, and no lock is missing from
+  // either side.  This does not hold if a wildcard could match some other
+  // lock in the set.
+  if (LID1 == LID2 && !FactMan.locksetHasWildcard(LID1)) {
+    if (Stats)
+      ++Stats->NumTrivialJoins;
+    return;
+  }
+
+  // Joins only depend on the two locksets, so a join which issued no
+  // warnings before can reuse its result.
+  unsigned Result;
+  if (FactMan.lookupJoin(LID1, LID2, Modify, Result)) {
+    if (Modify)
+      FSet1.setLockset(FactMan, Result);
+    if (Stats)
+      ++Stats->NumCachedJoins;
+    return;
+  }
+
+  bool Warned = false;
   FactSet FSet1Orig = FSet1;
 
   for (FactSet::const_iterator I = FSet2.begin(), E = FSet2.end();
@@ -2111,6 +2349,7 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
 
     if (const LockData *LDat1 = FSet1.findLock(FactMan, FSet2Mutex)) {
       if (LDat1->LKind != LDat2.LKind) {
+        Warned = true;
         Handler.handleExclusiveAndShared(FSet2Mutex.toString(),
                                          LDat2.AcquireLoc,
                                          LDat1->AcquireLoc);
@@ -2125,15 +2364,18 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
           // If this is a scoped lock that manages another mutex, and if the
           // underlying mutex is still held, then warn about the underlying
           // mutex.
+          Warned = true;
           Handler.handleMutexHeldEndOfScope(LDat2.UnderlyingMutex.toString(),
                                             LDat2.AcquireLoc,
                                             JoinLoc, LEK1);
         }
       }
-      else if (!LDat2.Managed && !FSet2Mutex.isUniversal())
+      else if (!LDat2.Managed && !FSet2Mutex.isUniversal()) {
+        Warned = true;
         Handler.handleMutexHeldEndOfScope(FSet2Mutex.toString(),
                                           LDat2.AcquireLoc,
                                           JoinLoc, LEK1);
+      }
     }
   }
 
@@ -2148,19 +2390,25 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
           // If this is a scoped lock that manages another mutex, and if the
           // underlying mutex is still held, then warn about the underlying
           // mutex.
+          Warned = true;
           Handler.handleMutexHeldEndOfScope(LDat1.UnderlyingMutex.toString(),
                                             LDat1.AcquireLoc,
                                             JoinLoc, LEK1);
         }
       }
-      else if (!LDat1.Managed && !FSet1Mutex.isUniversal())
+      else if (!LDat1.Managed && !FSet1Mutex.isUniversal()) {
+        Warned = true;
         Handler.handleMutexHeldEndOfScope(FSet1Mutex.toString(),
                                           LDat1.AcquireLoc,
                                           JoinLoc, LEK2);
+      }
       if (Modify)
         FSet1.removeLock(FactMan, FSet1Mutex);
     }
   }
+
+  if (!Warned)
+    FactMan.recordJoin(LID1, LID2, Modify, FSet1.getLocksetID(FactMan));
 }
 
 
@@ -2202,12 +2450,22 @@ void ThreadSafetyAnalyzer::runAnalysis(AnalysisDeclContext &AC) {
   // Mark entry block as reachable
   BlockInfo[CFGraph->getEntry().getBlockID()].Reachable = true;
 
+  llvm::TimeRecord ContextStart;
+  if (Stats)
+    ContextStart = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+
   // Compute SSA names for local variables
   LocalVarMap.traverseCFG(CFGraph, SortedGraph, BlockInfo);
 
   // Fill in source locations for all CFGBlocks.
   findBlockLocations(CFGraph, SortedGraph, BlockInfo);
 
+  if (Stats) {
+    llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+    Elapsed -= ContextStart;
+    Stats->ContextTime += Elapsed.getWallTime();
+  }
+
   // Add locks from exclusive_locks_required and shared_locks_required
   // to initial lockset. Also turn off checking for lock and unlock functions.
   // FIXME: is there a more intelligent way to check lock/unlock functions?
@@ -2441,9 +2699,25 @@ namespace thread_safety {
 /// at the end of each block, and issue warnings for thread safety violations.
 /// Each block in the CFG is traversed exactly once.
 void runThreadSafetyAnalysis(AnalysisDeclContext &AC,
-                             ThreadSafetyHandler &Handler) {
-  ThreadSafetyAnalyzer Analyzer(Handler);
+                             ThreadSafetyHandler &Handler,
+                             ThreadSafetyStats *Stats) {
+  ThreadSafetyAnalyzer Analyzer(Handler, Stats);
+  if (!Stats) {
+    Analyzer.runAnalysis(AC);
+    return;
+  }
+
+  // Everything but the local variable contexts is lockset computation.
+  double ContextTime = Stats->ContextTime;
+  llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
   Analyzer.runAnalysis(AC);
+  llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+  Elapsed -= Start;
+  Stats->LocksetTime += Elapsed.getWallTime() -
+                        (Stats->ContextTime - ContextTime);
+
+  Stats->NumMutexes += Analyzer.getFactManager().getNumMutexes();
+  Stats->NumLocksets += Analyzer.getFactManager().getNumLocksets();
 }
 
 /// \brief Helper function that returns a LockKind required for the given level
@@ -13,23 +13,22 @@
 
 #include <utility>
 #include "llvm/ADT/Optional.h"
-#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/SmallVector.h"
-#include "llvm/ADT/PackedVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/AnalysisContext.h"
 #include "clang/Analysis/Visitors/CFGRecStmtDeclVisitor.h"
+#include "clang/Analysis/Analyses/BitVectorDataflow.h"
+#include "clang/Analysis/Analyses/FlatCFGView.h"
 #include "clang/Analysis/Analyses/UninitializedValues.h"
 #include "clang/Analysis/DomainSpecific/ObjCNoReturn.h"
 #include "llvm/Support/SaveAndRestore.h"
 
 using namespace clang;
 
-#define DEBUG_LOGGING 0
-
 static bool isTrackedVar(const VarDecl *vd, const DeclContext *dc) {
   if (vd->isLocalVarDecl() && !vd->hasGlobalStorage() &&
       !vd->isExceptionVariable() &&
@@ -40,45 +39,6 @@ static bool isTrackedVar(const VarDecl *vd, const DeclContext *dc) {
   return false;
 }
 
-//------------------------------------------------------------------------====//
-// DeclToIndex: a mapping from Decls we track to value indices.
-//====------------------------------------------------------------------------//
-
-namespace {
-class DeclToIndex {
-  llvm::DenseMap<const VarDecl *, unsigned> map;
-public:
-  DeclToIndex() {}
-  
-  /// Compute the actual mapping from declarations to bits.
-  void computeMap(const DeclContext &dc);
-  
-  /// Return the number of declarations in the map.
-  unsigned size() const { return map.size(); }
-  
-  /// Returns the bit vector index for a given declaration.
-  llvm::Optional<unsigned> getValueIndex(const VarDecl *d) const;
-};
-}
-
-void DeclToIndex::computeMap(const DeclContext &dc) {
-  unsigned count = 0;
-  DeclContext::specific_decl_iterator<VarDecl> I(dc.decls_begin()),
-                                               E(dc.decls_end());
-  for ( ; I != E; ++I) {
-    const VarDecl *vd = *I;
-    if (isTrackedVar(vd, &dc))
-      map[vd] = count++;
-  }
-}
-
-llvm::Optional<unsigned> DeclToIndex::getValueIndex(const VarDecl *d) const {
-  llvm::DenseMap<const VarDecl *, unsigned>::const_iterator I = map.find(d);
-  if (I == map.end())
-    return llvm::Optional<unsigned>();
-  return I->second;
-}
-
 //------------------------------------------------------------------------====//
 // CFGBlockValues: dataflow values for CFG blocks.
 //====------------------------------------------------------------------------//
@@ -97,147 +57,96 @@ static bool isAlwaysUninit(const Value v) {
   return v == Uninitialized;
 }
 
-namespace {
+/// \brief Read the value of the variable with the given index from a bit
+/// vector holding two bits per variable.
+static Value getValueAt(const llvm::BitVector &bv, unsigned idx) {
+  unsigned bit = idx * 2;
+  if (bit >= bv.size())
+    return Unknown;
+  return Value((bv[bit] ? Initialized : Unknown) |
+               (bv[bit + 1] ? Uninitialized : Unknown));
+}
+
+static void setValueAt(llvm::BitVector &bv, unsigned idx, Value v) {
+  unsigned bit = idx * 2;
+  bv[bit] = (v & Initialized) != 0;
+  bv[bit + 1] = (v & Uninitialized) != 0;
+}
 
-typedef llvm::PackedVector<Value, 2, llvm::SmallBitVector> ValueVector;
+namespace {
 
 class CFGBlockValues {
-  const CFG &cfg;
-  SmallVector<ValueVector, 8> vals;
-  ValueVector scratch;
-  DeclToIndex declToIndex;
+  DataflowVarNumbering declToIndex;
+  BitVectorDataflow dataflow;
+  llvm::BitVector *scratch;
 public:
-  CFGBlockValues(const CFG &cfg);
+  CFGBlockValues(const CFG &cfg, const FlatCFGView &View);
 
   unsigned getNumEntries() const { return declToIndex.size(); }
   
   void computeSetOfDeclarations(const DeclContext &dc);  
-  ValueVector &getValueVector(const CFGBlock *block) {
-    return vals[block->getBlockID()];
-  }
 
+  BitVectorDataflow &getDataflow() { return dataflow; }
+
+  /// Make the given values the ones the transfer functions operate on.
+  void setScratch(llvm::BitVector &bv);
   void setAllScratchValues(Value V);
-  void mergeIntoScratch(ValueVector const &source, bool isFirst);
-  bool updateValueVectorWithScratch(const CFGBlock *block);
   
   bool hasNoDeclarations() const {
-    return declToIndex.size() == 0;
+    return declToIndex.empty();
   }
 
-  void resetScratch();
-  
-  ValueVector::reference operator[](const VarDecl *vd);
+  Value getScratchValue(const VarDecl *vd) const;
+  void setScratchValue(const VarDecl *vd, Value V);
 
   Value getValue(const CFGBlock *block, const CFGBlock *dstBlock,
                  const VarDecl *vd) {
-    const llvm::Optional<unsigned> &idx = declToIndex.getValueIndex(vd);
+    const llvm::Optional<unsigned> &idx = declToIndex.getIndex(vd);
     assert(idx.hasValue());
-    return getValueVector(block)[idx.getValue()];
+    return getValueAt(dataflow.getExitValues(block), idx.getValue());
   }
 };  
 } // end anonymous namespace
 
-CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), vals(0) {}
+CFGBlockValues::CFGBlockValues(const CFG &cfg, const FlatCFGView &View)
+  : dataflow(cfg, View, DataflowWorklist::Forward), scratch(0) {}
 
 void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
-  declToIndex.computeMap(dc);
-  unsigned decls = declToIndex.size();
-  scratch.resize(decls);
-  unsigned n = cfg.getNumBlockIDs();
-  if (!n)
-    return;
-  vals.resize(n);
-  for (unsigned i = 0; i < n; ++i)
-    vals[i].resize(decls);
-}
-
-#if DEBUG_LOGGING
-static void printVector(const CFGBlock *block, ValueVector &bv,
-                        unsigned num) {
-  llvm::errs() << block->getBlockID() << " :";
-  for (unsigned i = 0; i < bv.size(); ++i) {
-    llvm::errs() << ' ' << bv[i];
+  DeclContext::specific_decl_iterator<VarDecl> I(dc.decls_begin()),
+                                               E(dc.decls_end());
+  for ( ; I != E; ++I) {
+    const VarDecl *vd = *I;
+    if (isTrackedVar(vd, &dc))
+      declToIndex.getOrAddIndex(vd);
   }
-  llvm::errs() << " : " << num << '\n';
 }
-#endif
 
-void CFGBlockValues::setAllScratchValues(Value V) {
-  for (unsigned I = 0, E = scratch.size(); I != E; ++I)
-    scratch[I] = V;
+void CFGBlockValues::setScratch(llvm::BitVector &bv) {
+  // Blocks whose predecessors have not been analyzed start out empty.
+  if (bv.size() < getNumEntries() * 2)
+    bv.resize(getNumEntries() * 2);
+  scratch = &bv;
 }
 
-void CFGBlockValues::mergeIntoScratch(ValueVector const &source,
-                                      bool isFirst) {
-  if (isFirst)
-    scratch = source;
-  else
-    scratch |= source;
-}
-
-bool CFGBlockValues::updateValueVectorWithScratch(const CFGBlock *block) {
-  ValueVector &dst = getValueVector(block);
-  bool changed = (dst != scratch);
-  if (changed)
-    dst = scratch;
-#if DEBUG_LOGGING
-  printVector(block, scratch, 0);
-#endif
-  return changed;
-}
-
-void CFGBlockValues::resetScratch() {
-  scratch.reset();
+void CFGBlockValues::setAllScratchValues(Value V) {
+  if (V == Unknown) {
+    scratch->reset();
+    return;
+  }
+  for (unsigned I = 0, E = getNumEntries(); I != E; ++I)
+    setValueAt(*scratch, I, V);
 }
 
-ValueVector::reference CFGBlockValues::operator[](const VarDecl *vd) {
-  const llvm::Optional<unsigned> &idx = declToIndex.getValueIndex(vd);
+Value CFGBlockValues::getScratchValue(const VarDecl *vd) const {
+  const llvm::Optional<unsigned> &idx = declToIndex.getIndex(vd);
   assert(idx.hasValue());
-  return scratch[idx.getValue()];
-}
-
-//------------------------------------------------------------------------====//
-// Worklist: worklist for dataflow analysis.
-//====------------------------------------------------------------------------//
-
-namespace {
-class DataflowWorklist {
-  SmallVector<const CFGBlock *, 20> worklist;
-  llvm::BitVector enqueuedBlocks;
-public:
-  DataflowWorklist(const CFG &cfg) : enqueuedBlocks(cfg.getNumBlockIDs()) {}
-  
-  void enqueueSuccessors(const CFGBlock *block);
-  const CFGBlock *dequeue();
-};
+  return getValueAt(*scratch, idx.getValue());
 }
 
-void DataflowWorklist::enqueueSuccessors(const clang::CFGBlock *block) {
-  unsigned OldWorklistSize = worklist.size();
-  for (CFGBlock::const_succ_iterator I = block->succ_begin(),
-       E = block->succ_end(); I != E; ++I) {
-    const CFGBlock *Successor = *I;
-    if (!Successor || enqueuedBlocks[Successor->getBlockID()])
-      continue;
-    worklist.push_back(Successor);
-    enqueuedBlocks[Successor->getBlockID()] = true;
-  }
-  if (OldWorklistSize == 0 || OldWorklistSize == worklist.size())
-    return;
-
-  // Rotate the newly added blocks to the start of the worklist so that it forms
-  // a proper queue when we pop off the end of the worklist.
-  std::rotate(worklist.begin(), worklist.begin() + OldWorklistSize,
-              worklist.end());
-}
-
-const CFGBlock *DataflowWorklist::dequeue() {
-  if (worklist.empty())
-    return 0;
-  const CFGBlock *b = worklist.back();
-  worklist.pop_back();
-  enqueuedBlocks[b->getBlockID()] = false;
-  return b;
+void CFGBlockValues::setScratchValue(const VarDecl *vd, Value V) {
+  const llvm::Optional<unsigned> &idx = declToIndex.getIndex(vd);
+  assert(idx.hasValue());
+  setValueAt(*scratch, idx.getValue(), V);
 }
 
 //------------------------------------------------------------------------====//
@@ -573,7 +482,7 @@ public:
 void TransferFunctions::reportUse(const Expr *ex, const VarDecl *vd) {
   if (!handler)
     return;
-  Value v = vals[vd];
+  Value v = vals.getScratchValue(vd);
   if (isUninitialized(v))
     handler->handleUseOfUninitVariable(vd, getUninitUse(ex, vd, v));
 }
@@ -583,7 +492,7 @@ void TransferFunctions::VisitObjCForCollectionStmt(ObjCForCollectionStmt *FS) {
   if (DeclStmt *DS = dyn_cast<DeclStmt>(FS->getElement())) {
     const VarDecl *VD = cast<VarDecl>(DS->getSingleDecl());
     if (isTrackedVar(VD))
-      vals[VD] = Initialized;
+      vals.setScratchValue(VD, Initialized);
   }
 }
 
@@ -595,7 +504,7 @@ void TransferFunctions::VisitBlockExpr(BlockExpr *be) {
     if (!isTrackedVar(vd))
       continue;
     if (i->isByRef()) {
-      vals[vd] = Initialized;
+      vals.setScratchValue(vd, Initialized);
       continue;
     }
     reportUse(be, vd);
@@ -633,7 +542,7 @@ void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *dr) {
     reportUse(dr, cast<VarDecl>(dr->getDecl()));
     break;
   case ClassifyRefs::Init:
-    vals[cast<VarDecl>(dr->getDecl())] = Initialized;
+    vals.setScratchValue(cast<VarDecl>(dr->getDecl()), Initialized);
     break;
   case ClassifyRefs::SelfInit:
     if (handler)
@@ -646,7 +555,7 @@ void TransferFunctions::VisitBinaryOperator(BinaryOperator *BO) {
   if (BO->getOpcode() == BO_Assign) {
     FindVarResult Var = findVar(BO->getLHS());
     if (const VarDecl *VD = Var.getDecl())
-      vals[VD] = Initialized;
+      vals.setScratchValue(VD, Initialized);
   }
 }
 
@@ -666,10 +575,10 @@ void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
         // clients can detect this pattern and adjust their reporting
         // appropriately, but we need to continue to analyze subsequent uses
         // of the variable.
-        vals[VD] = Uninitialized;
+        vals.setScratchValue(VD, Uninitialized);
       } else if (VD->getInit()) {
         // Treat the new variable as initialized.
-        vals[VD] = Initialized;
+        vals.setScratchValue(VD, Initialized);
       } else {
         // No initializer: the variable is now uninitialized. This matters
         // for cases like:
@@ -681,7 +590,7 @@ void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
         // FIXME: Mark the variable as uninitialized whenever its scope is
         // left, since its scope could be re-entered by a jump over the
         // declaration.
-        vals[VD] = Uninitialized;
+        vals.setScratchValue(VD, Uninitialized);
       }
     }
   }
@@ -699,32 +608,43 @@ void TransferFunctions::VisitObjCMessageExpr(ObjCMessageExpr *ME) {
 // High-level "driver" logic for uninitialized values analysis.
 //====------------------------------------------------------------------------//
 
-static bool runOnBlock(const CFGBlock *block, const CFG &cfg,
+static void runOnBlock(const CFGBlock *block, const CFG &cfg,
+                       const FlatCFGView &view,
                        AnalysisDeclContext &ac, CFGBlockValues &vals,
+                       llvm::BitVector &blockVals,
                        const ClassifyRefs &classification,
-                       llvm::BitVector &wasAnalyzed,
                        UninitVariablesHandler *handler = 0) {
-  wasAnalyzed[block->getBlockID()] = true;
-  vals.resetScratch();
-  // Merge in values of predecessor blocks.
-  bool isFirst = true;
-  for (CFGBlock::const_pred_iterator I = block->pred_begin(),
-       E = block->pred_end(); I != E; ++I) {
-    const CFGBlock *pred = *I;
-    if (wasAnalyzed[pred->getBlockID()]) {
-      vals.mergeIntoScratch(vals.getValueVector(pred), isFirst);
-      isFirst = false;
-    }
-  }
+  vals.setScratch(blockVals);
   // Apply the transfer function.
   TransferFunctions tf(vals, cfg, block, ac, classification, handler);
-  for (CFGBlock::const_iterator I = block->begin(), E = block->end(); 
-       I != E; ++I) {
+  unsigned index = view.getIndex(block);
+  for (FlatCFGView::element_iterator I = view.element_begin(index),
+       E = view.element_end(index); I != E; ++I) {
     if (const CFGStmt *cs = dyn_cast<CFGStmt>(&*I)) {
       tf.Visit(const_cast<Stmt*>(cs->getStmt()));
     }
   }
-  return vals.updateValueVectorWithScratch(block);
+}
+
+namespace {
+/// The transfer function of a whole block, as applied by the dataflow solver.
+class BlockTransfer {
+  const CFG &cfg;
+  const FlatCFGView &view;
+  AnalysisDeclContext &ac;
+  CFGBlockValues &vals;
+  const ClassifyRefs &classification;
+public:
+  BlockTransfer(const CFG &cfg, const FlatCFGView &view,
+                AnalysisDeclContext &ac, CFGBlockValues &vals,
+                const ClassifyRefs &classification)
+    : cfg(cfg), view(view), ac(ac), vals(vals),
+      classification(classification) {}
+
+  void transferBlock(const CFGBlock *block, llvm::BitVector &blockVals) {
+    runOnBlock(block, cfg, view, ac, vals, blockVals, classification);
+  }
+};
 }
 
 void clang::runUninitializedVariablesAnalysis(
@@ -733,7 +653,11 @@ void clang::runUninitializedVariablesAnalysis(
     AnalysisDeclContext &ac,
     UninitVariablesHandler &handler,
     UninitVariablesAnalysisStats &stats) {
-  CFGBlockValues vals(cfg);
+  const FlatCFGView *View = ac.getAnalysis<FlatCFGView>();
+  if (!View)
+    return;
+
+  CFGBlockValues vals(cfg, *View);
   vals.computeSetOfDeclarations(dc);
   if (vals.hasNoDeclarations())
     return;
@@ -745,38 +669,56 @@ void clang::runUninitializedVariablesAnalysis(
   cfg.VisitBlockStmts(classification);
 
   // Mark all variables uninitialized at the entry.
-  const CFGBlock &entry = cfg.getEntry();
-  ValueVector &vec = vals.getValueVector(&entry);
   const unsigned n = vals.getNumEntries();
-  for (unsigned j = 0; j < n ; ++j) {
-    vec[j] = Uninitialized;
-  }
-
-  // Proceed with the workist.
-  DataflowWorklist worklist(cfg);
-  llvm::BitVector previouslyVisited(cfg.getNumBlockIDs());
-  worklist.enqueueSuccessors(&cfg.getEntry());
-  llvm::BitVector wasAnalyzed(cfg.getNumBlockIDs(), false);
-  wasAnalyzed[cfg.getEntry().getBlockID()] = true;
-
-  while (const CFGBlock *block = worklist.dequeue()) {
-    // Did the block change?
-    bool changed = runOnBlock(block, cfg, ac, vals,
-                              classification, wasAnalyzed);
-    ++stats.NumBlockVisits;
-    if (changed || !previouslyVisited[block->getBlockID()])
-      worklist.enqueueSuccessors(block);    
-    previouslyVisited[block->getBlockID()] = true;
-  }
+  llvm::BitVector entryVals(n * 2);
+  for (unsigned j = 0; j < n ; ++j)
+    setValueAt(entryVals, j, Uninitialized);
+
+  BitVectorDataflow &dataflow = vals.getDataflow();
+  dataflow.setBoundaryValues(entryVals);
+  BlockTransfer transfer(cfg, *View, ac, vals, classification);
+  dataflow.solve(transfer);
+  stats.NumBlockVisits += dataflow.getNumBlockVisits();
   
   // Run through the blocks one more time, and report uninitialized variabes.
+  llvm::BitVector blockVals;
   for (CFG::const_iterator BI = cfg.begin(), BE = cfg.end(); BI != BE; ++BI) {
     const CFGBlock *block = *BI;
-    if (wasAnalyzed[block->getBlockID()]) {
-      runOnBlock(block, cfg, ac, vals, classification, wasAnalyzed, &handler);
+    if (dataflow.wasAnalyzed(block)) {
+      blockVals = dataflow.getEntryValues(block);
+      runOnBlock(block, cfg, *View, ac, vals, blockVals, classification,
+                 &handler);
       ++stats.NumBlockVisits;
     }
   }
 }
 
+/// Determine whether the given statement might refer to the given variable.
+static bool mayReferToVar(const Stmt *s, const VarDecl *vd) {
+  if (const DeclRefExpr *dr = dyn_cast<DeclRefExpr>(s))
+    return dr->getDecl() == vd;
+  // A block captures variables without them appearing as children.
+  if (isa<BlockExpr>(s))
+    return true;
+  for (Stmt::const_child_range I = s->children(); I; ++I)
+    if (*I && mayReferToVar(*I, vd))
+      return true;
+  return false;
+}
+
+bool clang::mayHaveUninitializedUses(const DeclContext &dc,
+                                     bool mayBypassDecls) {
+  DeclContext::specific_decl_iterator<VarDecl> I(dc.decls_begin()),
+                                               E(dc.decls_end());
+  for ( ; I != E; ++I) {
+    const VarDecl *vd = *I;
+    if (!isTrackedVar(vd, &dc))
+      continue;
+    const Expr *init = vd->getInit();
+    if (!init || mayBypassDecls || mayReferToVar(init, vd))
+      return true;
+  }
+  return false;
+}
+
 UninitVariablesHandler::~UninitVariablesHandler() {}
@@ -74,7 +74,7 @@ ExternalIdentifierLookup::~ExternalIdentifierLookup() {}
 IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
                                  IdentifierInfoLookup* externalLookup)
   : HashTable(8192), // Start with space for 8K identifiers.
-    ExternalLookup(externalLookup) {
+    ExternalLookup(externalLookup), NewIdentifiers(0) {
 
   // Populate the identifier table with info about keywords for the current
   // language.
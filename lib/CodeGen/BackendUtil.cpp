@@ -13,18 +13,25 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Linker.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/CallSite.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/DataLayout.h"
@@ -35,6 +42,9 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
+#ifdef LLVM_ON_UNIX
+#include <pthread.h>
+#endif
 using namespace clang;
 using namespace llvm;
 
@@ -47,6 +57,10 @@ class EmitAssemblyHelper {
   const LangOptions &LangOpts;
   Module *TheModule;
 
+  /// Optimizer - The optimizer that ran the per-function passes on some of
+  /// the functions already, if any.
+  const FunctionOptimizer *Optimizer;
+
   Timer CodeGenerationTime;
 
   mutable PassManager *CodeGenPasses;
@@ -97,8 +111,29 @@ private:
     return PerFunctionPasses;
   }
 
+  /// CreatePasses - Add the per-function passes to \p FPM and, if given,
+  /// the per-module passes to \p MPM.
+  void CreatePasses(Module *M, FunctionPassManager &FPM,
+                    PassManager *MPM) const;
+
+  /// getNumPartitions - Decide how many partitions of the module to optimize
+  /// concurrently, and fill in \p Owners with the partition that owns each
+  /// function definition, in module order. Returns 0 if the module should be
+  /// optimized as a whole.
+  unsigned getNumPartitions(BackendAction Action,
+                            std::vector<unsigned> &Owners) const;
+
+  /// OptimizeInPartitions - Run the per-function and per-module passes on
+  /// \p NumPartitions partitions of the module concurrently, and link the
+  /// results back into the module.
+  ///
+  /// \return True on success.
+  bool OptimizeInPartitions(unsigned NumPartitions,
+                            const std::vector<unsigned> &Owners,
+                            TargetMachine *TM);
 
-  void CreatePasses(TargetMachine *TM);
+  /// ParseBackendOptions - Pass the options for the LLVM backend to it.
+  void ParseBackendOptions();
 
   /// CreateTargetMachine - Generates the TargetMachine.
   /// Returns Null if it is unable to create the target machine.
@@ -116,14 +151,21 @@ private:
   bool AddEmitPasses(BackendAction Action, formatted_raw_ostream &OS,
                      TargetMachine *TM);
 
+  /// RunPartitionJob - Optimize one partition of the module. This is the
+  /// entry point of the threads started by OptimizeInPartitions.
+  static void *RunPartitionJob(void *Job);
+
+  friend class clang::FunctionOptimizer;
+
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags,
                      const CodeGenOptions &CGOpts,
                      const clang::TargetOptions &TOpts,
                      const LangOptions &LOpts,
-                     Module *M)
+                     Module *M, const FunctionOptimizer *Optimizer = 0)
     : Diags(_Diags), CodeGenOpts(CGOpts), TargetOpts(TOpts), LangOpts(LOpts),
-      TheModule(M), CodeGenerationTime("Code Generation Time"),
+      TheModule(M), Optimizer(Optimizer),
+      CodeGenerationTime("Code Generation Time"),
       CodeGenPasses(0), PerModulePasses(0), PerFunctionPasses(0) {}
 
   ~EmitAssemblyHelper() {
@@ -168,7 +210,8 @@ static void addThreadSanitizerPass(const PassManagerBuilder &Builder,
   PM.add(createThreadSanitizerPass());
 }
 
-void EmitAssemblyHelper::CreatePasses(TargetMachine *TM) {
+void EmitAssemblyHelper::CreatePasses(Module *M, FunctionPassManager &FPM,
+                                      PassManager *MPM) const {
   unsigned OptLevel = CodeGenOpts.OptimizationLevel;
   CodeGenOptions::InliningMethod Inlining = CodeGenOpts.getInlining();
 
@@ -220,7 +263,7 @@ void EmitAssemblyHelper::CreatePasses(TargetMachine *TM) {
   }
 
   // Figure out TargetLibraryInfo.
-  Triple TargetTriple(TheModule->getTargetTriple());
+  Triple TargetTriple(M->getTargetTriple());
   PMBuilder.LibraryInfo = new TargetLibraryInfo(TargetTriple);
   if (!CodeGenOpts.SimplifyLibCalls)
     PMBuilder.LibraryInfo->disableAllFunctions();
@@ -250,14 +293,14 @@ void EmitAssemblyHelper::CreatePasses(TargetMachine *TM) {
   }
 
   // Set up the per-function pass manager.
-  FunctionPassManager *FPM = getPerFunctionPasses(TM);
   if (CodeGenOpts.VerifyModule)
-    FPM->add(createVerifierPass());
-  PMBuilder.populateFunctionPassManager(*FPM);
+    FPM.add(createVerifierPass());
+  PMBuilder.populateFunctionPassManager(FPM);
 
-  // Set up the per-module pass manager.
-  PassManager *MPM = getPerModulePasses(TM);
+  if (!MPM)
+    return;
 
+  // Set up the per-module pass manager.
   if (CodeGenOpts.EmitGcovArcs || CodeGenOpts.EmitGcovNotes) {
     MPM->add(createGCOVProfilerPass(CodeGenOpts.EmitGcovNotes,
                                     CodeGenOpts.EmitGcovArcs,
@@ -270,6 +313,28 @@ void EmitAssemblyHelper::CreatePasses(TargetMachine *TM) {
   PMBuilder.populateModulePassManager(*MPM);
 }
 
+void EmitAssemblyHelper::ParseBackendOptions() {
+  SmallVector<const char *, 16> BackendArgs;
+  BackendArgs.push_back("clang"); // Fake program name.
+  if (!CodeGenOpts.DebugPass.empty()) {
+    BackendArgs.push_back("-debug-pass");
+    BackendArgs.push_back(CodeGenOpts.DebugPass.c_str());
+  }
+  if (!CodeGenOpts.LimitFloatPrecision.empty()) {
+    BackendArgs.push_back("-limit-float-precision");
+    BackendArgs.push_back(CodeGenOpts.LimitFloatPrecision.c_str());
+  }
+  if (llvm::TimePassesIsEnabled)
+    BackendArgs.push_back("-time-passes");
+  for (unsigned i = 0, e = CodeGenOpts.BackendOptions.size(); i != e; ++i)
+    BackendArgs.push_back(CodeGenOpts.BackendOptions[i].c_str());
+  if (CodeGenOpts.NoGlobalMerge)
+    BackendArgs.push_back("-global-merge=false");
+  BackendArgs.push_back(0);
+  llvm::cl::ParseCommandLineOptions(BackendArgs.size() - 1,
+                                    BackendArgs.data());
+}
+
 TargetMachine *EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   // Create the TargetMachine for generating code.
   std::string Error;
@@ -305,25 +370,9 @@ TargetMachine *EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
     CM = llvm::CodeModel::Default;
   }
 
-  SmallVector<const char *, 16> BackendArgs;
-  BackendArgs.push_back("clang"); // Fake program name.
-  if (!CodeGenOpts.DebugPass.empty()) {
-    BackendArgs.push_back("-debug-pass");
-    BackendArgs.push_back(CodeGenOpts.DebugPass.c_str());
-  }
-  if (!CodeGenOpts.LimitFloatPrecision.empty()) {
-    BackendArgs.push_back("-limit-float-precision");
-    BackendArgs.push_back(CodeGenOpts.LimitFloatPrecision.c_str());
-  }
-  if (llvm::TimePassesIsEnabled)
-    BackendArgs.push_back("-time-passes");
-  for (unsigned i = 0, e = CodeGenOpts.BackendOptions.size(); i != e; ++i)
-    BackendArgs.push_back(CodeGenOpts.BackendOptions[i].c_str());
-  if (CodeGenOpts.NoGlobalMerge)
-    BackendArgs.push_back("-global-merge=false");
-  BackendArgs.push_back(0);
-  llvm::cl::ParseCommandLineOptions(BackendArgs.size() - 1,
-                                    BackendArgs.data());
+  // The optimizer has parsed the backend options already.
+  if (!Optimizer)
+    ParseBackendOptions();
 
   std::string FeaturesStr;
   if (TargetOpts.Features.size()) {
@@ -468,6 +517,436 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   return true;
 }
 
+namespace {
+
+/// PartitionJob - The optimization of one partition of a module.
+struct PartitionJob {
+  const EmitAssemblyHelper *Helper;
+  TargetMachine *TM;
+
+  /// Bitcode - The whole module, before optimization.
+  StringRef Bitcode;
+
+  /// Owners - The partition that owns each function definition.
+  const std::vector<unsigned> *Owners;
+
+  /// Copied - Whether each function definition that the partition does not
+  /// own is copied into it, so that it can be inlined there.
+  std::vector<bool> Copied;
+
+  /// Optimized - Whether each function definition has already been through
+  /// the per-function passes.
+  const std::vector<bool> *Optimized;
+
+  /// Index - The partition to optimize.
+  unsigned Index;
+
+  /// Result - The optimized partition, as bitcode.
+  SmallVector<char, 0> Result;
+
+  /// Error - The reason the partition could not be optimized, if any.
+  std::string Error;
+};
+
+/// PromotedSymbol - A symbol whose linkage was changed so that it can be
+/// referenced from, and is kept alive by, every partition of a module.
+struct PromotedSymbol {
+  std::string Name;
+  GlobalValue::LinkageTypes Linkage;
+  GlobalValue::VisibilityTypes Visibility;
+};
+
+}
+
+/// Give \p GV a linkage that lets other partitions refer to it and that the
+/// optimizer cannot discard, remembering its original linkage in \p Promoted.
+static void promoteForPartitioning(GlobalValue *GV,
+                                   std::vector<PromotedSymbol> &Promoted) {
+  GlobalValue::LinkageTypes Linkage = GV->getLinkage();
+  GlobalValue::LinkageTypes NewLinkage;
+  if (GlobalValue::isLocalLinkage(Linkage))
+    NewLinkage = GlobalValue::ExternalLinkage;
+  else if (Linkage == GlobalValue::LinkOnceAnyLinkage)
+    NewLinkage = GlobalValue::WeakAnyLinkage;
+  else if (GlobalValue::isLinkOnceLinkage(Linkage))
+    NewLinkage = GlobalValue::WeakODRLinkage;
+  else
+    return;
+
+  PromotedSymbol Symbol;
+  Symbol.Name = GV->getName();
+  Symbol.Linkage = Linkage;
+  Symbol.Visibility = GV->getVisibility();
+  Promoted.push_back(Symbol);
+
+  GV->setLinkage(NewLinkage);
+  if (GlobalValue::isLocalLinkage(Linkage))
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+}
+
+unsigned EmitAssemblyHelper::getNumPartitions(
+    BackendAction Action, std::vector<unsigned> &Owners) const {
+  if (CodeGenOpts.BackendThreads < 2 || Action == Backend_EmitNothing ||
+      CodeGenOpts.OptimizationLevel == 0 || CodeGenOpts.DisableLLVMOpts)
+    return 0;
+
+  // Instrumentation passes create state for the whole module, and debug info
+  // and pass timers cannot be split or shared between threads.
+  if (CodeGenOpts.EmitGcovArcs || CodeGenOpts.EmitGcovNotes ||
+      LangOpts.SanitizeAddress || LangOpts.SanitizeThread ||
+      CodeGenOpts.getDebugInfo() != CodeGenOptions::NoDebugInfo ||
+      llvm::TimePassesIsEnabled)
+    return 0;
+
+  // Module-level asm, aliases and named metadata would be duplicated or lost
+  // when the partitions are linked back together.
+  if (!TheModule->getModuleInlineAsm().empty() || !TheModule->alias_empty())
+    return 0;
+  for (Module::const_named_metadata_iterator
+         I = TheModule->named_metadata_begin(),
+         E = TheModule->named_metadata_end(); I != E; ++I)
+    if (I->getName() != "llvm.module.flags")
+      return 0;
+
+  // Partitions refer to each other's symbols by name.
+  for (Module::const_global_iterator I = TheModule->global_begin(),
+         E = TheModule->global_end(); I != E; ++I) {
+    if (!I->hasName() || (I->hasAppendingLinkage() && !I->use_empty()))
+      return 0;
+  }
+
+  // Split the function definitions, in module order, into partitions of
+  // about the same number of instructions, so that the result does not
+  // depend on anything but the module.
+  SmallVector<uint64_t, 64> Sizes;
+  uint64_t TotalSize = 0;
+  for (Module::const_iterator F = TheModule->begin(), FE = TheModule->end();
+       F != FE; ++F) {
+    if (!F->hasName())
+      return 0;
+    if (F->isDeclaration())
+      continue;
+    uint64_t Size = 0;
+    for (Function::const_iterator BB = F->begin(), BE = F->end();
+         BB != BE; ++BB) {
+      // A block address cannot refer to a block in another partition.
+      if (BB->hasAddressTaken())
+        return 0;
+      Size += BB->size();
+    }
+    Sizes.push_back(Size);
+    TotalSize += Size;
+  }
+
+  unsigned NumPartitions = std::min<uint64_t>(CodeGenOpts.BackendThreads,
+                                              Sizes.size());
+  if (NumPartitions < 2)
+    return 0;
+
+  // Number the partitions consecutively, even if a large function covers
+  // more than its share.
+  Owners.clear();
+  unsigned Partition = 0;
+  uint64_t LastShare = 0;
+  uint64_t Size = 0;
+  for (unsigned I = 0, N = Sizes.size(); I != N; ++I) {
+    uint64_t Share = Size * NumPartitions / TotalSize;
+    if (Share != LastShare) {
+      ++Partition;
+      LastShare = Share;
+    }
+    Owners.push_back(Partition);
+    Size += Sizes[I];
+  }
+  return Partition ? Partition + 1 : 0;
+}
+
+/// InlineCopySizeLimit - The number of instructions above which a function is
+/// not copied into other partitions for inlining. The inliner's default
+/// threshold of 225 amounts to about 45 instructions.
+static const unsigned InlineCopySizeLimit = 50;
+
+/// Whether the partitions that do not own \p F should get a copy of it, so
+/// that they can inline it.
+static bool shouldCopyForInlining(const Function &F) {
+  // The definition of any other function might be replaced at link time, so
+  // it must not be inlined.
+  if (!F.hasLocalLinkage() &&
+      F.getLinkage() != GlobalValue::LinkOnceODRLinkage)
+    return false;
+
+  Attributes Attrs = F.getFnAttributes();
+  if (Attrs.hasAttribute(Attributes::NoInline))
+    return false;
+  if (Attrs.hasAttribute(Attributes::AlwaysInline))
+    return true;
+
+  unsigned Size = 0;
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    Size += BB->size();
+  return Size <= InlineCopySizeLimit;
+}
+
+/// Fill in the Copied vector of each job in \p Jobs: a partition gets a copy
+/// of the small local and linkonce_odr functions owned by other partitions
+/// that its own functions call directly. Copying any more would have each
+/// thread optimize most of the module again.
+static void findCopiedFunctions(Module &M, const std::vector<unsigned> &Owners,
+                                std::vector<PartitionJob> &Jobs) {
+  DenseMap<const Function *, unsigned> Definitions;
+  std::vector<bool> Copyable;
+  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+    Definitions[F] = Copyable.size();
+    Copyable.push_back(shouldCopyForInlining(*F));
+  }
+
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+    Jobs[I].Copied.assign(Copyable.size(), false);
+
+  unsigned Definition = 0;
+  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+    unsigned Owner = Owners[Definition++];
+    for (Function::const_iterator BB = F->begin(), BE = F->end();
+         BB != BE; ++BB) {
+      for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+           I != IE; ++I) {
+        ImmutableCallSite CS(I);
+        if (!CS || !CS.getCalledFunction())
+          continue;
+        DenseMap<const Function *, unsigned>::iterator Callee =
+          Definitions.find(CS.getCalledFunction());
+        if (Callee != Definitions.end() && Copyable[Callee->second] &&
+            Owners[Callee->second] != Owner)
+          Jobs[Owner].Copied[Callee->second] = true;
+      }
+    }
+  }
+}
+
+void *EmitAssemblyHelper::RunPartitionJob(void *JobPtr) {
+  PartitionJob &Job = *static_cast<PartitionJob *>(JobPtr);
+  const EmitAssemblyHelper &Helper = *Job.Helper;
+
+  // Each partition lives in its own context, so that the threads do not
+  // share any IR. Only the function bodies the partition needs are read.
+  LLVMContext Context;
+  MemoryBuffer *Buffer =
+    MemoryBuffer::getMemBuffer(Job.Bitcode, "", /*RequiresNullTerminator=*/
+                               false);
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, Context, &Job.Error));
+  if (!M) {
+    delete Buffer;
+    return 0;
+  }
+
+  // Read the function definitions this partition owns, and the copies of
+  // other definitions it may inline: the partition that owns those emits
+  // them, however many calls the others inline. Only the owned functions
+  // which the optimizer has not been through yet get the per-function passes.
+  SmallVector<Function *, 64> ToOptimize;
+  unsigned Definition = 0;
+  for (Module::iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    if (!F->isMaterializable())
+      continue;
+    unsigned Index = Definition++;
+    bool Owned = (*Job.Owners)[Index] == Job.Index;
+    if (!Owned && !Job.Copied[Index]) {
+      // Left unread, this is a declaration.
+      F->setLinkage(GlobalValue::ExternalLinkage);
+      continue;
+    }
+    if (F->Materialize(&Job.Error))
+      return 0;
+    if (!Owned)
+      F->setLinkage(GlobalValue::AvailableExternallyLinkage);
+    else if (!(*Job.Optimized)[Index])
+      ToOptimize.push_back(F);
+  }
+
+  // The first partition owns all the variables. The others keep a copy of
+  // the constants whose initializer cannot be replaced at link time, such
+  // as string literals and vtables, so that they can still fold loads from
+  // them.
+  if (Job.Index != 0) {
+    for (Module::global_iterator I = M->global_begin(),
+           E = M->global_end(); I != E; ) {
+      GlobalVariable *GV = I++;
+      if (GV->hasAppendingLinkage()) {
+        GV->eraseFromParent();
+      } else if (GV->hasInitializer()) {
+        if (GV->isConstant() &&
+            (GV->hasExternalLinkage() ||
+             GV->getLinkage() == GlobalValue::WeakODRLinkage)) {
+          GV->setLinkage(GlobalValue::AvailableExternallyLinkage);
+        } else {
+          GV->setInitializer(0);
+          GV->setLinkage(GlobalValue::ExternalLinkage);
+        }
+      }
+    }
+  }
+
+  FunctionPassManager FPM(M.get());
+  PassManager MPM;
+  FPM.add(new DataLayout(M.get()));
+  MPM.add(new DataLayout(M.get()));
+  if (Job.TM) {
+    FPM.add(new TargetTransformInfo(Job.TM->getScalarTargetTransformInfo(),
+                                    Job.TM->getVectorTargetTransformInfo()));
+    MPM.add(new TargetTransformInfo(Job.TM->getScalarTargetTransformInfo(),
+                                    Job.TM->getVectorTargetTransformInfo()));
+  }
+  Helper.CreatePasses(M.get(), FPM, &MPM);
+
+  FPM.doInitialization();
+  for (unsigned I = 0, N = ToOptimize.size(); I != N; ++I)
+    FPM.run(*ToOptimize[I]);
+  FPM.doFinalization();
+  MPM.run(*M);
+
+  // Drop the copies that were only kept for optimizing this partition.
+  for (Module::iterator F = M->begin(), FE = M->end(); F != FE; ++F)
+    if (F->hasAvailableExternallyLinkage())
+      F->deleteBody();
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I) {
+    if (I->hasAvailableExternallyLinkage()) {
+      I->setInitializer(0);
+      I->setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+
+  raw_svector_ostream OS(Job.Result);
+  WriteBitcodeToFile(M.get(), OS);
+  OS.flush();
+  return 0;
+}
+
+/// Run \p Jobs, on separate threads if LLVM was built with thread support.
+static void runPartitionJobs(std::vector<PartitionJob> &Jobs,
+                             void *(*Run)(void *)) {
+#ifdef LLVM_ON_UNIX
+  if (llvm_is_multithreaded() || llvm_start_multithreaded()) {
+    pthread_attr_t Attr;
+    ::pthread_attr_init(&Attr);
+    // The optimizer can recurse deeply on large functions; don't rely on the
+    // platform's default stack size for secondary threads.
+    ::pthread_attr_setstacksize(&Attr, 8 << 20);
+
+    std::vector<pthread_t> Threads(Jobs.size());
+    std::vector<bool> Started(Jobs.size());
+    for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+      Started[I] = ::pthread_create(&Threads[I], &Attr, Run, &Jobs[I]) == 0;
+    ::pthread_attr_destroy(&Attr);
+
+    for (unsigned I = 0, N = Jobs.size(); I != N; ++I) {
+      if (Started[I])
+        ::pthread_join(Threads[I], 0);
+      else
+        Run(&Jobs[I]);
+    }
+    return;
+  }
+#endif
+
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+    Run(&Jobs[I]);
+}
+
+bool EmitAssemblyHelper::OptimizeInPartitions(
+    unsigned NumPartitions, const std::vector<unsigned> &Owners,
+    TargetMachine *TM) {
+  // Let the partitions refer to the symbols defined in other partitions, and
+  // keep the optimizer from discarding definitions which are only used by
+  // other partitions.
+  std::vector<PromotedSymbol> Promoted;
+  std::vector<PartitionJob> Jobs(NumPartitions);
+  std::vector<bool> Optimized;
+  findCopiedFunctions(*TheModule, Owners, Jobs);
+  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+       F != E; ++F) {
+    if (!F->isDeclaration())
+      Optimized.push_back(Optimizer && Optimizer->isOptimized(F));
+    promoteForPartitioning(F, Promoted);
+  }
+  for (Module::global_iterator I = TheModule->global_begin(),
+         E = TheModule->global_end(); I != E; ++I)
+    promoteForPartitioning(I, Promoted);
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(TheModule, OS);
+  }
+
+  for (unsigned I = 0; I != NumPartitions; ++I) {
+    Jobs[I].Helper = this;
+    Jobs[I].TM = TM;
+    Jobs[I].Bitcode = StringRef(Bitcode.data(), Bitcode.size());
+    Jobs[I].Owners = &Owners;
+    Jobs[I].Optimized = &Optimized;
+    Jobs[I].Index = I;
+  }
+  runPartitionJobs(Jobs, RunPartitionJob);
+
+  // Replace the contents of the module by the optimized partitions, linked in
+  // partition order so that the output does not depend on which thread
+  // finished first.
+  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+       F != E; ++F)
+    if (!F->isDeclaration())
+      F->deleteBody();
+  for (Module::global_iterator I = TheModule->global_begin(),
+         E = TheModule->global_end(); I != E; ) {
+    GlobalVariable *GV = I++;
+    if (GV->hasAppendingLinkage()) {
+      GV->eraseFromParent();
+    } else if (GV->hasInitializer()) {
+      GV->setInitializer(0);
+      GV->setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+
+  for (unsigned I = 0; I != NumPartitions; ++I) {
+    std::string Error = Jobs[I].Error;
+    OwningPtr<MemoryBuffer> Buffer(
+      MemoryBuffer::getMemBuffer(StringRef(Jobs[I].Result.data(),
+                                           Jobs[I].Result.size()),
+                                 "", /*RequiresNullTerminator=*/false));
+    OwningPtr<Module> Partition;
+    if (Error.empty())
+      Partition.reset(ParseBitcodeFile(Buffer.get(), TheModule->getContext(),
+                                       &Error));
+    if (!Partition ||
+        Linker::LinkModules(TheModule, Partition.get(),
+                            Linker::DestroySource, &Error)) {
+      Diags.Report(diag::err_fe_error_backend) << Error;
+      return false;
+    }
+  }
+
+  for (unsigned I = 0, N = Promoted.size(); I != N; ++I) {
+    GlobalValue *GV = TheModule->getNamedValue(Promoted[I].Name);
+    if (!GV || GV->isDeclaration())
+      continue;
+    GV->setLinkage(Promoted[I].Linkage);
+    GV->setVisibility(Promoted[I].Visibility);
+  }
+
+  // The partitions could not tell which of the symbols that were local are
+  // still used.
+  PassManager PM;
+  PM.add(createGlobalDCEPass());
+  if (CodeGenOpts.VerifyModule)
+    PM.add(createVerifierPass());
+  PM.run(*TheModule);
+  return true;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : 0);
   llvm::formatted_raw_ostream FormattedOS;
@@ -476,7 +955,12 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
                       Action != Backend_EmitBC &&
                       Action != Backend_EmitLL);
   TargetMachine *TM = CreateTargetMachine(UsesCodeGen);
-  CreatePasses(TM);
+
+  std::vector<unsigned> Owners;
+  unsigned NumPartitions = getNumPartitions(Action, Owners);
+  if (!NumPartitions)
+    CreatePasses(TheModule, *getPerFunctionPasses(TM),
+                 getPerModulePasses(TM));
 
   switch (Action) {
   case Backend_EmitNothing:
@@ -503,13 +987,19 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
   // Run passes. For now we do all passes at once, but eventually we
   // would like to have the option of streaming code generation.
 
+  if (NumPartitions) {
+    PrettyStackTraceString CrashInfo("Partitioned optimization passes");
+    if (!OptimizeInPartitions(NumPartitions, Owners, TM))
+      return;
+  }
+
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
 
     PerFunctionPasses->doInitialization();
     for (Module::iterator I = TheModule->begin(),
            E = TheModule->end(); I != E; ++I)
-      if (!I->isDeclaration())
+      if (!I->isDeclaration() && !(Optimizer && Optimizer->isOptimized(I)))
         PerFunctionPasses->run(*I);
     PerFunctionPasses->doFinalization();
   }
@@ -530,8 +1020,51 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const clang::TargetOptions &TOpts,
                               const LangOptions &LOpts,
                               Module *M,
-                              BackendAction Action, raw_ostream *OS) {
-  EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M);
+                              BackendAction Action, raw_ostream *OS,
+                              const FunctionOptimizer *Optimizer) {
+  EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M, Optimizer);
 
   AsmHelper.EmitAssembly(Action, OS);
 }
+
+FunctionOptimizer::FunctionOptimizer(DiagnosticsEngine &Diags,
+                                     const CodeGenOptions &CGOpts,
+                                     const clang::TargetOptions &TOpts,
+                                     const LangOptions &LOpts, Module *M)
+  : Initialized(false) {
+  EmitAssemblyHelper Helper(Diags, CGOpts, TOpts, LOpts, M);
+  TM.reset(Helper.CreateTargetMachine(/*MustCreateTM=*/false));
+
+  // The ARC passes decide whether to run from the runtime functions the
+  // whole module declares; leave ARC code to the backend.
+  if (CGOpts.OptimizationLevel == 0 || CGOpts.DisableLLVMOpts ||
+      LOpts.ObjCAutoRefCount)
+    return;
+
+  // The same passes as EmitBackendOutput runs on each function.
+  Passes.reset(new FunctionPassManager(M));
+  Passes->add(new DataLayout(M));
+  if (TM)
+    Passes->add(new TargetTransformInfo(TM->getScalarTargetTransformInfo(),
+                                        TM->getVectorTargetTransformInfo()));
+  Helper.CreatePasses(M, *Passes, /*MPM=*/0);
+}
+
+FunctionOptimizer::~FunctionOptimizer() {}
+
+void FunctionOptimizer::optimize(Function *F) {
+  if (!Passes || !Optimized.insert(F))
+    return;
+
+  // Nothing has been generated yet when the optimizer is created.
+  if (!Initialized) {
+    Passes->doInitialization();
+    Initialized = true;
+  }
+  Passes->run(*F);
+}
+
+void FunctionOptimizer::finish() {
+  if (Initialized)
+    Passes->doFinalization();
+}
@@ -535,6 +535,33 @@ llvm::DIType CGDebugInfo::createRecordFwdDecl(const RecordDecl *RD,
   return DBuilder.createForwardDecl(Tag, RDName, Ctx, DefUnit, Line);
 }
 
+/// isDescribedElsewhere - Each translation unit that uses a class would
+/// otherwise describe it in full. A dynamic class is described where its
+/// vtable is emitted, that is, by the translation unit that defines its key
+/// function, and a class template specialization with an explicit
+/// instantiation declaration is described where it is explicitly
+/// instantiated. The one definition rule guarantees that both exist somewhere
+/// in the program, so other translation units only need a declaration.
+bool CGDebugInfo::isDescribedElsewhere(const RecordDecl *RD) {
+  if (CGM.getCodeGenOpts().getDebugInfo() != CodeGenOptions::LimitedDebugInfo)
+    return false;
+
+  const CXXRecordDecl *CXXDecl = dyn_cast<CXXRecordDecl>(RD);
+  if (!CXXDecl || !CXXDecl->hasDefinition() || CXXDecl->isInvalidDecl())
+    return false;
+  CXXDecl = CXXDecl->getDefinition();
+
+  if (const ClassTemplateSpecializationDecl *Spec
+        = dyn_cast<ClassTemplateSpecializationDecl>(CXXDecl))
+    if (Spec->getSpecializationKind() == TSK_ExplicitInstantiationDeclaration)
+      return true;
+
+  if (!CXXDecl->isDynamicClass())
+    return false;
+  const CXXMethodDecl *KeyFunction = CGM.getContext().getKeyFunction(CXXDecl);
+  return KeyFunction && !KeyFunction->hasBody();
+}
+
 // Walk up the context chain and create forward decls for record decls,
 // and normal descriptors for namespaces.
 llvm::DIDescriptor CGDebugInfo::createContextChain(const Decl *Context) {
@@ -1236,6 +1263,14 @@ llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty) {
   // may refer to the forward decl if the struct is recursive) and replace all
   // uses of the forward declaration with the final definition.
 
+  // Only declare records whose full description is emitted elsewhere.
+  if (isDescribedElsewhere(RD)) {
+    DeclOnlyTypes.insert(Ty);
+    llvm::DIDescriptor RDContext =
+      createContextChain(cast<Decl>(RD->getDeclContext()));
+    return createRecordFwdDecl(RD, RDContext);
+  }
+
   llvm::DIType FwdDecl = getOrCreateLimitedType(QualType(Ty, 0), DefUnit);
 
   if (FwdDecl.isForwardDecl())
@@ -2783,6 +2818,15 @@ CGDebugInfo::getOrCreateNameSpace(const NamespaceDecl *NSDecl) {
 }
 
 void CGDebugInfo::finalize(void) {
+  // Complete the records we only declared if their key function or explicit
+  // instantiation turned out to be in this translation unit. Completing them
+  // can declare more records, so the set may grow as we walk it.
+  for (unsigned I = 0; I != DeclOnlyTypes.size(); ++I) {
+    const RecordType *Ty = DeclOnlyTypes[I];
+    if (!isDescribedElsewhere(Ty->getDecl()))
+      getOrCreateType(QualType(Ty, 0), getOrCreateMainFile());
+  }
+
   for (std::vector<std::pair<void *, llvm::WeakVH> >::const_iterator VI
          = ReplaceMap.begin(), VE = ReplaceMap.end(); VI != VE; ++VI) {
     llvm::DIType Ty, RepTy;
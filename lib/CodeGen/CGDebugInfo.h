@@ -20,6 +20,7 @@
 #include "llvm/DebugInfo.h"
 #include "llvm/DIBuilder.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/ValueHandle.h"
 #include "llvm/Support/Allocator.h"
 
@@ -64,6 +65,11 @@ class CGDebugInfo {
   /// compilation.
   std::vector<std::pair<void *, llvm::WeakVH> >ReplaceMap;
 
+  /// DeclOnlyTypes - Records that were only declared because their full
+  /// description is emitted by another translation unit. They are completed
+  /// at the end of compilation if this one turns out to define them.
+  llvm::SetVector<const RecordType *> DeclOnlyTypes;
+
   bool BlockLiteralGenericSet;
   llvm::DIType BlockLiteralGeneric;
 
@@ -256,6 +262,11 @@ private:
   /// createContextChain - Create a set of decls for the context chain.
   llvm::DIDescriptor createContextChain(const Decl *Decl);
 
+  /// isDescribedElsewhere - Whether the full debug info for the record is
+  /// emitted by another translation unit, so that this one only needs to
+  /// declare it.
+  bool isDescribedElsewhere(const RecordDecl *RD);
+
   /// getCurrentDirname - Return current directory name.
   StringRef getCurrentDirname();
 
@@ -159,7 +159,8 @@ namespace clang {
       Ctx.setInlineAsmDiagnosticHandler(InlineAsmDiagHandler, this);
 
       EmitBackendOutput(Diags, CodeGenOpts, TargetOpts, LangOpts,
-                        TheModule.get(), Action, AsmOutStream);
+                        TheModule.get(), Action, AsmOutStream,
+                        Gen->getFunctionOptimizer());
       
       Ctx.setInlineAsmDiagnosticHandler(OldHandler, OldContext);
     }
@@ -37,6 +37,7 @@
 #include "clang/Basic/ConvertUTF.h"
 #include "llvm/CallingConv.h"
 #include "llvm/Module.h"
+#include "llvm/Pass.h"
 #include "llvm/Intrinsics.h"
 #include "llvm/LLVMContext.h"
 #include "llvm/ADT/APSInt.h"
@@ -77,6 +78,7 @@ CodeGenModule::CodeGenModule(ASTContext &C, const CodeGenOptions &CGO,
     NSConcreteGlobalBlock(0), NSConcreteStackBlock(0),
     BlockObjectAssign(0), BlockObjectDispose(0),
     BlockDescriptorType(0), GenericBlockLiteralType(0) {
+  ManglingTime.init("Name Mangling Time");
       
   // Initialize the type cache.
   llvm::LLVMContext &LLVMContext = M.getContext();
@@ -384,6 +386,7 @@ StringRef CodeGenModule::getMangledName(GlobalDecl GD) {
     return Str;
   }
   
+  llvm::TimeRegion Region(llvm::TimePassesIsEnabled ? &ManglingTime : 0);
   SmallString<256> Buffer;
   llvm::raw_svector_ostream Out(Buffer);
   if (const CXXConstructorDecl *D = dyn_cast<CXXConstructorDecl>(ND))
@@ -427,6 +430,18 @@ llvm::GlobalValue *CodeGenModule::GetGlobalValue(StringRef Name) {
   return getModule().getNamedValue(Name);
 }
 
+llvm::Function *CodeGenModule::getDefinedFunction(GlobalDecl GD) {
+  const llvm::GlobalValue *GV = GetGlobalValue(getMangledName(GD));
+  if (const llvm::GlobalAlias *GA = dyn_cast_or_null<llvm::GlobalAlias>(GV))
+    GV = GA->resolveAliasedGlobal();
+
+  llvm::Function *Fn = const_cast<llvm::Function *>(
+                         dyn_cast_or_null<llvm::Function>(GV));
+  if (!Fn || Fn->isDeclaration())
+    return 0;
+  return Fn;
+}
+
 /// AddGlobalCtor - Add a function to the list that will be called before
 /// main() runs.
 void CodeGenModule::AddGlobalCtor(llvm::Function * Ctor, int Priority) {
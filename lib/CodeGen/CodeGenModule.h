@@ -27,6 +27,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/ValueHandle.h"
 
 namespace llvm {
@@ -271,6 +272,10 @@ class CodeGenModule : public CodeGenTypeCache {
   /// MangledDeclNames - A map of canonical GlobalDecls to their mangled names.
   llvm::DenseMap<GlobalDecl, StringRef> MangledDeclNames;
   llvm::BumpPtrAllocator MangledNamesAllocator;
+
+  /// ManglingTime - The time spent mangling the names in MangledDeclNames,
+  /// reported by -ftime-report.
+  llvm::Timer ManglingTime;
   
   /// Global annotations.
   std::vector<llvm::Constant*> Annotations;
@@ -826,6 +831,11 @@ public:
                               unsigned &CallingConv);
 
   StringRef getMangledName(GlobalDecl GD);
+
+  /// getDefinedFunction - Return the function that has been emitted for GD,
+  /// looking through aliases, or null if it has not been emitted (yet).
+  llvm::Function *getDefinedFunction(GlobalDecl GD);
+
   void getBlockMangledName(GlobalDecl GD, MangleBuffer &Buffer,
                            const BlockDecl *BD);
 
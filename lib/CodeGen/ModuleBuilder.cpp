@@ -13,8 +13,10 @@
 
 #include "clang/CodeGen/ModuleBuilder.h"
 #include "CodeGenModule.h"
+#include "clang/CodeGen/BackendUtil.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/Diagnostic.h"
@@ -34,6 +36,84 @@ namespace {
   protected:
     OwningPtr<llvm::Module> M;
     OwningPtr<CodeGen::CodeGenModule> Builder;
+
+    /// Optimizer - With -stream-functions, runs the per-function
+    /// optimizations on each function as soon as it has been generated.
+    OwningPtr<FunctionOptimizer> Optimizer;
+
+    /// FinishGeneratedFunctions - Optimize the functions that have just been
+    /// generated for the top-level declaration D if -stream-functions is on,
+    /// and release the bodies that nothing will read again.
+    void FinishGeneratedFunctions(Decl *D) {
+      if (NamespaceDecl *NS = dyn_cast<NamespaceDecl>(D)) {
+        for (DeclContext::decl_iterator I = NS->decls_begin(),
+                                        E = NS->decls_end(); I != E; ++I)
+          FinishGeneratedFunctions(*I);
+        return;
+      }
+      if (LinkageSpecDecl *LS = dyn_cast<LinkageSpecDecl>(D)) {
+        for (DeclContext::decl_iterator I = LS->decls_begin(),
+                                        E = LS->decls_end(); I != E; ++I)
+          FinishGeneratedFunctions(*I);
+        return;
+      }
+
+      FunctionDecl *FD = dyn_cast<FunctionDecl>(D);
+      if (!FD || !FD->doesThisDeclarationHaveABody())
+        return;
+
+      // Constructors and destructors are generated once per variant.
+      SmallVector<GlobalDecl, 3> Variants;
+      if (CXXConstructorDecl *CD = dyn_cast<CXXConstructorDecl>(FD)) {
+        Variants.push_back(GlobalDecl(CD, Ctor_Complete));
+        Variants.push_back(GlobalDecl(CD, Ctor_Base));
+      } else if (CXXDestructorDecl *DD = dyn_cast<CXXDestructorDecl>(FD)) {
+        if (DD->isVirtual())
+          Variants.push_back(GlobalDecl(DD, Dtor_Deleting));
+        Variants.push_back(GlobalDecl(DD, Dtor_Complete));
+        Variants.push_back(GlobalDecl(DD, Dtor_Base));
+      } else
+        Variants.push_back(GlobalDecl(FD));
+
+      // Functions whose generation was deferred are left for the end of the
+      // translation unit.
+      bool AllDefined = true;
+      for (unsigned I = 0, N = Variants.size(); I != N; ++I) {
+        llvm::Function *Fn = Builder->getDefinedFunction(Variants[I]);
+        if (!Fn) {
+          AllDefined = false;
+          continue;
+        }
+        if (Optimizer)
+          Optimizer->optimize(Fn);
+      }
+
+      if (AllDefined && CanReleaseBody(FD))
+        Ctx->releaseFunctionBody(FD);
+    }
+
+    /// CanReleaseBody - Whether anything might read the body of FD after it
+    /// has been generated. Inline and constexpr functions may be evaluated or
+    /// generated again, templates may be instantiated again, and the bodies
+    /// of local classes, lambdas and blocks are generated later on. Sema
+    /// checks the initializers of delegating constructors for cycles at the
+    /// end of the translation unit.
+    static bool CanReleaseBody(const FunctionDecl *FD) {
+      if (FD->isInlined() || FD->isConstexpr() || FD->isDependentContext() ||
+          FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate)
+        return false;
+
+      if (const CXXConstructorDecl *CD = dyn_cast<CXXConstructorDecl>(FD))
+        if (CD->isDelegatingConstructor())
+          return false;
+
+      for (DeclContext::decl_iterator I = FD->decls_begin(),
+                                      E = FD->decls_end(); I != E; ++I)
+        if (isa<DeclContext>(*I))
+          return false;
+      return true;
+    }
+
   public:
     CodeGeneratorImpl(DiagnosticsEngine &diags, const std::string& ModuleName,
                       const CodeGenOptions &CGO, llvm::LLVMContext& C)
@@ -49,6 +129,10 @@ namespace {
       return M.take();
     }
 
+    virtual const FunctionOptimizer *getFunctionOptimizer() {
+      return Optimizer.get();
+    }
+
     virtual void Initialize(ASTContext &Context) {
       Ctx = &Context;
 
@@ -57,6 +141,13 @@ namespace {
       TD.reset(new llvm::DataLayout(Ctx->getTargetInfo().getTargetDescription()));
       Builder.reset(new CodeGen::CodeGenModule(Context, CodeGenOpts,
                                                *M, *TD, Diags));
+      if (CodeGenOpts.StreamFunctions)
+        Optimizer.reset(
+          new FunctionOptimizer(Diags, CodeGenOpts,
+                                Ctx->getTargetInfo().getTargetOpts(),
+                                Ctx->getLangOpts(), M.get()));
+      if (CodeGenOpts.StreamFunctions || CodeGenOpts.FreeASTAfterCodeGen)
+        Context.setSeparateBodyAllocation(true);
     }
 
     virtual void HandleCXXStaticMemberVarInstantiation(VarDecl *VD) {
@@ -65,8 +156,12 @@ namespace {
 
     virtual bool HandleTopLevelDecl(DeclGroupRef DG) {
       // Make sure to emit all elements of a Decl.
-      for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I)
+      for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I) {
         Builder->EmitTopLevelDecl(*I);
+        if ((CodeGenOpts.StreamFunctions || CodeGenOpts.FreeASTAfterCodeGen) &&
+            !Diags.hasErrorOccurred())
+          FinishGeneratedFunctions(*I);
+      }
       return true;
     }
 
@@ -93,12 +188,15 @@ namespace {
 
     virtual void HandleTranslationUnit(ASTContext &Ctx) {
       if (Diags.hasErrorOccurred()) {
+        Optimizer.reset();
         M.reset();
         return;
       }
 
       if (Builder)
         Builder->Release();
+      if (Optimizer)
+        Optimizer->finish();
     }
 
     virtual void CompleteTentativeDefinition(VarDecl *D) {
@@ -1626,9 +1626,12 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   } else if (isa<MigrateJobAction>(JA)) {
     CmdArgs.push_back("-migrate");
   } else if (isa<PreprocessJobAction>(JA)) {
-    if (Output.getType() == types::TY_Dependencies)
+    if (Output.getType() == types::TY_Dependencies) {
       CmdArgs.push_back("-Eonly");
-    else
+      // Nothing looks at the tokens when only computing dependencies, so the
+      // preprocessor only needs to see the directives.
+      CmdArgs.push_back("-fast-dependency-scan");
+    } else
       CmdArgs.push_back("-E");
   } else if (isa<AssembleJobAction>(JA)) {
     CmdArgs.push_back("-emit-obj");
@@ -2356,6 +2359,16 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(A->getValue());
   }
 
+  if (Arg *A = Args.getLastArg(options::OPT_ftypo_correction_time_limit_EQ)) {
+    CmdArgs.push_back("-ftypo-correction-time-limit");
+    CmdArgs.push_back(A->getValue());
+  }
+
+  if (Arg *A = Args.getLastArg(options::OPT_fbackend_threads_EQ)) {
+    CmdArgs.push_back("-backend-threads");
+    CmdArgs.push_back(A->getValue());
+  }
+
   if (Arg *A = Args.getLastArg(options::OPT_Wlarge_by_value_copy_EQ,
                                options::OPT_Wlarge_by_value_copy_def)) {
     if (A->getNumValues()) {
@@ -2301,12 +2301,14 @@ void AugmentedCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &S,
   // If we did not add any cached completion results, just forward the
   // results we were given to the next consumer.
   if (!AddedResult) {
+    NumResults = Next.filterResults(Results, NumResults);
     Next.ProcessCodeCompleteResults(S, Context, Results, NumResults);
     return;
   }
   
   Next.ProcessCodeCompleteResults(S, Context, AllResults.data(),
-                                  AllResults.size());
+                                  Next.filterResults(AllResults.data(),
+                                                     AllResults.size()));
 }
 
 
@@ -2342,6 +2344,12 @@ void ASTUnit::CodeComplete(StringRef File, unsigned Line, unsigned Column,
   CodeCompleteOpts.IncludeGlobals = CachedCompletionResults.empty();
   CodeCompleteOpts.IncludeBriefComments = IncludeBriefComments;
 
+  // Let Sema drop results that do not match the consumer's filter text, but
+  // leave the ranking and result limit until the cached global results have
+  // been merged in.
+  CodeCompleteOpts.Filter = Consumer.getCodeCompleteOpts().Filter;
+  CodeCompleteOpts.MaxResults = 0;
+
   assert(IncludeBriefComments == this->IncludeBriefCommentsInCodeCompletion);
 
   FrontendOpts.CodeCompletionAt.FileName = File;
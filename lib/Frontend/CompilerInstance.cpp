@@ -30,6 +30,7 @@
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -865,6 +866,15 @@ static void compileModule(CompilerInstance &ImportingInstance,
   Instance.clearOutputFiles(/*EraseFiles=*/true);
   if (!TempModuleMapFileName.empty())
     llvm::sys::Path(TempModuleMapFileName).eraseFromDisk();
+
+  // Rebuild the global module index so that it covers the module we just
+  // built, and make sure that our own AST reader picks up the new index.
+  if (ImportingInstance.getFrontendOpts().UseGlobalModuleIndex) {
+    GlobalModuleIndex::writeIndex(ImportingInstance.getFileManager(),
+                                  llvm::sys::path::parent_path(ModuleFileName));
+    if (ASTReader *Reader = ImportingInstance.getModuleManager())
+      Reader->resetGlobalIndex();
+  }
 }
 
 Module *CompilerInstance::loadModule(SourceLocation ImportLoc, 
@@ -966,7 +976,9 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
       const PreprocessorOptions &PPOpts = getPreprocessorOpts();
       ModuleManager = new ASTReader(getPreprocessor(), *Context,
                                     Sysroot.empty() ? "" : Sysroot.c_str(),
-                                    PPOpts.DisablePCHValidation);
+                                    PPOpts.DisablePCHValidation,
+                                    /*AllowASTWithCompilerErrors=*/false,
+                                    getFrontendOpts().UseGlobalModuleIndex);
       if (hasASTConsumer()) {
         ModuleManager->setDeserializationListener(
           getASTConsumer().GetASTDeserializationListener());
@@ -23,14 +23,34 @@
 #include "clang/Parse/ParseAST.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/Support/Timer.h"
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
 using namespace clang;
 
+/// \brief Print the peak resident set size of the process, where the host
+/// reports it.
+static void PrintPeakMemoryUsage() {
+#ifdef LLVM_ON_UNIX
+  struct rusage Usage;
+  if (getrusage(RUSAGE_SELF, &Usage) != 0)
+    return;
+#ifdef __APPLE__
+  uint64_t PeakBytes = Usage.ru_maxrss;
+#else
+  uint64_t PeakBytes = uint64_t(Usage.ru_maxrss) * 1024;
+#endif
+  llvm::errs() << "Peak memory usage: " << PeakBytes << " bytes\n";
+#endif
+}
+
 namespace {
 
 class DelegatingDeserializationListener : public ASTDeserializationListener {
@@ -420,6 +440,7 @@ void FrontendAction::EndSourceFile() {
     CI.getPreprocessor().getIdentifierTable().PrintStats();
     CI.getPreprocessor().getHeaderSearchInfo().PrintStats();
     CI.getSourceManager().PrintStats();
+    PrintPeakMemoryUsage();
     llvm::errs() << "\n";
   }
 
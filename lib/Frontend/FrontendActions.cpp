@@ -387,6 +387,9 @@ void PreprocessOnlyAction::ExecuteAction() {
   } while (Tok.isNot(tok::eof));
 }
 
+/// \brief The size of the buffer used to write preprocessed (-E) output.
+static const size_t PreprocessedOutputBufferSize = 256 * 1024;
+
 void PrintPreprocessedAction::ExecuteAction() {
   CompilerInstance &CI = getCompilerInstance();
   // Output file may need to be set to 'Binary', to avoid converting Unix style
@@ -430,9 +433,15 @@ void PrintPreprocessedAction::ExecuteAction() {
     }
   }
 
-  raw_ostream *OS = CI.createDefaultOutputFile(BinaryMode, getCurrentFile());
+  llvm::raw_fd_ostream *OS = CI.createDefaultOutputFile(BinaryMode,
+                                                       getCurrentFile());
   if (!OS) return;
 
+  // Preprocessed output is written a few bytes at a time; batch it up into
+  // large writes rather than the file system's (typically much smaller)
+  // preferred buffer size.
+  OS->SetBufferSize(PreprocessedOutputBufferSize);
+
   DoPrintPreprocessedInput(CI.getPreprocessor(), OS,
                            CI.getPreprocessorOutputOpts());
 }
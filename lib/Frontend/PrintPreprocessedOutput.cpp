@@ -493,6 +493,29 @@ struct UnknownPragmaHandler : public PragmaHandler {
 } // end anonymous namespace
 
 
+/// \brief If the given token is a punctuator spelled the usual way in the
+/// source, return that spelling, so that the token can be printed without
+/// looking at the source buffer.
+///
+/// Digraphs and tokens that need cleaning (e.g., due to trigraphs or escaped
+/// newlines) are spelled differently from their usual spelling; these return
+/// null, and the caller must ask the preprocessor for the real spelling.
+static const char *getSimplePunctuatorSpelling(const Token &Tok) {
+  if (Tok.needsCleaning())
+    return 0;
+
+  const char *Spelling = tok::getTokenSimpleSpelling(Tok.getKind());
+  if (!Spelling)
+    return 0;
+
+  // Digraphs always have a different length than the usual spelling.
+  unsigned Length = Tok.getLength();
+  for (unsigned I = 0; I != Length; ++I)
+    if (!Spelling[I])
+      return 0;
+  return Spelling[Length] ? 0 : Spelling;
+}
+
 static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
                                     PrintPPOutputPPCallbacks *Callbacks,
                                     raw_ostream &OS) {
@@ -518,8 +541,12 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
       OS << ' ';
     }
 
+    // Identifiers, punctuators and clean literals, which make up nearly all
+    // of the output, can be written without looking up their spelling.
     if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
       OS << II->getName();
+    } else if (const char *Punc = getSimplePunctuatorSpelling(Tok)) {
+      OS.write(Punc, Tok.getLength());
     } else if (Tok.isLiteral() && !Tok.needsCleaning() &&
                Tok.getLiteralData()) {
       OS.write(Tok.getLiteralData(), Tok.getLength());
@@ -0,0 +1,521 @@
+//===--- DirectiveScanner.cpp - Find lines without directives -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a light-weight scanner that determines which lines of
+// a source buffer cannot contain preprocessor directives, so that a lexer
+// that only cares about directives (e.g., when computing the dependencies of
+// a translation unit) can skip them entirely.
+//
+// The scanner only needs to track enough of the lexical structure of the
+// buffer to find the beginning of each logical line: comments, string and
+// character literals (including C++11 raw strings), and escaped newlines.
+// Rather than trying to mirror every corner of the lexer, it refuses to scan
+// buffers that use constructs it does not model (trigraphs, embedded null
+// characters, escaped newlines in the middle of a token, ...).
+//
+// Since the lexer only jumps over a range when it is at the very beginning of
+// that range at the start of a line, any range it does jump over is lexed by
+// the scanner from the same state the lexer would have been in.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DirectiveScanner.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/Support/MemoryBuffer.h"
+using namespace clang;
+
+static inline bool isHorizontalWhitespace(char C) {
+  return C == ' ' || C == '\t' || C == '\f' || C == '\v';
+}
+
+static inline bool isVerticalWhitespace(char C) {
+  return C == '\n' || C == '\r';
+}
+
+static inline bool isWhitespace(char C) {
+  return isHorizontalWhitespace(C) || isVerticalWhitespace(C);
+}
+
+static inline bool isDigit(char C) {
+  return C >= '0' && C <= '9';
+}
+
+namespace {
+class DirectiveScanner {
+  const char *BufferStart;
+  const char *BufferEnd;
+  const char *CurPtr;
+  const LangOptions &LangOpts;
+  SkippableRangeList &Ranges;
+
+  /// \brief The range of lines we are currently extending, if any.
+  SkippableRange Current;
+  bool InRange;
+
+public:
+  DirectiveScanner(StringRef Buffer, const LangOptions &LangOpts,
+                   SkippableRangeList &Ranges)
+    : BufferStart(Buffer.begin()), BufferEnd(Buffer.end()),
+      CurPtr(Buffer.begin()), LangOpts(LangOpts), Ranges(Ranges),
+      InRange(false) { }
+
+  bool scan();
+
+private:
+  bool isSupportedBuffer() const;
+
+  void extendRange(const char *LineStart, bool HasTokens);
+  void closeRange(const char *Ptr);
+
+  bool skipEscapedNewline();
+  void skipWhitespace();
+  void skipLineComment();
+  void skipBlockComment();
+  void skipQuotedLiteral(char Quote);
+  bool skipRawStringLiteral();
+  StringRef lexIdentifier();
+  void lexNumber();
+
+  bool isDirectiveStart() const;
+  bool isConflictMarkerStart() const;
+  bool lexRestOfLine(bool &SawPragma);
+  bool lexDirectiveLine(bool &SawPragma);
+};
+}
+
+/// \brief Determine whether the scanner can faithfully model how the lexer
+/// would split this buffer into lines.
+bool DirectiveScanner::isSupportedBuffer() const {
+  // The scanner does not know how to interpret a module import, nor the
+  // assembler-specific rules for '#' and quotes.
+  if (LangOpts.Modules || LangOpts.AsmPreprocessor)
+    return false;
+
+  StringRef Buffer(BufferStart, BufferEnd - BufferStart);
+
+  // The lexer treats an embedded null character as whitespace, which could
+  // turn what looks like code into a directive.
+  if (Buffer.find('\0') != StringRef::npos)
+    return false;
+
+  if (LangOpts.Trigraphs && Buffer.find("??") != StringRef::npos)
+    return false;
+  if (!LangOpts.LineComment && Buffer.find("//") != StringRef::npos)
+    return false;
+  if (LangOpts.MicrosoftExt && Buffer.find('\x1a') != StringRef::npos)
+    return false;
+
+  // An escaped newline in the middle of a token (e.g., between the '*' and
+  // the '/' ending a comment) splices two physical lines together in ways
+  // that are not worth modeling; the scanner only understands escaped
+  // newlines that are adjacent to whitespace.
+  for (size_t Pos = Buffer.find('\\'); Pos != StringRef::npos;
+       Pos = Buffer.find('\\', Pos + 1)) {
+    size_t After = Pos + 1;
+    while (After != Buffer.size() && isHorizontalWhitespace(Buffer[After]))
+      ++After;
+    if (After == Buffer.size() || !isVerticalWhitespace(Buffer[After]))
+      continue;
+
+    // Skip over the newline, which may be two characters long.
+    ++After;
+    if (After != Buffer.size() && isVerticalWhitespace(Buffer[After]) &&
+        Buffer[After] != Buffer[After - 1])
+      ++After;
+
+    if (Pos != 0 && !isWhitespace(Buffer[Pos - 1]) &&
+        After != Buffer.size() && !isWhitespace(Buffer[After]))
+      return false;
+  }
+
+  return true;
+}
+
+/// \brief Note that the line starting at \p LineStart can be skipped.
+void DirectiveScanner::extendRange(const char *LineStart, bool HasTokens) {
+  if (!InRange) {
+    Current.Begin = LineStart - BufferStart;
+    Current.HasTokens = false;
+    InRange = true;
+  }
+  Current.HasTokens |= HasTokens;
+}
+
+/// \brief Finish the current range (if any) at the given position, which is
+/// the beginning of a line that must be lexed.
+void DirectiveScanner::closeRange(const char *Ptr) {
+  if (!InRange)
+    return;
+
+  Current.End = Ptr - BufferStart;
+  Ranges.push_back(Current);
+  InRange = false;
+}
+
+/// \brief If the current character is a backslash that starts an escaped
+/// newline, skip over the escaped newline and return true.
+bool DirectiveScanner::skipEscapedNewline() {
+  assert(*CurPtr == '\\' && "Not at a backslash");
+  const char *Ptr = CurPtr + 1;
+  while (Ptr != BufferEnd && isHorizontalWhitespace(*Ptr))
+    ++Ptr;
+  if (Ptr == BufferEnd || !isVerticalWhitespace(*Ptr))
+    return false;
+
+  ++Ptr;
+  if (Ptr != BufferEnd && isVerticalWhitespace(*Ptr) && *Ptr != Ptr[-1])
+    ++Ptr;
+  CurPtr = Ptr;
+  return true;
+}
+
+/// \brief Skip whitespace, including newlines and escaped newlines.
+void DirectiveScanner::skipWhitespace() {
+  while (CurPtr != BufferEnd) {
+    if (isWhitespace(*CurPtr))
+      ++CurPtr;
+    else if (*CurPtr != '\\' || !skipEscapedNewline())
+      return;
+  }
+}
+
+/// \brief Skip a line comment, leaving the current position at the newline
+/// that ends it (or at the end of the buffer).
+void DirectiveScanner::skipLineComment() {
+  while (CurPtr != BufferEnd) {
+    if (*CurPtr == '\\' && skipEscapedNewline())
+      continue;
+    if (isVerticalWhitespace(*CurPtr))
+      return;
+    ++CurPtr;
+  }
+}
+
+/// \brief Skip a block comment, which may span several lines.
+void DirectiveScanner::skipBlockComment() {
+  StringRef Rest(CurPtr + 2, BufferEnd - CurPtr - 2);
+  size_t End = Rest.find("*/");
+  if (End == StringRef::npos) {
+    // Unterminated comments run to the end of the file.
+    CurPtr = BufferEnd;
+    return;
+  }
+  CurPtr = Rest.data() + End + 2;
+}
+
+/// \brief Skip a string or character literal. Like the lexer, an unterminated
+/// literal ends at the end of the line.
+void DirectiveScanner::skipQuotedLiteral(char Quote) {
+  ++CurPtr;
+  while (CurPtr != BufferEnd) {
+    char C = *CurPtr;
+    if (C == Quote) {
+      ++CurPtr;
+      return;
+    }
+    if (isVerticalWhitespace(C))
+      return;
+    if (C == '\\') {
+      if (skipEscapedNewline())
+        continue;
+      // Skip the escaped character, unless it ends the buffer.
+      if (CurPtr + 1 != BufferEnd)
+        ++CurPtr;
+    }
+    ++CurPtr;
+  }
+}
+
+/// \brief Skip a C++11 raw string literal, whose opening quote is at the
+/// current position.
+///
+/// \returns false if the raw string literal is malformed, in which case the
+/// lexer's recovery is not worth modeling.
+bool DirectiveScanner::skipRawStringLiteral() {
+  const char *DelimStart = CurPtr + 1;
+  const char *Ptr = DelimStart;
+  while (Ptr != BufferEnd && *Ptr != '(') {
+    if (Ptr - DelimStart == 16 || isWhitespace(*Ptr) || *Ptr == ')' ||
+        *Ptr == '\\')
+      return false;
+    ++Ptr;
+  }
+  if (Ptr == BufferEnd)
+    return false;
+
+  StringRef Delim(DelimStart, Ptr - DelimStart);
+  StringRef Rest(Ptr + 1, BufferEnd - Ptr - 1);
+  for (size_t Pos = Rest.find(')'); Pos != StringRef::npos;
+       Pos = Rest.find(')', Pos + 1)) {
+    StringRef Tail = Rest.substr(Pos + 1);
+    if (Tail.startswith(Delim) && Tail.substr(Delim.size()).startswith("\"")) {
+      CurPtr = Tail.data() + Delim.size() + 1;
+      return true;
+    }
+  }
+
+  // Unterminated raw string literal.
+  return false;
+}
+
+/// \brief Lex an identifier starting at the current position.
+StringRef DirectiveScanner::lexIdentifier() {
+  const char *Start = CurPtr;
+  while (CurPtr != BufferEnd && Lexer::isIdentifierBodyChar(*CurPtr, LangOpts))
+    ++CurPtr;
+  return StringRef(Start, CurPtr - Start);
+}
+
+/// \brief Lex a preprocessing number starting at the current position, so
+/// that its suffix is not mistaken for an identifier.
+void DirectiveScanner::lexNumber() {
+  while (CurPtr != BufferEnd) {
+    char C = *CurPtr;
+    if (Lexer::isIdentifierBodyChar(C, LangOpts) || C == '.') {
+      ++CurPtr;
+      continue;
+    }
+    if ((C == '+' || C == '-') &&
+        (CurPtr[-1] == 'e' || CurPtr[-1] == 'E' ||
+         CurPtr[-1] == 'p' || CurPtr[-1] == 'P')) {
+      ++CurPtr;
+      continue;
+    }
+    return;
+  }
+}
+
+/// \brief Determine whether the current position starts a directive, given
+/// that it is the first token of a line.
+bool DirectiveScanner::isDirectiveStart() const {
+  if (*CurPtr == '#')
+    return true;
+  return LangOpts.Digraphs && *CurPtr == '%' && CurPtr + 1 != BufferEnd &&
+         CurPtr[1] == ':';
+}
+
+/// \brief Determine whether the current position might start a version
+/// control conflict marker, which the lexer handles specially.
+bool DirectiveScanner::isConflictMarkerStart() const {
+  StringRef Rest(CurPtr, BufferEnd - CurPtr);
+  return Rest.startswith("<<<<<<<") || Rest.startswith(">>>>");
+}
+
+/// \brief Lex the remainder of a logical line, leaving the current position
+/// at the newline that ends it (or at the end of the buffer).
+///
+/// \param SawPragma Set to true if the line contains a \c _Pragma operator.
+///
+/// \returns false if the line cannot be scanned reliably.
+bool DirectiveScanner::lexRestOfLine(bool &SawPragma) {
+  while (CurPtr != BufferEnd) {
+    char C = *CurPtr;
+    switch (C) {
+    case '\n':
+    case '\r':
+      return true;
+
+    case '\\':
+      if (!skipEscapedNewline())
+        ++CurPtr;
+      break;
+
+    case '/':
+      if (CurPtr + 1 != BufferEnd && CurPtr[1] == '/') {
+        skipLineComment();
+        return true;
+      }
+      if (CurPtr + 1 != BufferEnd && CurPtr[1] == '*') {
+        skipBlockComment();
+        break;
+      }
+      ++CurPtr;
+      break;
+
+    case '"':
+    case '\'':
+      skipQuotedLiteral(C);
+      break;
+
+    case '.':
+      if (CurPtr + 1 != BufferEnd && isDigit(CurPtr[1]))
+        lexNumber();
+      else
+        ++CurPtr;
+      break;
+
+    default:
+      if (isDigit(C)) {
+        lexNumber();
+        break;
+      }
+      if (!Lexer::isIdentifierBodyChar(C, LangOpts)) {
+        ++CurPtr;
+        break;
+      }
+
+      StringRef Name = lexIdentifier();
+      if (Name == "_Pragma" || (LangOpts.MicrosoftExt && Name == "__pragma"))
+        SawPragma = true;
+
+      // Check for a raw string literal prefix.
+      if (LangOpts.CPlusPlus0x && CurPtr != BufferEnd && *CurPtr == '"' &&
+          (Name == "R" || Name == "LR" || Name == "uR" || Name == "UR" ||
+           Name == "u8R")) {
+        if (!skipRawStringLiteral())
+          return false;
+      }
+      break;
+    }
+  }
+  return true;
+}
+
+/// \brief Lex a directive line, leaving the current position at the newline
+/// that ends it (or at the end of the buffer).
+///
+/// \returns false if the line cannot be scanned reliably.
+bool DirectiveScanner::lexDirectiveLine(bool &SawPragma) {
+  // Skip the '#' or '%:'.
+  CurPtr += *CurPtr == '#' ? 1 : 2;
+  while (CurPtr != BufferEnd) {
+    if (isHorizontalWhitespace(*CurPtr))
+      ++CurPtr;
+    else if (*CurPtr != '\\' || !skipEscapedNewline())
+      break;
+  }
+
+  if (CurPtr == BufferEnd || !Lexer::isIdentifierBodyChar(*CurPtr, LangOpts))
+    return lexRestOfLine(SawPragma);
+
+  StringRef Name = lexIdentifier();
+  if (Name == "error" || Name == "warning") {
+    // The text of a diagnostic directive is not tokenized; in particular,
+    // apostrophes do not start character literals.
+    skipLineComment();
+    return true;
+  }
+
+  if (Name == "include" || Name == "include_next" || Name == "import" ||
+      Name == "__include_macros") {
+    while (CurPtr != BufferEnd && isHorizontalWhitespace(*CurPtr))
+      ++CurPtr;
+
+    // Skip an angled header name, which may contain quotes or '//'.
+    if (CurPtr != BufferEnd && *CurPtr == '<') {
+      while (CurPtr != BufferEnd && *CurPtr != '>' &&
+             !isVerticalWhitespace(*CurPtr))
+        ++CurPtr;
+    }
+  }
+
+  return lexRestOfLine(SawPragma);
+}
+
+bool DirectiveScanner::scan() {
+  if (!isSupportedBuffer())
+    return false;
+
+  // The lexer skips a UTF-8 byte order mark.
+  if (StringRef(BufferStart, BufferEnd - BufferStart).startswith("\xEF\xBB\xBF"))
+    CurPtr += 3;
+
+  while (true) {
+    skipWhitespace();
+    if (CurPtr == BufferEnd)
+      break;
+
+    const char *LineStart = CurPtr;
+
+    // Skip over any comments at the start of the line, which do not prevent
+    // a following '#' from starting a directive.
+    bool CommentOnly = false;
+    while (CurPtr != BufferEnd && *CurPtr == '/' && CurPtr + 1 != BufferEnd) {
+      if (CurPtr[1] == '/') {
+        skipLineComment();
+        CommentOnly = true;
+        break;
+      }
+      if (CurPtr[1] != '*')
+        break;
+
+      skipBlockComment();
+      while (CurPtr != BufferEnd && isHorizontalWhitespace(*CurPtr))
+        ++CurPtr;
+      if (CurPtr == BufferEnd || isVerticalWhitespace(*CurPtr)) {
+        CommentOnly = true;
+        break;
+      }
+    }
+
+    if (CommentOnly) {
+      extendRange(LineStart, /*HasTokens=*/false);
+      continue;
+    }
+
+    bool SawPragma = false;
+    if (isDirectiveStart() || isConflictMarkerStart()) {
+      closeRange(LineStart);
+      if (!lexDirectiveLine(SawPragma))
+        return false;
+      continue;
+    }
+
+    if (!lexRestOfLine(SawPragma))
+      return false;
+
+    // Lines that use _Pragma can affect the preprocessor state, e.g., via
+    // _Pragma("once"), so the lexer needs to see them.
+    if (SawPragma)
+      closeRange(LineStart);
+    else
+      extendRange(LineStart, /*HasTokens=*/true);
+  }
+
+  closeRange(BufferEnd);
+  return true;
+}
+
+bool clang::scanSkippableRanges(StringRef Buffer, const LangOptions &LangOpts,
+                                SkippableRangeList &Ranges) {
+  Ranges.clear();
+  DirectiveScanner Scanner(Buffer, LangOpts, Ranges);
+  if (Scanner.scan())
+    return true;
+
+  Ranges.clear();
+  return false;
+}
+
+DirectiveScanCache::~DirectiveScanCache() {
+  for (llvm::DenseMap<const llvm::MemoryBuffer *,
+                      SkippableRangeList *>::iterator I = Entries.begin(),
+                                                      E = Entries.end();
+       I != E; ++I)
+    delete I->second;
+}
+
+const SkippableRangeList *
+DirectiveScanCache::getSkippableRanges(const llvm::MemoryBuffer *Buffer,
+                                       const LangOptions &LangOpts) {
+  std::pair<llvm::DenseMap<const llvm::MemoryBuffer *,
+                           SkippableRangeList *>::iterator, bool> Known
+    = Entries.insert(std::make_pair(Buffer, (SkippableRangeList *)0));
+  if (!Known.second)
+    return Known.first->second;
+
+  SkippableRangeList *Ranges = new SkippableRangeList;
+  if (!scanSkippableRanges(Buffer->getBuffer(), LangOpts, *Ranges)) {
+    delete Ranges;
+    Ranges = 0;
+  }
+  Known.first->second = Ranges;
+  return Ranges;
+}
@@ -91,6 +91,10 @@ void Lexer::InitLexer(const char *BufStart, const char *BufPtr,
   Is_PragmaLexer = false;
   CurrentConflictMarkerState = CMK_None;
 
+  // By default, lex everything.
+  SkippableRanges = 0;
+  NextSkippableRange = 0;
+
   // Start of the file is a start of line.
   IsAtStartOfLine = true;
 
@@ -2423,6 +2427,7 @@ unsigned Lexer::isNextPPTokenLParen() {
   // Save state that can be changed while lexing so that we can restore it.
   const char *TmpBufferPtr = BufferPtr;
   bool inPPDirectiveMode = ParsingPreprocessorDirective;
+  unsigned TmpNextSkippableRange = NextSkippableRange;
 
   Token Tok;
   Tok.startToken();
@@ -2431,6 +2436,7 @@ unsigned Lexer::isNextPPTokenLParen() {
   // Restore state that may have changed.
   BufferPtr = TmpBufferPtr;
   ParsingPreprocessorDirective = inPPDirectiveMode;
+  NextSkippableRange = TmpNextSkippableRange;
 
   // Restore the lexer back to non-skipping mode.
   LexingRawMode = false;
@@ -2588,6 +2594,28 @@ LexNextToken:
     Result.setFlag(Token::LeadingSpace);
   }
 
+  // If we are at the start of a range that is known to contain no directives,
+  // jump over it.
+  if (SkippableRanges && Result.isAtStartOfLine() &&
+      !ParsingPreprocessorDirective && !inKeepCommentMode()) {
+    unsigned Offset = CurPtr - BufferStart;
+    unsigned NumRanges = SkippableRanges->size();
+    while (NextSkippableRange != NumRanges &&
+           (*SkippableRanges)[NextSkippableRange].Begin < Offset)
+      ++NextSkippableRange;
+
+    if (NextSkippableRange != NumRanges &&
+        (*SkippableRanges)[NextSkippableRange].Begin == Offset) {
+      const SkippableRange &Range = (*SkippableRanges)[NextSkippableRange++];
+      assert(Range.End <= unsigned(BufferEnd - BufferStart) &&
+             "Skippable range extends past the end of the buffer");
+      if (Range.HasTokens)
+        MIOpt.ReadToken();
+      BufferPtr = BufferStart + Range.End;
+      goto LexNextToken;
+    }
+  }
+
   unsigned SizeTmp, SizeTmp2;   // Temporaries for use in cases below.
 
   // Read a character, advancing over it.
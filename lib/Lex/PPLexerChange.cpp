@@ -16,6 +16,7 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/LexDiagnostic.h"
+#include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/FileSystem.h"
@@ -101,7 +102,19 @@ void Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
         CodeCompletionFileLoc.getLocWithOffset(CodeCompletionOffset);
   }
 
-  EnterSourceFileWithLexer(new Lexer(FID, InputFile, *this), CurDir);
+  Lexer *TheLexer = new Lexer(FID, InputFile, *this);
+
+  // When all we care about are the directives (e.g., to compute the
+  // dependencies of the translation unit), let the lexer jump over the lines
+  // that cannot contain any.
+  if (PPOpts->FastDependencyScan && !isCodeCompletionEnabled()) {
+    if (!DirectiveCache)
+      DirectiveCache.reset(new DirectiveScanCache());
+    TheLexer->setSkippableRanges(
+      DirectiveCache->getSkippableRanges(InputFile, getLangOpts()));
+  }
+
+  EnterSourceFileWithLexer(TheLexer, CurDir);
   return;
 }
 
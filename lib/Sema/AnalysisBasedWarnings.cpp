@@ -46,6 +46,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/Timer.h"
 #include <algorithm>
 #include <iterator>
 #include <vector>
@@ -315,17 +316,12 @@ struct CheckFallThroughDiagnostics {
 
 }
 
-/// CheckFallThroughForFunctionDef - Check that we don't fall off the end of a
-/// function that should return a value.  Check that we don't fall off the end
-/// of a noreturn function.  We assume that functions and blocks not marked
-/// noreturn will return.
-static void CheckFallThroughForBody(Sema &S, const Decl *D, const Stmt *Body,
-                                    const BlockExpr *blkExpr,
-                                    const CheckFallThroughDiagnostics& CD,
-                                    AnalysisDeclContext &AC) {
-
-  bool ReturnsVoid = false;
-  bool HasNoReturn = false;
+/// getReturnKind - Determine whether the given function, method, or block
+/// returns void and whether it is marked noreturn.
+static void getReturnKind(const Decl *D, const BlockExpr *blkExpr,
+                          bool &ReturnsVoid, bool &HasNoReturn) {
+  ReturnsVoid = false;
+  HasNoReturn = false;
 
   if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
     ReturnsVoid = FD->getResultType()->isVoidType();
@@ -346,12 +342,44 @@ static void CheckFallThroughForBody(Sema &S, const Decl *D, const Stmt *Body,
         HasNoReturn = true;
     }
   }
+}
 
-  DiagnosticsEngine &Diags = S.getDiagnostics();
+/// FallThroughCheckNeedsCFG - Determine whether checking for falling off the
+/// end of the given body could produce a diagnostic, which requires
+/// building its CFG.
+static bool FallThroughCheckNeedsCFG(Sema &S, const Decl *D, const Stmt *Body,
+                                     const BlockExpr *blkExpr,
+                                     const CheckFallThroughDiagnostics &CD) {
+  bool ReturnsVoid, HasNoReturn;
+  getReturnKind(D, blkExpr, ReturnsVoid, HasNoReturn);
 
-  // Short circuit for compilation speed.
-  if (CD.checkDiagnostics(Diags, ReturnsVoid, HasNoReturn))
-      return;
+  if (CD.checkDiagnostics(S.getDiagnostics(), ReturnsVoid, HasNoReturn))
+    return false;
+
+  // FIXME: Function try block
+  const CompoundStmt *Compound = dyn_cast<CompoundStmt>(Body);
+  if (!Compound)
+    return false;
+
+  // A function that returns a value can only be diagnosed for falling off
+  // its end, which is impossible if its last statement is a return.
+  if (!ReturnsVoid && !HasNoReturn &&
+      dyn_cast_or_null<ReturnStmt>(Compound->body_back()))
+    return false;
+
+  return true;
+}
+
+/// CheckFallThroughForFunctionDef - Check that we don't fall off the end of a
+/// function that should return a value.  Check that we don't fall off the end
+/// of a noreturn function.  We assume that functions and blocks not marked
+/// noreturn will return.  Only called if FallThroughCheckNeedsCFG() allows.
+static void CheckFallThroughForBody(Sema &S, const Decl *D, const Stmt *Body,
+                                    const BlockExpr *blkExpr,
+                                    const CheckFallThroughDiagnostics& CD,
+                                    AnalysisDeclContext &AC) {
+  bool ReturnsVoid, HasNoReturn;
+  getReturnKind(D, blkExpr, ReturnsVoid, HasNoReturn);
 
   // FIXME: Function try block
   if (const CompoundStmt *Compound = dyn_cast<CompoundStmt>(Body)) {
@@ -1358,6 +1386,184 @@ class ThreadSafetyReporter : public clang::thread_safety::ThreadSafetyHandler {
 }
 }
 
+//===----------------------------------------------------------------------===//
+// Pre-screening of function bodies, to avoid building CFGs that no enabled
+// analysis could find anything in.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief A cheap syntactic summary of a function body.
+///
+/// Building a CFG is much more expensive than walking the AST of the body
+/// once, so we use this summary to skip the flow-sensitive analyses that
+/// cannot possibly produce a diagnostic for the body.
+class BodyFeatures : public ConstStmtVisitor<BodyFeatures> {
+public:
+  /// \brief Whether the body contains any calls, including implicit calls to
+  /// constructors and destructors, which might not return or might acquire
+  /// or release locks.
+  bool HasCalls;
+
+  /// \brief Whether the body contains any statement or expression that has
+  /// more than one successor in the CFG, or that ends a path through it.
+  bool HasBranches;
+
+  /// \brief Whether the body contains a switch or goto, which could jump over
+  /// the declaration of a variable.
+  bool HasJumps;
+
+  /// \brief Whether the body refers to any variable or field that has
+  /// attributes, e.g., \c guarded_by.
+  bool HasRefsToAttributedDecls;
+
+  /// \brief The number of return statements that are not at the very end of
+  /// the body.
+  unsigned NumEarlyReturns;
+
+  explicit BodyFeatures(const Stmt *Body)
+    : HasCalls(false), HasBranches(false), HasJumps(false),
+      HasRefsToAttributedDecls(false), NumEarlyReturns(0) {
+    Visit(Body);
+
+    // A return at the very end of the body does not branch anywhere.
+    if (const CompoundStmt *CS = dyn_cast<CompoundStmt>(Body))
+      if (dyn_cast_or_null<ReturnStmt>(CS->body_back()))
+        --NumEarlyReturns;
+    if (NumEarlyReturns)
+      HasBranches = true;
+  }
+
+  void VisitChildren(const Stmt *S) {
+    for (Stmt::const_child_range I = S->children(); I; ++I)
+      if (*I)
+        Visit(*I);
+  }
+
+  void VisitStmt(const Stmt *S) { VisitChildren(S); }
+
+  void VisitCallExpr(const CallExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitCXXConstructExpr(const CXXConstructExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitCXXBindTemporaryExpr(const CXXBindTemporaryExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitCXXNewExpr(const CXXNewExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitCXXDeleteExpr(const CXXDeleteExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitObjCMessageExpr(const ObjCMessageExpr *E) {
+    HasCalls = true;
+    VisitChildren(E);
+  }
+  void VisitBlockExpr(const BlockExpr *E) {
+    // Blocks capture variables, which may involve copy constructors.
+    HasCalls = true;
+  }
+
+  void VisitDeclStmt(const DeclStmt *DS) {
+    for (DeclStmt::const_decl_iterator I = DS->decl_begin(),
+                                       E = DS->decl_end(); I != E; ++I) {
+      // Local variables of class type may have destructors.
+      if (const VarDecl *VD = dyn_cast<VarDecl>(*I))
+        if (VD->getType()->getBaseElementTypeUnsafe()->isRecordType())
+          HasCalls = true;
+    }
+    VisitChildren(DS);
+  }
+
+  void VisitDeclRefExpr(const DeclRefExpr *E) {
+    if (E->getDecl()->hasAttrs())
+      HasRefsToAttributedDecls = true;
+  }
+  void VisitMemberExpr(const MemberExpr *E) {
+    if (E->getMemberDecl()->hasAttrs())
+      HasRefsToAttributedDecls = true;
+    VisitChildren(E);
+  }
+  void VisitObjCIvarRefExpr(const ObjCIvarRefExpr *E) {
+    if (E->getDecl()->hasAttrs())
+      HasRefsToAttributedDecls = true;
+    VisitChildren(E);
+  }
+
+  void VisitSwitchStmt(const SwitchStmt *S) {
+    HasBranches = HasJumps = true;
+    VisitChildren(S);
+  }
+  void VisitGotoStmt(const GotoStmt *S) {
+    HasBranches = HasJumps = true;
+  }
+  void VisitIndirectGotoStmt(const IndirectGotoStmt *S) {
+    HasBranches = HasJumps = true;
+    VisitChildren(S);
+  }
+
+  void VisitBranch(const Stmt *S) {
+    HasBranches = true;
+    VisitChildren(S);
+  }
+  void VisitIfStmt(const IfStmt *S) { VisitBranch(S); }
+  void VisitWhileStmt(const WhileStmt *S) { VisitBranch(S); }
+  void VisitDoStmt(const DoStmt *S) { VisitBranch(S); }
+  void VisitForStmt(const ForStmt *S) { VisitBranch(S); }
+  void VisitCXXForRangeStmt(const CXXForRangeStmt *S) { VisitBranch(S); }
+  void VisitObjCForCollectionStmt(const ObjCForCollectionStmt *S) {
+    VisitBranch(S);
+  }
+  void VisitBreakStmt(const BreakStmt *S) { VisitBranch(S); }
+  void VisitContinueStmt(const ContinueStmt *S) { VisitBranch(S); }
+  void VisitReturnStmt(const ReturnStmt *S) {
+    ++NumEarlyReturns;
+    VisitChildren(S);
+  }
+  void VisitLabelStmt(const LabelStmt *S) { VisitBranch(S); }
+  void VisitCXXTryStmt(const CXXTryStmt *S) { VisitBranch(S); }
+  void VisitCXXThrowExpr(const CXXThrowExpr *E) { VisitBranch(E); }
+  void VisitObjCAtTryStmt(const ObjCAtTryStmt *S) { VisitBranch(S); }
+  void VisitObjCAtThrowStmt(const ObjCAtThrowStmt *S) { VisitBranch(S); }
+  void VisitSEHTryStmt(const SEHTryStmt *S) { VisitBranch(S); }
+  void VisitAbstractConditionalOperator(const AbstractConditionalOperator *E) {
+    VisitBranch(E);
+  }
+  void VisitBinaryOperator(const BinaryOperator *E) {
+    if (E->isLogicalOp())
+      HasBranches = true;
+    VisitChildren(E);
+  }
+};
+
+/// \brief Accumulates the time spent in a scope into a counter, if
+/// statistics are being collected.
+class AnalysisTimer {
+  double *Total;
+  llvm::TimeRecord Start;
+
+public:
+  AnalysisTimer(bool Enabled, double &Total) : Total(Enabled ? &Total : 0) {
+    if (Enabled)
+      Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  }
+
+  ~AnalysisTimer() {
+    if (!Total)
+      return;
+    llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+    Elapsed -= Start;
+    *Total += Elapsed.getWallTime();
+  }
+};
+}
+
 //===----------------------------------------------------------------------===//
 // AnalysisBasedWarnings - Worker object used by Sema to execute analysis-based
 //  warnings on a function, method, or block.
@@ -1373,13 +1579,23 @@ clang::sema::AnalysisBasedWarnings::AnalysisBasedWarnings(Sema &s)
   : S(s),
     NumFunctionsAnalyzed(0),
     NumFunctionsWithBadCFGs(0),
+    NumFunctionsSkipped(0),
     NumCFGBlocks(0),
     MaxCFGBlocksPerFunction(0),
     NumUninitAnalysisFunctions(0),
     NumUninitAnalysisVariables(0),
     MaxUninitAnalysisVariablesPerFunction(0),
     NumUninitAnalysisBlockVisits(0),
-    MaxUninitAnalysisBlockVisitsPerFunction(0) {
+    MaxUninitAnalysisBlockVisitsPerFunction(0),
+    NumThreadSafetyFunctions(0),
+    NumThreadSafetyJoins(0),
+    NumThreadSafetyTrivialJoins(0),
+    NumThreadSafetyCachedJoins(0),
+    NumThreadSafetyLocksets(0),
+    NumThreadSafetyMutexes(0),
+    CFGBuildTime(0), FallThroughTime(0), UnreachableTime(0),
+    ThreadSafetyTime(0), ThreadSafetyContextTime(0),
+    ThreadSafetyLocksetTime(0), UninitTime(0) {
   DiagnosticsEngine &D = S.getDiagnostics();
   DefaultPolicy.enableCheckUnreachable = (unsigned)
     (D.getDiagnosticLevel(diag::warn_unreachable, SourceLocation()) !=
@@ -1464,21 +1680,75 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
       .setAlwaysAdd(Stmt::AttributedStmtClass);
   }
 
-  // Construct the analysis context with the specified CFG build options.
-  
+  // Register the expressions of delayed diagnostics with the CFGBuilder.
+  for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
+       i = fscope->PossiblyUnreachableDiags.begin(),
+       e = fscope->PossiblyUnreachableDiags.end();
+       i != e; ++i) {
+    if (const Stmt *stmt = i->stmt)
+      AC.registerForcedBlockExpression(stmt);
+  }
+
+  // Determine which of the flow-sensitive analyses could possibly produce a
+  // diagnostic for this body, so that we only build a CFG if one of them
+  // needs it.
+  BodyFeatures Features(Body);
+
+  bool RunFallThrough = false;
+  CheckFallThroughDiagnostics CD;
+  if (P.enableCheckFallThrough) {
+    CD = (isa<BlockDecl>(D) ? CheckFallThroughDiagnostics::MakeForBlock()
+          : (isa<CXXMethodDecl>(D) &&
+             cast<CXXMethodDecl>(D)->getOverloadedOperator() == OO_Call &&
+             cast<CXXMethodDecl>(D)->getParent()->isLambda())
+               ? CheckFallThroughDiagnostics::MakeForLambda()
+               : CheckFallThroughDiagnostics::MakeForFunction(D));
+    RunFallThrough = FallThroughCheckNeedsCFG(S, D, Body, blkExpr, CD);
+  }
+
+  bool RunUnreachable = false;
+  if (P.enableCheckUnreachable) {
+    // Only check for unreachable code on non-template instantiations.
+    // Different template instantiations can effectively change the
+    // control-flow and it is very difficult to prove that a snippet of code
+    // in a template is unreachable for all instantiations.
+    bool isTemplateInstantiation = false;
+    if (const FunctionDecl *Function = dyn_cast<FunctionDecl>(D))
+      isTemplateInstantiation = Function->isTemplateInstantiation();
+
+    // Code can only be unreachable after a branch, or after a call that does
+    // not return.
+    RunUnreachable = !isTemplateInstantiation &&
+                     (Features.HasBranches || Features.HasCalls);
+  }
+
+  // The thread safety analysis only reports on the lock annotations of the
+  // function itself, of the functions it calls, and of the variables it uses.
+  bool RunThreadSafety = P.enableThreadSafetyAnalysis &&
+    (D->hasAttrs() || Features.HasCalls || Features.HasRefsToAttributedDecls);
+
+  bool RunUninit =
+    (Diags.getDiagnosticLevel(diag::warn_uninit_var, D->getLocStart())
+       != DiagnosticsEngine::Ignored ||
+     Diags.getDiagnosticLevel(diag::warn_sometimes_uninit_var,D->getLocStart())
+       != DiagnosticsEngine::Ignored ||
+     Diags.getDiagnosticLevel(diag::warn_maybe_uninit_var, D->getLocStart())
+       != DiagnosticsEngine::Ignored) &&
+    mayHaveUninitializedUses(*cast<DeclContext>(D), Features.HasJumps);
+
+  if (S.CollectStats &&
+      (!fscope->PossiblyUnreachableDiags.empty() || RunFallThrough ||
+       RunUnreachable || RunThreadSafety || RunUninit)) {
+    // Build the CFG up front, so that its cost is accounted for separately
+    // from the cost of the analyses that use it.
+    AnalysisTimer Timer(true, CFGBuildTime);
+    AC.getCFG();
+  }
+
   // Emit delayed diagnostics.
   if (!fscope->PossiblyUnreachableDiags.empty()) {
     bool analyzed = false;
 
-    // Register the expressions with the CFGBuilder.
-    for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
-         i = fscope->PossiblyUnreachableDiags.begin(),
-         e = fscope->PossiblyUnreachableDiags.end();
-         i != e; ++i) {
-      if (const Stmt *stmt = i->stmt)
-        AC.registerForcedBlockExpression(stmt);
-    }
-
     if (AC.getCFG()) {
       analyzed = true;
       for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
@@ -1515,45 +1785,43 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
   
   
   // Warning: check missing 'return'
-  if (P.enableCheckFallThrough) {
-    const CheckFallThroughDiagnostics &CD =
-      (isa<BlockDecl>(D) ? CheckFallThroughDiagnostics::MakeForBlock()
-       : (isa<CXXMethodDecl>(D) &&
-          cast<CXXMethodDecl>(D)->getOverloadedOperator() == OO_Call &&
-          cast<CXXMethodDecl>(D)->getParent()->isLambda())
-            ? CheckFallThroughDiagnostics::MakeForLambda()
-            : CheckFallThroughDiagnostics::MakeForFunction(D));
+  if (RunFallThrough) {
+    AnalysisTimer Timer(S.CollectStats, FallThroughTime);
     CheckFallThroughForBody(S, D, Body, blkExpr, CD, AC);
   }
 
   // Warning: check for unreachable code
-  if (P.enableCheckUnreachable) {
-    // Only check for unreachable code on non-template instantiations.
-    // Different template instantiations can effectively change the control-flow
-    // and it is very difficult to prove that a snippet of code in a template
-    // is unreachable for all instantiations.
-    bool isTemplateInstantiation = false;
-    if (const FunctionDecl *Function = dyn_cast<FunctionDecl>(D))
-      isTemplateInstantiation = Function->isTemplateInstantiation();
-    if (!isTemplateInstantiation)
-      CheckUnreachable(S, AC);
+  if (RunUnreachable) {
+    AnalysisTimer Timer(S.CollectStats, UnreachableTime);
+    CheckUnreachable(S, AC);
   }
 
   // Check for thread safety violations
-  if (P.enableThreadSafetyAnalysis) {
+  if (RunThreadSafety) {
+    AnalysisTimer Timer(S.CollectStats, ThreadSafetyTime);
     SourceLocation FL = AC.getDecl()->getLocation();
     SourceLocation FEL = AC.getDecl()->getLocEnd();
     thread_safety::ThreadSafetyReporter Reporter(S, FL, FEL);
-    thread_safety::runThreadSafetyAnalysis(AC, Reporter);
+    thread_safety::ThreadSafetyStats Stats;
+    std::memset(&Stats, 0, sizeof(thread_safety::ThreadSafetyStats));
+    thread_safety::runThreadSafetyAnalysis(AC, Reporter,
+                                           S.CollectStats ? &Stats : 0);
     Reporter.emitDiagnostics();
+
+    if (S.CollectStats) {
+      ++NumThreadSafetyFunctions;
+      NumThreadSafetyJoins += Stats.NumJoins;
+      NumThreadSafetyTrivialJoins += Stats.NumTrivialJoins;
+      NumThreadSafetyCachedJoins += Stats.NumCachedJoins;
+      NumThreadSafetyLocksets += Stats.NumLocksets;
+      NumThreadSafetyMutexes += Stats.NumMutexes;
+      ThreadSafetyContextTime += Stats.ContextTime;
+      ThreadSafetyLocksetTime += Stats.LocksetTime;
+    }
   }
 
-  if (Diags.getDiagnosticLevel(diag::warn_uninit_var, D->getLocStart())
-      != DiagnosticsEngine::Ignored ||
-      Diags.getDiagnosticLevel(diag::warn_sometimes_uninit_var,D->getLocStart())
-      != DiagnosticsEngine::Ignored ||
-      Diags.getDiagnosticLevel(diag::warn_maybe_uninit_var, D->getLocStart())
-      != DiagnosticsEngine::Ignored) {
+  if (RunUninit) {
+    AnalysisTimer Timer(S.CollectStats, UninitTime);
     if (CFG *cfg = AC.getCFG()) {
       UninitValsDiagReporter reporter(S);
       UninitVariablesAnalysisStats stats;
@@ -1591,6 +1859,8 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
     diagnoseRepeatedUseOfWeak(S, fscope, D, AC.getParentMap());
 
   // Collect statistics about the CFG if it was built.
+  if (S.CollectStats && !AC.isCFGBuilt())
+    ++NumFunctionsSkipped;
   if (S.CollectStats && AC.isCFGBuilt()) {
     ++NumFunctionsAnalyzed;
     if (CFG *cfg = AC.getCFG()) {
@@ -1613,6 +1883,8 @@ void clang::sema::AnalysisBasedWarnings::PrintStats() const {
       !NumCFGsBuilt ? 0 : NumCFGBlocks/NumCFGsBuilt;
   llvm::errs() << NumFunctionsAnalyzed << " functions analyzed ("
                << NumFunctionsWithBadCFGs << " w/o CFGs).\n"
+               << NumFunctionsSkipped
+               << " functions skipped (no CFG needed).\n"
                << "  " << NumCFGBlocks << " CFG blocks built.\n"
                << "  " << AvgCFGBlocksPerFunction
                << " average CFG blocks per function.\n"
@@ -1635,4 +1907,28 @@ void clang::sema::AnalysisBasedWarnings::PrintStats() const {
                << " average block visits per function.\n"
                << "  " << MaxUninitAnalysisBlockVisitsPerFunction
                << " max block visits per function.\n";
+
+  llvm::errs() << NumThreadSafetyFunctions
+               << " functions analyzed for thread safety\n"
+               << "  " << NumThreadSafetyJoins << " lockset joins ("
+               << NumThreadSafetyTrivialJoins << " trivial, "
+               << NumThreadSafetyCachedJoins << " cached).\n"
+               << "  " << NumThreadSafetyLocksets << " distinct locksets.\n"
+               << "  " << NumThreadSafetyMutexes
+               << " distinct mutex expressions.\n";
+
+  llvm::errs() << "Time spent (seconds):\n"
+               << "  " << CFGBuildTime << " building CFGs.\n"
+               << "  " << FallThroughTime
+               << " checking for missing returns.\n"
+               << "  " << UnreachableTime
+               << " checking for unreachable code.\n"
+               << "  " << ThreadSafetyTime
+               << " checking thread safety.\n"
+               << "    " << ThreadSafetyContextTime
+               << " computing local variable contexts.\n"
+               << "    " << ThreadSafetyLocksetTime
+               << " computing locksets.\n"
+               << "  " << UninitTime
+               << " checking for uninitialized variables.\n";
 }
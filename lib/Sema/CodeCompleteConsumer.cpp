@@ -23,6 +23,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <functional>
 
@@ -639,3 +640,101 @@ bool clang::operator<(const CodeCompletionResult &X,
   
   return false;
 }
+
+//===----------------------------------------------------------------------===//
+// Code completion result filtering
+//===----------------------------------------------------------------------===//
+
+/// \brief Lowercase an ASCII letter, leaving every other byte alone, as
+/// StringRef::equals_lower() does.
+static char toLowercase(char C) {
+  if (C >= 'A' && C <= 'Z')
+    return C - 'A' + 'a';
+  return C;
+}
+
+unsigned clang::getCodeCompletionFilterQuality(StringRef Name,
+                                               StringRef Filter) {
+  if (Filter.empty())
+    return 1;
+
+  // A prefix match is best, particularly if the case matches as well.
+  if (Name.startswith(Filter))
+    return 4;
+  if (Name.size() >= Filter.size() &&
+      Name.substr(0, Filter.size()).equals_lower(Filter))
+    return 3;
+
+  // Otherwise, the filter text must be a (case-insensitive) subsequence of
+  // the name, e.g., "gfb" matches "getFooBar".
+  unsigned NameIdx = 0;
+  for (unsigned I = 0, N = Filter.size(); I != N; ++I) {
+    char C = toLowercase(Filter[I]);
+    while (NameIdx != Name.size() && toLowercase(Name[NameIdx]) != C)
+      ++NameIdx;
+    if (NameIdx == Name.size())
+      return 0;
+    ++NameIdx;
+  }
+
+  // Prefer subsequence matches that at least start at the beginning.
+  return toLowercase(Name[0]) == toLowercase(Filter[0]) ? 2 : 1;
+}
+
+namespace {
+  struct OrderRankedResults {
+    bool operator()(const RankedCodeCompletionResult &X,
+                    const RankedCodeCompletionResult &Y) const {
+      if (X.Quality != Y.Quality)
+        return X.Quality > Y.Quality;
+      if (X.Priority != Y.Priority)
+        return X.Priority < Y.Priority;
+      if (X.Length != Y.Length)
+        return X.Length < Y.Length;
+      return X.Index < Y.Index;
+    }
+  };
+}
+
+unsigned clang::rankCodeCompletionResults(
+                       SmallVectorImpl<RankedCodeCompletionResult> &Ranked,
+                       unsigned MaxResults) {
+  unsigned NumKept = Ranked.size();
+  if (MaxResults && MaxResults < NumKept)
+    NumKept = MaxResults;
+  std::partial_sort(Ranked.begin(), Ranked.begin() + NumKept, Ranked.end(),
+                    OrderRankedResults());
+  return NumKept;
+}
+
+unsigned CodeCompleteConsumer::filterResults(CodeCompletionResult *Results,
+                                             unsigned NumResults) const {
+  if (!hasResultFilter())
+    return NumResults;
+
+  StringRef Filter = CodeCompleteOpts.Filter;
+  SmallVector<RankedCodeCompletionResult, 64> Ranked;
+  Ranked.reserve(NumResults);
+  for (unsigned I = 0; I != NumResults; ++I) {
+    std::string Saved;
+    StringRef Name = getOrderedName(Results[I], Saved);
+    unsigned Quality = getCodeCompletionFilterQuality(Name, Filter);
+    if (!Quality)
+      continue;
+
+    RankedCodeCompletionResult R = { Quality, Results[I].Priority,
+                                     static_cast<unsigned>(Name.size()), I };
+    Ranked.push_back(R);
+  }
+
+  // Keep only the best-ranked results.
+  unsigned NumKept = rankCodeCompletionResults(Ranked,
+                                               CodeCompleteOpts.MaxResults);
+
+  SmallVector<CodeCompletionResult, 64> Kept;
+  Kept.reserve(NumKept);
+  for (unsigned I = 0; I != NumKept; ++I)
+    Kept.push_back(Results[Ranked[I].Index]);
+  std::copy(Kept.begin(), Kept.end(), Results);
+  return NumKept;
+}
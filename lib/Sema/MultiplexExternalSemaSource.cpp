@@ -169,6 +169,24 @@ bool MultiplexExternalSemaSource::layoutRecordType(const RecordDecl *Record,
   return false;
 }
 
+const ASTRecordLayout *
+MultiplexExternalSemaSource::getStoredRecordLayout(const RecordDecl *Record) {
+  for(size_t i = 0; i < Sources.size(); ++i)
+    if (const ASTRecordLayout *Layout =
+          Sources[i]->getStoredRecordLayout(Record))
+      return Layout;
+  return 0;
+}
+
+bool MultiplexExternalSemaSource::loadStoredVTableInformation(
+                                                  const CXXRecordDecl *Record,
+                                                  VTableContext &VTContext) {
+  for(size_t i = 0; i < Sources.size(); ++i)
+    if (Sources[i]->loadStoredVTableInformation(Record, VTContext))
+      return true;
+  return false;
+}
+
 void MultiplexExternalSemaSource::
 getMemoryBufferSizes(MemoryBufferSizes &sizes) const {
   for(size_t i = 0; i < Sources.size(); ++i)
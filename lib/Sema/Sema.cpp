@@ -15,6 +15,7 @@
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/DelayedDiagnostic.h"
 #include "TargetAttributesSema.h"
+#include "TypoNameIndex.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/APFloat.h"
@@ -89,6 +90,7 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     AccessCheckingSFINAE(false), InNonInstantiationSFINAEContext(false),
     NonInstantiationEntries(0), ArgumentPackSubstitutionIndex(-1),
     CurrentInstantiationScope(0), TyposCorrected(0),
+    ScannedIdentifiersForTypos(false), TypoCorrectionTime(0),
     AnalysisWarnings(*this)
 {
   TUScope = 0;
@@ -974,6 +976,21 @@ void Sema::PushFunctionScope() {
   FunctionScopes.push_back(new FunctionScopeInfo(getDiagnostics()));
 }
 
+Sema::SynthesizedFunctionScope::SynthesizedFunctionScope(Sema &S,
+                                                         DeclContext *DC)
+  : S(S), SavedContext(S, DC) {
+  S.PushFunctionScope();
+  S.PushExpressionEvaluationContext(Sema::PotentiallyEvaluated);
+  // The body is shared by every function that uses it.
+  S.Context.startSharedStatements();
+}
+
+Sema::SynthesizedFunctionScope::~SynthesizedFunctionScope() {
+  S.Context.finishSharedStatements();
+  S.PopExpressionEvaluationContext();
+  S.PopFunctionScopeInfo();
+}
+
 void Sema::PushBlockScope(Scope *BlockScope, BlockDecl *Block) {
   FunctionScopes.push_back(new BlockScopeInfo(getDiagnostics(),
                                               BlockScope, Block));
@@ -2940,8 +2940,13 @@ static void HandleCodeCompleteResults(Sema *S,
                                       CodeCompletionContext Context,
                                       CodeCompletionResult *Results,
                                       unsigned NumResults) {
-  if (CodeCompleter)
-    CodeCompleter->ProcessCodeCompleteResults(*S, Context, Results, NumResults);
+  if (!CodeCompleter)
+    return;
+
+  // Drop the results the consumer does not want before it builds
+  // code-completion strings for them.
+  NumResults = CodeCompleter->filterResults(Results, NumResults);
+  CodeCompleter->ProcessCodeCompleteResults(*S, Context, Results, NumResults);
 }
 
 static enum CodeCompletionContext::Kind mapCodeCompletionContext(Sema &S, 
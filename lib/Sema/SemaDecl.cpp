@@ -7827,6 +7827,7 @@ Decl *Sema::ActOnStartOfFunctionDef(Scope *FnBodyScope, Decl *D) {
 
   // Enter a new function scope
   PushFunctionScope();
+  Context.startFunctionBody(FD);
 
   // See if this is a redefinition.
   if (!FD->isLateTemplateParsed())
@@ -8114,6 +8115,8 @@ Decl *Sema::ActOnFinishFunctionBody(Decl *dcl, Stmt *Body,
     DiscardCleanupsInEvaluationContext();
   }
 
+  if (FD)
+    Context.finishFunctionBody(FD);
   return dcl;
 }
 
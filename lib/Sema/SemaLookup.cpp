@@ -21,6 +21,7 @@
 #include "clang/Sema/TemplateDeduction.h"
 #include "clang/Sema/ExternalSemaSource.h"
 #include "clang/Sema/TypoCorrection.h"
+#include "TypoNameIndex.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/Decl.h"
@@ -39,6 +40,7 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/edit_distance.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Timer.h"
 #include <algorithm>
 #include <iterator>
 #include <limits>
@@ -3179,6 +3181,10 @@ public:
     return CorrectionResults.begin()->second[Name];
   }
 
+  /// \brief The largest edit distance between the typo and a name that is
+  /// worth computing exactly.
+  unsigned getMaxEditDistance() const { return (Typo.size() + 2) / 3; }
+
   unsigned getBestEditDistance(bool Normalized) {
     if (CorrectionResults.empty())
       return (std::numeric_limits<unsigned>::max)();
@@ -3193,6 +3199,21 @@ public:
 
 };
 
+/// \brief Adds the wall time between its construction and its destruction to
+/// a running total, in seconds.
+class TypoCorrectionTimer {
+  double &Total;
+  double Start;
+
+public:
+  explicit TypoCorrectionTimer(double &Total)
+    : Total(Total), Start(llvm::TimeRecord::getCurrentTime().getWallTime()) {}
+
+  ~TypoCorrectionTimer() {
+    Total += llvm::TimeRecord::getCurrentTime(false).getWallTime() - Start;
+  }
+};
+
 }
 
 void TypoCorrectionConsumer::FoundDecl(NamedDecl *ND, NamedDecl *Hiding,
@@ -3220,7 +3241,7 @@ void TypoCorrectionConsumer::FoundName(StringRef Name) {
 
   // Compute an upper bound on the allowable edit distance, so that the
   // edit-distance algorithm can short-circuit.
-  unsigned UpperBound = (Typo.size() + 2) / 3;
+  unsigned UpperBound = getMaxEditDistance();
 
   // Compute the edit distance between the typo and the name of this
   // entity, and add the identifier to the list of results.
@@ -3709,6 +3730,13 @@ TypoCorrection Sema::CorrectTypo(const DeclarationNameInfo &TypoName,
   if (Diags.hasFatalErrorOccurred() || !getLangOpts().SpellChecking)
     return TypoCorrection();
 
+  // Give up on typo correction once it has used up its time budget for this
+  // translation unit.
+  if (unsigned TimeLimit = getLangOpts().TypoCorrectionTimeLimit)
+    if (TypoCorrectionTime * 1000 >= TimeLimit)
+      return TypoCorrection();
+  TypoCorrectionTimer Timer(TypoCorrectionTime);
+
   // In Microsoft mode, don't perform typo correction in a template member
   // function dependent context because it interferes with the "lookup into
   // dependent bases of class templates" feature.
@@ -3802,7 +3830,10 @@ TypoCorrection Sema::CorrectTypo(const DeclarationNameInfo &TypoName,
   // adding or changing the nested name specifier.
   bool AllowOnlyNNSChanges = Typo->getName().size() < 3;
   
-  if (IsUnqualifiedLookup || SearchNamespaces) {
+  if ((IsUnqualifiedLookup || SearchNamespaces) &&
+      !ScannedIdentifiersForTypos) {
+    ScannedIdentifiersForTypos = true;
+
     // For unqualified lookup, look through all of the names that we have
     // seen in this translation unit.
     // FIXME: Re-add the ability to skip very unlikely potential corrections.
@@ -3824,6 +3855,29 @@ TypoCorrection Sema::CorrectTypo(const DeclarationNameInfo &TypoName,
         Consumer.FoundName(Name);
       } while (true);
     }
+  } else if (IsUnqualifiedLookup || SearchNamespaces) {
+    // This translation unit has more than one typo, so it pays to build an
+    // index of the names in it, and only compute the edit distance to the
+    // names the index considers close enough.
+    if (!TypoNames) {
+      TypoNames.reset(new TypoNameIndex());
+
+      // Identifiers from external sources are only indexed once; the ones
+      // that are used later on end up in the identifier table anyway.
+      if (IdentifierInfoLookup *External
+                              = Context.Idents.getExternalIdentifierLookup()) {
+        OwningPtr<IdentifierIterator> Iter(External->getIdentifiers());
+        for (StringRef Name = Iter->Next(); !Name.empty(); Name = Iter->Next())
+          TypoNames->addName(Name);
+      }
+    }
+    TypoNames->addIdentifiers(Context.Idents);
+
+    SmallVector<StringRef, 16> Candidates;
+    TypoNames->findNames(Typo->getName(), Consumer.getMaxEditDistance(),
+                         Candidates);
+    for (unsigned I = 0, N = Candidates.size(); I != N; ++I)
+      Consumer.FoundName(Candidates[I]);
   }
 
   AddKeywordsToConsumer(*this, Consumer, S, CCC, SS && SS->isNotEmpty());
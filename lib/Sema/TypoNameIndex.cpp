@@ -0,0 +1,104 @@
+//===--- TypoNameIndex.cpp - Index of names for typo correction -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements TypoNameIndex, which finds the identifiers of a
+//  translation unit that are within a given edit distance of a typo.
+//
+//===----------------------------------------------------------------------===//
+
+#include "TypoNameIndex.h"
+#include "clang/Basic/IdentifierTable.h"
+using namespace clang;
+
+static unsigned getEditDistance(StringRef LHS, StringRef RHS) {
+  return LHS.edit_distance(RHS, /*AllowReplacements=*/true);
+}
+
+TypoNameIndex::~TypoNameIndex() {
+  if (Idents)
+    Idents->setNewIdentifierList(0);
+}
+
+void TypoNameIndex::addName(StringRef Name) {
+  if (Name.empty())
+    return;
+
+  llvm::StringMapEntry<char> &Entry = Names.GetOrCreateValue(Name);
+  if (Entry.getValue())
+    return;
+  Entry.setValue(1);
+  Name = Entry.getKey();
+
+  if (Nodes.empty()) {
+    Nodes.push_back(Node(Name));
+    return;
+  }
+
+  // Walk down the tree to the node that has no child at the right distance.
+  unsigned Current = 0;
+  while (true) {
+    unsigned Distance = getEditDistance(Name, Nodes[Current].Name);
+    unsigned Next = 0;
+    for (unsigned I = 0, E = Nodes[Current].Children.size(); I != E; ++I) {
+      if (Nodes[Current].Children[I].first == Distance) {
+        Next = Nodes[Current].Children[I].second;
+        break;
+      }
+    }
+
+    if (!Next) {
+      Nodes[Current].Children.push_back(std::make_pair(Distance,
+                                                       Nodes.size()));
+      Nodes.push_back(Node(Name));
+      return;
+    }
+    Current = Next;
+  }
+}
+
+void TypoNameIndex::addIdentifiers(IdentifierTable &Table) {
+  if (Idents != &Table) {
+    if (Idents)
+      Idents->setNewIdentifierList(0);
+    Idents = &Table;
+    Idents->setNewIdentifierList(&NewIdentifiers);
+    NewIdentifiers.clear();
+
+    for (IdentifierTable::iterator I = Table.begin(), E = Table.end();
+         I != E; ++I)
+      addName(I->getKey());
+    return;
+  }
+
+  for (unsigned I = 0, N = NewIdentifiers.size(); I != N; ++I)
+    addName(NewIdentifiers[I]->getName());
+  NewIdentifiers.clear();
+}
+
+void TypoNameIndex::findNames(StringRef Typo, unsigned MaxDistance,
+                              SmallVectorImpl<StringRef> &Results) const {
+  if (Nodes.empty())
+    return;
+
+  SmallVector<unsigned, 32> Worklist;
+  Worklist.push_back(0);
+  while (!Worklist.empty()) {
+    const Node &N = Nodes[Worklist.pop_back_val()];
+    unsigned Distance = getEditDistance(Typo, N.Name);
+    if (Distance <= MaxDistance)
+      Results.push_back(N.Name);
+
+    unsigned Low = Distance > MaxDistance ? Distance - MaxDistance : 0;
+    unsigned High = Distance + MaxDistance;
+    for (unsigned I = 0, E = N.Children.size(); I != E; ++I) {
+      if (N.Children[I].first >= Low && N.Children[I].first <= High)
+        Worklist.push_back(N.Children[I].second);
+    }
+  }
+}
@@ -0,0 +1,88 @@
+//===--- TypoNameIndex.h - Index of names for typo correction ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines TypoNameIndex, which finds the identifiers of a
+//  translation unit that are within a given edit distance of a typo.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TYPONAMEINDEX_H
+#define LLVM_CLANG_SEMA_TYPONAMEINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include <vector>
+
+namespace clang {
+
+class IdentifierInfo;
+class IdentifierTable;
+
+/// \brief An index of the identifiers seen in a translation unit, used to
+/// find typo correction candidates without computing the edit distance
+/// between the typo and every identifier.
+///
+/// The names are kept in a BK-tree: the children of a node are keyed by their
+/// edit distance to the node. By the triangle inequality, a search for the
+/// names within distance N of a typo only needs to descend into the children
+/// whose key differs by at most N from the distance between the typo and the
+/// node.
+class TypoNameIndex {
+  struct Node {
+    StringRef Name;
+
+    /// \brief The children of this node, as (distance, node index) pairs.
+    SmallVector<std::pair<unsigned, unsigned>, 4> Children;
+
+    explicit Node(StringRef Name) : Name(Name) {}
+  };
+
+  /// \brief The nodes of the tree; the first one is the root.
+  std::vector<Node> Nodes;
+
+  /// \brief The names in the index. Also owns the strings the nodes refer to.
+  llvm::StringMap<char> Names;
+
+  /// \brief The identifier table whose identifiers are indexed, if any.
+  IdentifierTable *Idents;
+
+  /// \brief The identifiers added to \c Idents since they were last indexed.
+  SmallVector<IdentifierInfo *, 32> NewIdentifiers;
+
+  TypoNameIndex(const TypoNameIndex &) LLVM_DELETED_FUNCTION;
+  void operator=(const TypoNameIndex &) LLVM_DELETED_FUNCTION;
+
+public:
+  TypoNameIndex() : Idents(0) {}
+  ~TypoNameIndex();
+
+  /// \brief Add \p Name to the index, unless it is already there.
+  void addName(StringRef Name);
+
+  /// \brief Add the identifiers of \p Table to the index.
+  ///
+  /// The first call indexes the whole table, and has the table report the
+  /// identifiers added to it from then on, so that later calls only index
+  /// those.
+  void addIdentifiers(IdentifierTable &Table);
+
+  /// \brief Add to \p Results all the names that are at most \p MaxDistance
+  /// edits away from \p Typo.
+  void findNames(StringRef Typo, unsigned MaxDistance,
+                 SmallVectorImpl<StringRef> &Results) const;
+
+  unsigned size() const { return Nodes.size(); }
+};
+
+} // end namespace clang
+
+#endif
@@ -13,6 +13,7 @@
 
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
+#include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Serialization/ModuleManager.h"
 #include "clang/Serialization/SerializationDiagnostic.h"
 #include "ASTCommon.h"
@@ -25,8 +26,10 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/NestedNameSpecifier.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
+#include "clang/AST/VTableBuilder.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/PreprocessingRecord.h"
 #include "clang/Lex/Preprocessor.h"
@@ -1386,10 +1389,15 @@ namespace {
   class IdentifierLookupVisitor {
     StringRef Name;
     unsigned PriorGeneration;
+    GlobalModuleIndex *Index;
+    GlobalModuleIndex::HitSet *Hits;
     IdentifierInfo *Found;
   public:
-    IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration) 
-      : Name(Name), PriorGeneration(PriorGeneration), Found() { }
+    IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration,
+                            GlobalModuleIndex *Index = 0,
+                            GlobalModuleIndex::HitSet *Hits = 0)
+      : Name(Name), PriorGeneration(PriorGeneration), Index(Index),
+        Hits(Hits), Found() { }
     
     static bool visit(ModuleFile &M, void *UserData) {
       IdentifierLookupVisitor *This
@@ -1399,6 +1407,13 @@ namespace {
       if (M.Generation <= This->PriorGeneration)
         return true;
       
+      // If the global module index tells us that this module file knows
+      // nothing about the identifier, don't probe its identifier table, but
+      // keep looking in the module files it depends on.
+      if (This->Hits && This->Index->isKnownModuleFile(&M) &&
+          !This->Hits->count(&M))
+        return false;
+      
       ASTIdentifierLookupTable *IdTable
         = (ASTIdentifierLookupTable *)M.IdentifierLookupTable;
       if (!IdTable)
@@ -1434,11 +1449,53 @@ void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
   if (getContext().getLangOpts().Modules)
     PriorGeneration = IdentifierGeneration[&II];
   
-  IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration);
+  // If there is a global index, look there first to determine which modules
+  // provably do not have any results for this identifier.
+  GlobalModuleIndex::HitSet Hits;
+  GlobalModuleIndex::HitSet *HitsPtr = 0;
+  if (!loadGlobalIndex() && GlobalIndex->lookupIdentifier(II.getName(), Hits))
+    HitsPtr = &Hits;
+
+  IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration,
+                                  GlobalIndex.get(), HitsPtr);
   ModuleMgr.visit(IdentifierLookupVisitor::visit, &Visitor);
   markIdentifierUpToDate(&II);
 }
 
+bool ASTReader::loadGlobalIndex() {
+  if (GlobalIndex)
+    return false;
+
+  if (TriedLoadingGlobalIndex || !UseGlobalIndex ||
+      !Context.getLangOpts().Modules)
+    return true;
+
+  // Try to load the global index.
+  TriedLoadingGlobalIndex = true;
+  StringRef ModuleCachePath = PP.getHeaderSearchInfo().getModuleCachePath();
+  if (ModuleCachePath.empty())
+    return true;
+
+  std::pair<GlobalModuleIndex *, GlobalModuleIndex::ErrorCode> Result
+    = GlobalModuleIndex::readIndex(ModuleCachePath);
+  if (!Result.first)
+    return true;
+
+  GlobalIndex.reset(Result.first);
+
+  // Tell the index about each of the module files we've already loaded.
+  for (ModuleIterator M = ModuleMgr.begin(), MEnd = ModuleMgr.end();
+       M != MEnd; ++M)
+    GlobalIndex->loadedModuleFile(*M);
+
+  return false;
+}
+
+void ASTReader::resetGlobalIndex() {
+  GlobalIndex.reset();
+  TriedLoadingGlobalIndex = false;
+}
+
 void ASTReader::markIdentifierUpToDate(IdentifierInfo *II) {
   if (!II)
     return;
@@ -2368,6 +2425,28 @@ bool ASTReader::ReadASTBlock(ModuleFile &F) {
       break;
     }
 
+    case RECORD_LAYOUT_OFFSETS: {
+      if (Record.size() % 2 != 0) {
+        Error("invalid RECORD_LAYOUT_OFFSETS block in AST file");
+        return true;
+      }
+      for (unsigned I = 0, N = Record.size(); I != N; I += 2)
+        RecordLayoutOffsets[getGlobalDeclID(F, Record[I])]
+          = std::make_pair(&F, Record[I+1]);
+      break;
+    }
+
+    case VTABLE_LAYOUT_OFFSETS: {
+      if (Record.size() % 2 != 0) {
+        Error("invalid VTABLE_LAYOUT_OFFSETS block in AST file");
+        return true;
+      }
+      for (unsigned I = 0, N = Record.size(); I != N; I += 2)
+        VTableLayoutOffsets[getGlobalDeclID(F, Record[I])]
+          = std::make_pair(&F, Record[I+1]);
+      break;
+    }
+
     case DECL_REPLACEMENTS: {
       if (Record.size() % 3 != 0) {
         Error("invalid DECL_REPLACEMENTS block in AST file");
@@ -2689,6 +2768,10 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
   case VersionMismatch:
   case ConfigurationMismatch:
   case HadErrors:
+    // The global index may have resolved some of the module files we are
+    // about to remove; drop it, and reload it on demand.
+    if (GlobalIndex && ModuleMgr.size() != NumModules)
+      resetGlobalIndex();
     ModuleMgr.removeModules(ModuleMgr.begin() + NumModules, ModuleMgr.end());
     return ReadResult;
 
@@ -2725,6 +2808,14 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
     }
   }
 
+  // Let the global module index know about the module files we just loaded.
+  if (GlobalIndex) {
+    for (llvm::SmallVectorImpl<ModuleFile *>::iterator M = Loaded.begin(),
+                                                    MEnd = Loaded.end();
+         M != MEnd; ++M)
+      GlobalIndex->loadedModuleFile(*M);
+  }
+
   // Mark all of the identifiers in the identifier table as being out of date,
   // so that various accessors know to check the loaded modules when the
   // identifier is used.
@@ -4980,6 +5071,219 @@ CXXBaseSpecifier *ASTReader::GetExternalCXXBaseSpecifiers(uint64_t Offset) {
   return Bases;
 }
 
+static const CXXRecordDecl *getBaseDecl(const CXXBaseSpecifier &Base) {
+  return cast<CXXRecordDecl>(Base.getType()->getAs<RecordType>()->getDecl());
+}
+
+const ASTRecordLayout *
+ASTReader::getStoredRecordLayout(const RecordDecl *RD) {
+  RecordLayoutOffsetsMap::iterator Pos
+    = RecordLayoutOffsets.find(RD->getGlobalID());
+  if (Pos == RecordLayoutOffsets.end())
+    return 0;
+
+  ModuleFile &F = *Pos->second.first;
+  llvm::BitstreamCursor &Cursor = F.DeclsCursor;
+  SavedStreamPosition SavedPosition(Cursor);
+  Cursor.JumpToBit(Pos->second.second);
+  RecordData Record;
+  unsigned Code = Cursor.ReadCode();
+  unsigned RecCode = Cursor.ReadRecord(Code, Record);
+  if (RecCode != DECL_RECORD_LAYOUT) {
+    Error("Malformed AST file: missing record layout");
+    return 0;
+  }
+  ++NumRecordLayoutsRead;
+
+  unsigned Idx = 0;
+  CharUnits Size = CharUnits::fromQuantity(Record[Idx++]);
+  CharUnits DataSize = CharUnits::fromQuantity(Record[Idx++]);
+  CharUnits Alignment = CharUnits::fromQuantity(Record[Idx++]);
+  unsigned NumFields = Record[Idx++];
+  SmallVector<uint64_t, 16> FieldOffsets(Record.begin() + Idx,
+                                         Record.begin() + Idx + NumFields);
+  Idx += NumFields;
+
+  bool IsCXX = Record[Idx++];
+  if (!IsCXX)
+    return new (Context) ASTRecordLayout(Context, Size, Alignment, DataSize,
+                                         FieldOffsets.data(), NumFields);
+
+  const CXXRecordDecl *CXXRD = cast<CXXRecordDecl>(RD);
+  CharUnits NonVirtualSize = CharUnits::fromQuantity(Record[Idx++]);
+  CharUnits NonVirtualAlign = CharUnits::fromQuantity(Record[Idx++]);
+  CharUnits SizeOfLargestEmptySubobject
+    = CharUnits::fromQuantity(Record[Idx++]);
+  CharUnits VBPtrOffset = CharUnits::fromQuantity(Record[Idx++]);
+  bool HasOwnVFPtr = Record[Idx++];
+
+  SmallVector<const CXXRecordDecl *, 4> Bases;
+  ASTRecordLayout::BaseOffsetsMapTy BaseOffsets;
+  for (CXXRecordDecl::base_class_const_iterator B = CXXRD->bases_begin(),
+                                             BEnd = CXXRD->bases_end();
+       B != BEnd; ++B) {
+    Bases.push_back(getBaseDecl(*B));
+    if (!B->isVirtual())
+      BaseOffsets[Bases.back()] = CharUnits::fromQuantity(Record[Idx++]);
+  }
+
+  SmallVector<const CXXRecordDecl *, 4> VBases;
+  ASTRecordLayout::VBaseOffsetsMapTy VBaseOffsets;
+  for (CXXRecordDecl::base_class_const_iterator B = CXXRD->vbases_begin(),
+                                             BEnd = CXXRD->vbases_end();
+       B != BEnd; ++B) {
+    VBases.push_back(getBaseDecl(*B));
+    CharUnits Offset = CharUnits::fromQuantity(Record[Idx++]);
+    bool HasVtorDisp = Record[Idx++];
+    VBaseOffsets[VBases.back()] = ASTRecordLayout::VBaseInfo(Offset,
+                                                             HasVtorDisp);
+  }
+
+  // The primary base is stored as 1 + its position among the direct bases,
+  // or -1 - its position among the virtual bases.
+  int64_t PrimaryBaseIndex = Record[Idx++];
+  const CXXRecordDecl *PrimaryBase = 0;
+  if (PrimaryBaseIndex > 0)
+    PrimaryBase = Bases[PrimaryBaseIndex - 1];
+  else if (PrimaryBaseIndex < 0)
+    PrimaryBase = VBases[-PrimaryBaseIndex - 1];
+
+  return new (Context) ASTRecordLayout(Context, Size, Alignment, HasOwnVFPtr,
+                                       VBPtrOffset, DataSize,
+                                       FieldOffsets.data(), NumFields,
+                                       NonVirtualSize, NonVirtualAlign,
+                                       SizeOfLargestEmptySubobject,
+                                       PrimaryBase, PrimaryBaseIndex < 0,
+                                       BaseOffsets, VBaseOffsets);
+}
+
+static ThunkInfo ReadThunkInfo(const ASTReader::RecordData &Record,
+                               unsigned &Idx) {
+  ThunkInfo Thunk;
+  Thunk.This.NonVirtual = Record[Idx++];
+  Thunk.This.VCallOffsetOffset = Record[Idx++];
+  Thunk.Return.NonVirtual = Record[Idx++];
+  Thunk.Return.VBaseOffsetOffset = Record[Idx++];
+  return Thunk;
+}
+
+bool ASTReader::loadStoredVTableInformation(const CXXRecordDecl *RD,
+                                            VTableContext &VTContext) {
+  const CXXRecordDecl *Def = RD->getDefinition();
+  if (!Def)
+    return false;
+
+  RecordLayoutOffsetsMap::iterator Pos
+    = VTableLayoutOffsets.find(Def->getGlobalID());
+  if (Pos == VTableLayoutOffsets.end())
+    return false;
+
+  ModuleFile &F = *Pos->second.first;
+  llvm::BitstreamCursor &Cursor = F.DeclsCursor;
+  SavedStreamPosition SavedPosition(Cursor);
+  Cursor.JumpToBit(Pos->second.second);
+  RecordData Record;
+  unsigned Code = Cursor.ReadCode();
+  unsigned RecCode = Cursor.ReadRecord(Code, Record);
+  if (RecCode != DECL_VTABLE_LAYOUT) {
+    Error("Malformed AST file: missing vtable layout");
+    return false;
+  }
+  ++NumVTableLayoutsRead;
+
+  unsigned Idx = 0;
+  uint64_t NumComponents = Record[Idx++];
+  SmallVector<VTableComponent, 32> Components;
+  Components.reserve(NumComponents);
+  for (uint64_t I = 0; I != NumComponents; ++I) {
+    VTableComponent::Kind Kind = (VTableComponent::Kind)Record[Idx++];
+    switch (Kind) {
+    case VTableComponent::CK_VCallOffset:
+      Components.push_back(VTableComponent::MakeVCallOffset(
+                             CharUnits::fromQuantity(Record[Idx++])));
+      break;
+    case VTableComponent::CK_VBaseOffset:
+      Components.push_back(VTableComponent::MakeVBaseOffset(
+                             CharUnits::fromQuantity(Record[Idx++])));
+      break;
+    case VTableComponent::CK_OffsetToTop:
+      Components.push_back(VTableComponent::MakeOffsetToTop(
+                             CharUnits::fromQuantity(Record[Idx++])));
+      break;
+    case VTableComponent::CK_RTTI:
+      Components.push_back(VTableComponent::MakeRTTI(
+                             ReadDeclAs<CXXRecordDecl>(F, Record, Idx)));
+      break;
+    case VTableComponent::CK_FunctionPointer:
+      Components.push_back(VTableComponent::MakeFunction(
+                             ReadDeclAs<CXXMethodDecl>(F, Record, Idx)));
+      break;
+    case VTableComponent::CK_CompleteDtorPointer:
+      Components.push_back(VTableComponent::MakeCompleteDtor(
+                             ReadDeclAs<CXXDestructorDecl>(F, Record, Idx)));
+      break;
+    case VTableComponent::CK_DeletingDtorPointer:
+      Components.push_back(VTableComponent::MakeDeletingDtor(
+                             ReadDeclAs<CXXDestructorDecl>(F, Record, Idx)));
+      break;
+    case VTableComponent::CK_UnusedFunctionPointer:
+      Components.push_back(VTableComponent::MakeUnusedFunction(
+                             ReadDeclAs<CXXMethodDecl>(F, Record, Idx)));
+      break;
+    }
+  }
+
+  uint64_t NumThunks = Record[Idx++];
+  SmallVector<VTableLayout::VTableThunkTy, 4> VTableThunks;
+  for (uint64_t I = 0; I != NumThunks; ++I) {
+    uint64_t Index = Record[Idx++];
+    VTableThunks.push_back(std::make_pair(Index, ReadThunkInfo(Record, Idx)));
+  }
+
+  VTableLayout::AddressPointsMapTy AddressPoints;
+  for (unsigned I = 0, N = Record[Idx++]; I != N; ++I) {
+    const CXXRecordDecl *Base = ReadDeclAs<CXXRecordDecl>(F, Record, Idx);
+    CharUnits BaseOffset = CharUnits::fromQuantity(Record[Idx++]);
+    AddressPoints[BaseSubobject(Base, BaseOffset)] = Record[Idx++];
+  }
+
+  if (!VTContext.VTableLayouts.count(RD))
+    VTContext.VTableLayouts[RD] =
+      new VTableLayout(Components.size(), Components.data(),
+                       VTableThunks.size(), VTableThunks.data(),
+                       AddressPoints);
+
+  for (unsigned I = 0, N = Record[Idx++]; I != N; ++I) {
+    const CXXMethodDecl *MD = ReadDeclAs<CXXMethodDecl>(F, Record, Idx);
+    if (const CXXDestructorDecl *DD = dyn_cast<CXXDestructorDecl>(MD)) {
+      VTContext.MethodVTableIndices.insert(
+        std::make_pair(GlobalDecl(DD, Dtor_Complete), Record[Idx++]));
+      VTContext.MethodVTableIndices.insert(
+        std::make_pair(GlobalDecl(DD, Dtor_Deleting), Record[Idx++]));
+    } else {
+      VTContext.MethodVTableIndices.insert(
+        std::make_pair(GlobalDecl(MD), Record[Idx++]));
+    }
+
+    VTableContext::ThunkInfoVectorTy Thunks;
+    for (unsigned T = 0, TEnd = Record[Idx++]; T != TEnd; ++T)
+      Thunks.push_back(ReadThunkInfo(Record, Idx));
+    if (!Thunks.empty())
+      VTContext.Thunks.insert(std::make_pair(MD, Thunks));
+  }
+  VTContext.NumVirtualFunctionPointers.insert(
+    std::make_pair(RD, Record[Idx++]));
+
+  for (CXXRecordDecl::base_class_const_iterator B = RD->vbases_begin(),
+                                             BEnd = RD->vbases_end();
+       B != BEnd; ++B) {
+    VTableContext::ClassPairTy ClassPair(RD, getBaseDecl(*B));
+    VTContext.VirtualBaseClassOffsetOffsets.insert(
+      std::make_pair(ClassPair, CharUnits::fromQuantity(Record[Idx++])));
+  }
+  return true;
+}
+
 serialization::DeclID 
 ASTReader::getGlobalDeclID(ModuleFile &F, LocalDeclID LocalID) const {
   if (LocalID < NUM_PREDEF_DECL_IDS)
@@ -5112,6 +5416,9 @@ serialization::DeclID ASTReader::ReadDeclID(ModuleFile &F,
 /// source each time it is called, and is meant to be used via a
 /// LazyOffsetPtr (which is used by Decls for the body of functions, etc).
 Stmt *ASTReader::GetExternalDeclStmt(uint64_t Offset) {
+  // Note that we are loading a function body.
+  Deserializing ABody(this);
+
   // Switch case IDs are per Decl.
   ClearSwitchCaseIDs();
 
@@ -5580,7 +5887,21 @@ void ASTReader::PrintStats() {
                   * 100));
     std::fprintf(stderr, "  %u method pool misses\n", NumMethodPoolMisses);
   }
+  if (!RecordLayoutOffsets.empty())
+    std::fprintf(stderr, "  %u/%u record layouts read (%f%%)\n",
+                 NumRecordLayoutsRead, (unsigned)RecordLayoutOffsets.size(),
+                 ((float)NumRecordLayoutsRead/RecordLayoutOffsets.size()
+                  * 100));
+  if (!VTableLayoutOffsets.empty())
+    std::fprintf(stderr, "  %u/%u vtable layouts read (%f%%)\n",
+                 NumVTableLayoutsRead, (unsigned)VTableLayoutOffsets.size(),
+                 ((float)NumVTableLayoutsRead/VTableLayoutOffsets.size()
+                  * 100));
   std::fprintf(stderr, "\n");
+
+  if (GlobalIndex)
+    GlobalIndex->printStats();
+
   dump();
   std::fprintf(stderr, "\n");
 }
@@ -5681,8 +6002,17 @@ IdentifierInfo* ASTReader::get(const char *NameStart, const char *NameEnd) {
   // Note that we are loading an identifier.
   Deserializing AnIdentifier(this);
   
-  IdentifierLookupVisitor Visitor(StringRef(NameStart, NameEnd - NameStart),
-                                  /*PriorGeneration=*/0);
+  StringRef Name(NameStart, NameEnd - NameStart);
+
+  // If there is a global index, look there first to determine which modules
+  // provably do not have any results for this identifier.
+  GlobalModuleIndex::HitSet Hits;
+  GlobalModuleIndex::HitSet *HitsPtr = 0;
+  if (!loadGlobalIndex() && GlobalIndex->lookupIdentifier(Name, Hits))
+    HitsPtr = &Hits;
+
+  IdentifierLookupVisitor Visitor(Name, /*PriorGeneration=*/0,
+                                  GlobalIndex.get(), HitsPtr);
   ModuleMgr.visit(IdentifierLookupVisitor::visit, &Visitor);
   IdentifierInfo *II = Visitor.getIdentifierInfo();
   markIdentifierUpToDate(II);
@@ -6881,6 +7211,14 @@ void ASTReader::finishPendingActions() {
   PendingBodies.clear();
 }
 
+void ASTReader::StartedDeserializing() {
+  // Deserialized statements can be reached from any function body, so they
+  // must not go into the allocator of the body being built, if any.
+  if (NumCurrentElementsDeserializing == 0)
+    Context.startSharedStatements();
+  ++NumCurrentElementsDeserializing;
+}
+
 void ASTReader::FinishedDeserializing() {
   assert(NumCurrentElementsDeserializing &&
          "FinishedDeserializing not paired with StartedDeserializing");
@@ -6888,6 +7226,7 @@ void ASTReader::FinishedDeserializing() {
     // We decrease NumCurrentElementsDeserializing only after pending actions
     // are finished, to avoid recursively re-calling finishPendingActions().
     finishPendingActions();
+    Context.finishSharedStatements();
   }
   --NumCurrentElementsDeserializing;
 
@@ -6910,11 +7249,12 @@ void ASTReader::FinishedDeserializing() {
 
 ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
                      StringRef isysroot, bool DisableValidation,
-                     bool AllowASTWithCompilerErrors)
+                     bool AllowASTWithCompilerErrors, bool UseGlobalIndex)
   : Listener(new PCHValidator(PP, *this)), DeserializationListener(0),
     SourceMgr(PP.getSourceManager()), FileMgr(PP.getFileManager()),
     Diags(PP.getDiagnostics()), SemaObj(0), PP(PP), Context(Context),
     Consumer(0), ModuleMgr(PP.getFileManager()),
+    TriedLoadingGlobalIndex(false), UseGlobalIndex(UseGlobalIndex),
     isysroot(isysroot), DisableValidation(DisableValidation),
     AllowASTWithCompilerErrors(AllowASTWithCompilerErrors), 
     CurrentGeneration(0), CurrSwitchCaseStmts(&SwitchCaseStmts),
@@ -6926,7 +7266,8 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
     NumVisibleDeclContextsRead(0), TotalVisibleDeclContexts(0),
     TotalModulesSizeInBits(0), NumCurrentElementsDeserializing(0),
     PassingDeclsToConsumer(false),
-    NumCXXBaseSpecifiersLoaded(0)
+    NumCXXBaseSpecifiersLoaded(0), NumRecordLayoutsRead(0),
+    NumVTableLayoutsRead(0)
 {
   SourceMgr.setExternalSLocEntrySource(this);
 }
@@ -2104,6 +2104,12 @@ Decl *ASTReader::ReadDeclRecord(DeclID ID) {
   case DECL_CXX_BASE_SPECIFIERS:
     Error("attempt to read a C++ base-specifier record as a declaration");
     return 0;
+  case DECL_RECORD_LAYOUT:
+    Error("attempt to read a record layout as a declaration");
+    return 0;
+  case DECL_VTABLE_LAYOUT:
+    Error("attempt to read a vtable layout as a declaration");
+    return 0;
   case DECL_IMPORT:
     // Note: last entry of the ImportDecl record is the number of stored source 
     // locations.
@@ -22,8 +22,10 @@
 #include "clang/AST/DeclFriend.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
+#include "clang/AST/VTableBuilder.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/MacroInfo.h"
@@ -833,6 +835,8 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(OBJC_CATEGORIES);
   RECORD(MACRO_OFFSET);
   RECORD(MACRO_UPDATES);
+  RECORD(RECORD_LAYOUT_OFFSETS);
+  RECORD(VTABLE_LAYOUT_OFFSETS);
 
   // SourceManager Block.
   BLOCK(SOURCE_MANAGER_BLOCK);
@@ -938,6 +942,8 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(DECL_CXX_BASE_SPECIFIERS);
   RECORD(DECL_INDIRECTFIELD);
   RECORD(DECL_EXPANDED_NON_TYPE_TEMPLATE_PARM_PACK);
+  RECORD(DECL_RECORD_LAYOUT);
+  RECORD(DECL_VTABLE_LAYOUT);
   
   // Statements and Exprs can occur in the Decls and Types block.
   AddStmtsExprs(Stream, Record);
@@ -2267,6 +2273,208 @@ void ASTWriter::WritePragmaDiagnosticMappings(const DiagnosticsEngine &Diag) {
     Stream.EmitRecord(DIAG_PRAGMA_MAPPINGS, Record);
 }
 
+static void AddThunkInfo(const ThunkInfo &Thunk,
+                         ASTWriter::RecordDataImpl &Record) {
+  Record.push_back(Thunk.This.NonVirtual);
+  Record.push_back(Thunk.This.VCallOffsetOffset);
+  Record.push_back(Thunk.Return.NonVirtual);
+  Record.push_back(Thunk.Return.VBaseOffsetOffset);
+}
+
+/// \brief Write the vtable layout of the dynamic class \p RD, the thunks and
+/// vtable indices of its virtual methods and its virtual base offset offsets.
+void ASTWriter::WriteVTableLayout(VTableContext &VTContext,
+                                  const CXXRecordDecl *RD) {
+  RecordData Record;
+  const VTableLayout &Layout = VTContext.getVTableLayout(RD);
+  Record.push_back(Layout.getNumVTableComponents());
+  for (VTableLayout::vtable_component_iterator
+         C = Layout.vtable_component_begin(),
+         CEnd = Layout.vtable_component_end(); C != CEnd; ++C) {
+    Record.push_back(C->getKind());
+    switch (C->getKind()) {
+    case VTableComponent::CK_VCallOffset:
+      Record.push_back(C->getVCallOffset().getQuantity());
+      break;
+    case VTableComponent::CK_VBaseOffset:
+      Record.push_back(C->getVBaseOffset().getQuantity());
+      break;
+    case VTableComponent::CK_OffsetToTop:
+      Record.push_back(C->getOffsetToTop().getQuantity());
+      break;
+    case VTableComponent::CK_RTTI:
+      AddDeclRef(C->getRTTIDecl(), Record);
+      break;
+    case VTableComponent::CK_FunctionPointer:
+      AddDeclRef(C->getFunctionDecl(), Record);
+      break;
+    case VTableComponent::CK_CompleteDtorPointer:
+    case VTableComponent::CK_DeletingDtorPointer:
+      AddDeclRef(C->getDestructorDecl(), Record);
+      break;
+    case VTableComponent::CK_UnusedFunctionPointer:
+      AddDeclRef(C->getUnusedFunctionDecl(), Record);
+      break;
+    }
+  }
+
+  Record.push_back(Layout.getNumVTableThunks());
+  for (VTableLayout::vtable_thunk_iterator T = Layout.vtable_thunk_begin(),
+                                        TEnd = Layout.vtable_thunk_end();
+       T != TEnd; ++T) {
+    Record.push_back(T->first);
+    AddThunkInfo(T->second, Record);
+  }
+
+  // Sort the address points so that the output does not depend on the
+  // order of the hash table.
+  typedef std::pair<std::pair<DeclID, int64_t>, uint64_t> AddressPointTy;
+  SmallVector<AddressPointTy, 4> AddressPoints;
+  for (VTableLayout::AddressPointsMapTy::const_iterator
+         A = Layout.getAddressPoints().begin(),
+         AEnd = Layout.getAddressPoints().end(); A != AEnd; ++A)
+    AddressPoints.push_back(
+      AddressPointTy(std::make_pair(GetDeclRef(A->first.getBase()),
+                                    A->first.getBaseOffset().getQuantity()),
+                     A->second));
+  std::sort(AddressPoints.begin(), AddressPoints.end());
+  Record.push_back(AddressPoints.size());
+  for (unsigned I = 0, N = AddressPoints.size(); I != N; ++I) {
+    Record.push_back(AddressPoints[I].first.first);
+    Record.push_back(AddressPoints[I].first.second);
+    Record.push_back(AddressPoints[I].second);
+  }
+
+  SmallVector<const CXXMethodDecl *, 8> Methods;
+  for (CXXRecordDecl::method_iterator M = RD->method_begin(),
+                                   MEnd = RD->method_end(); M != MEnd; ++M)
+    if (M->isVirtual())
+      Methods.push_back(*M);
+  Record.push_back(Methods.size());
+  for (unsigned I = 0, N = Methods.size(); I != N; ++I) {
+    const CXXMethodDecl *MD = Methods[I];
+    AddDeclRef(MD, Record);
+    // Destructors have both a complete and a deleting entry.
+    if (const CXXDestructorDecl *DD = dyn_cast<CXXDestructorDecl>(MD)) {
+      Record.push_back(
+        VTContext.getMethodVTableIndex(GlobalDecl(DD, Dtor_Complete)));
+      Record.push_back(
+        VTContext.getMethodVTableIndex(GlobalDecl(DD, Dtor_Deleting)));
+    } else {
+      Record.push_back(VTContext.getMethodVTableIndex(MD));
+    }
+
+    const VTableContext::ThunkInfoVectorTy *Thunks
+      = VTContext.getThunkInfo(MD);
+    Record.push_back(Thunks ? Thunks->size() : 0);
+    if (Thunks)
+      for (unsigned T = 0, TEnd = Thunks->size(); T != TEnd; ++T)
+        AddThunkInfo((*Thunks)[T], Record);
+  }
+  Record.push_back(VTContext.getNumVirtualFunctionPointers(RD));
+
+  // The virtual base offset offsets, in the order of the virtual bases.
+  for (CXXRecordDecl::base_class_const_iterator B = RD->vbases_begin(),
+                                             BEnd = RD->vbases_end();
+       B != BEnd; ++B) {
+    const CXXRecordDecl *VBase = B->getType()->getAsCXXRecordDecl();
+    Record.push_back(
+      VTContext.getVirtualBaseOffsetOffset(RD, VBase).getQuantity());
+  }
+
+  VTableLayoutOffsets.push_back(getDeclID(RD));
+  VTableLayoutOffsets.push_back(Stream.GetCurrentBitNo());
+  Stream.EmitRecord(DECL_VTABLE_LAYOUT, Record);
+}
+
+/// \brief Write the layouts of the record definitions written to the AST file,
+/// so that readers don't have to lay them out again. The vtable layouts of
+/// dynamic classes are written as well, unless \p VTContext is null.
+///
+/// Bases are identified by their position in the list of direct or virtual
+/// bases of the record.
+void ASTWriter::WriteRecordLayouts(ASTContext &Context,
+                                   VTableContext *VTContext) {
+  RecordData Record;
+  for (unsigned I = 0, N = RecordsToLayout.size(); I != N; ++I) {
+    RecordDecl *RD = RecordsToLayout[I];
+    if (RD->isInvalidDecl() || RD->isDependentType() ||
+        RD->getDefinition() != RD)
+      continue;
+
+    const ASTRecordLayout &Layout = Context.getASTRecordLayout(RD);
+    Record.clear();
+    Record.push_back(Layout.getSize().getQuantity());
+    Record.push_back(Layout.getDataSize().getQuantity());
+    Record.push_back(Layout.getAlignment().getQuantity());
+    Record.push_back(Layout.getFieldCount());
+    for (unsigned Field = 0, NumFields = Layout.getFieldCount();
+         Field != NumFields; ++Field)
+      Record.push_back(Layout.getFieldOffset(Field));
+
+    CXXRecordDecl *CXXRD = dyn_cast<CXXRecordDecl>(RD);
+    Record.push_back(CXXRD != 0);
+    if (CXXRD) {
+      Record.push_back(Layout.getNonVirtualSize().getQuantity());
+      Record.push_back(Layout.getNonVirtualAlign().getQuantity());
+      Record.push_back(Layout.getSizeOfLargestEmptySubobject().getQuantity());
+      Record.push_back(Layout.getVBPtrOffset().getQuantity());
+      Record.push_back(Layout.hasOwnVFPtr());
+
+      // The primary base, as 1 + its position among the direct bases, or
+      // -1 - its position among the virtual bases.
+      const CXXRecordDecl *PrimaryBase = Layout.getPrimaryBase();
+      int64_t PrimaryBaseIndex = 0;
+      unsigned Index = 0;
+      for (CXXRecordDecl::base_class_iterator B = CXXRD->bases_begin(),
+                                           BEnd = CXXRD->bases_end();
+           B != BEnd; ++B, ++Index) {
+        if (B->isVirtual())
+          continue;
+        const CXXRecordDecl *Base =
+          cast<CXXRecordDecl>(B->getType()->getAs<RecordType>()->getDecl());
+        Record.push_back(Layout.getBaseClassOffset(Base).getQuantity());
+        if (Base == PrimaryBase && !Layout.isPrimaryBaseVirtual())
+          PrimaryBaseIndex = Index + 1;
+      }
+
+      bool Complete = true;
+      const ASTRecordLayout::VBaseOffsetsMapTy &VBases =
+        Layout.getVBaseOffsetsMap();
+      Index = 0;
+      for (CXXRecordDecl::base_class_iterator B = CXXRD->vbases_begin(),
+                                           BEnd = CXXRD->vbases_end();
+           B != BEnd; ++B, ++Index) {
+        const CXXRecordDecl *Base =
+          cast<CXXRecordDecl>(B->getType()->getAs<RecordType>()->getDecl());
+        ASTRecordLayout::VBaseOffsetsMapTy::const_iterator Pos
+          = VBases.find(Base);
+        if (Pos == VBases.end()) {
+          Complete = false;
+          break;
+        }
+        Record.push_back(Pos->second.VBaseOffset.getQuantity());
+        Record.push_back(Pos->second.hasVtorDisp());
+        if (Base == PrimaryBase && Layout.isPrimaryBaseVirtual())
+          PrimaryBaseIndex = -int64_t(Index) - 1;
+      }
+      if (!Complete || VBases.size() != Index ||
+          (PrimaryBase && !PrimaryBaseIndex))
+        continue;
+      Record.push_back(PrimaryBaseIndex);
+    }
+
+    RecordLayoutOffsets.push_back(getDeclID(RD));
+    RecordLayoutOffsets.push_back(Stream.GetCurrentBitNo());
+    Stream.EmitRecord(DECL_RECORD_LAYOUT, Record);
+
+    if (VTContext && CXXRD && CXXRD->isDynamicClass())
+      WriteVTableLayout(*VTContext, CXXRD);
+  }
+
+  RecordsToLayout.clear();
+}
+
 void ASTWriter::WriteCXXBaseSpecifiersOffsets() {
   if (CXXBaseSpecifiersOffsets.empty())
     return;
@@ -3627,14 +3835,24 @@ void ASTWriter::WriteASTCore(Sema &SemaRef,
                                   E = DeclsToRewrite.end(); 
        I != E; ++I)
     DeclTypesToEmit.push(const_cast<Decl*>(*I));
-  while (!DeclTypesToEmit.empty()) {
-    DeclOrType DOT = DeclTypesToEmit.front();
-    DeclTypesToEmit.pop();
-    if (DOT.isType())
-      WriteType(DOT.getType());
-    else
-      WriteDecl(Context, DOT.getDecl());
-  }
+  // The Microsoft ABI does not use the Itanium vtable layouts.
+  OwningPtr<VTableContext> VTContext;
+  if (Context.getLangOpts().CPlusPlus &&
+      Context.getTargetInfo().getCXXABI() != CXXABI_Microsoft)
+    VTContext.reset(new VTableContext(Context));
+  do {
+    while (!DeclTypesToEmit.empty()) {
+      DeclOrType DOT = DeclTypesToEmit.front();
+      DeclTypesToEmit.pop();
+      if (DOT.isType())
+        WriteType(DOT.getType());
+      else
+        WriteDecl(Context, DOT.getDecl());
+    }
+    // Vtable layouts can refer to declarations that have not been written
+    // yet, so go around again until they have.
+    WriteRecordLayouts(Context, VTContext.get());
+  } while (!DeclTypesToEmit.empty());
   Stream.ExitBlock();
 
   DoneWritingDeclsAndTypes = true;
@@ -3699,6 +3917,11 @@ void ASTWriter::WriteASTCore(Sema &SemaRef,
   WritePragmaDiagnosticMappings(Context.getDiagnostics());
 
   WriteCXXBaseSpecifiersOffsets();
+
+  if (!RecordLayoutOffsets.empty())
+    Stream.EmitRecord(RECORD_LAYOUT_OFFSETS, RecordLayoutOffsets);
+  if (!VTableLayoutOffsets.empty())
+    Stream.EmitRecord(VTABLE_LAYOUT_OFFSETS, VTableLayoutOffsets);
   
   // If we're emitting a module, write out the submodule information.  
   if (WritingModule)
@@ -1752,6 +1752,11 @@ void ASTWriter::WriteDecl(ASTContext &Context, Decl *D) {
   
   // Flush C++ base specifiers, if there are any.
   FlushCXXBaseSpecifiers();
+
+  // Record definitions are laid out once all declarations have been written.
+  if (RecordDecl *RD = dyn_cast<RecordDecl>(D))
+    if (RD->isCompleteDefinition() && !RD->isFromASTFile())
+      RecordsToLayout.push_back(RD);
   
   // Note "external" declarations so that we can add them to a record in the
   // AST file later.
@@ -0,0 +1,688 @@
+//===--- GlobalModuleIndex.cpp - Global Module Index ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the GlobalModuleIndex class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Serialization/GlobalModuleIndex.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Serialization/ASTBitCodes.h"
+#include "clang/Serialization/Module.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PathV2.h"
+#include "llvm/Support/system_error.h"
+#include <cstdio>
+
+using namespace clang;
+using namespace serialization;
+
+//----------------------------------------------------------------------------//
+// Shared constants
+//----------------------------------------------------------------------------//
+namespace {
+  enum {
+    /// \brief The block containing the index.
+    GLOBAL_INDEX_BLOCK_ID = llvm::bitc::FIRST_APPLICATION_BLOCKID
+  };
+
+  /// \brief Describes the record types in the index.
+  enum IndexRecordTypes {
+    /// \brief Contains version information and potentially other metadata,
+    /// used to determine if we can read this global index file.
+    INDEX_METADATA = 1,
+    /// \brief Describes a module, including its file name, size, and
+    /// modification time.
+    MODULE = 2,
+    /// \brief The index for identifiers.
+    IDENTIFIER_INDEX = 3
+  };
+}
+
+/// \brief The name of the global index file.
+static const char * const IndexFileName = "modules.idx";
+
+/// \brief The global index file version.
+static const unsigned CurrentVersion = 1;
+
+//----------------------------------------------------------------------------//
+// Global module index reader.
+//----------------------------------------------------------------------------//
+
+namespace {
+
+/// \brief Trait used to read the identifier index from the on-disk hash
+/// table.
+class IdentifierIndexReaderTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef SmallVector<unsigned, 2> data_type;
+
+  static bool EqualKey(const internal_key_type& a, const internal_key_type& b) {
+    return a == b;
+  }
+
+  static unsigned ComputeHash(const internal_key_type& a) {
+    return llvm::HashString(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace clang::io;
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = ReadUnalignedLE16(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type&
+  GetInternalKey(const external_key_type& x) { return x; }
+
+  static const external_key_type&
+  GetExternalKey(const internal_key_type& x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type& k,
+                            const unsigned char* d,
+                            unsigned DataLen) {
+    using namespace clang::io;
+
+    data_type Result;
+    while (DataLen > 0) {
+      unsigned ID = ReadUnalignedLE32(d);
+      Result.push_back(ID);
+      DataLen -= 4;
+    }
+
+    return Result;
+  }
+};
+
+typedef OnDiskChainedHashTable<IdentifierIndexReaderTrait> IdentifierIndexTable;
+
+}
+
+GlobalModuleIndex::GlobalModuleIndex(llvm::MemoryBuffer *Buffer,
+                                     llvm::BitstreamCursor Cursor)
+  : Buffer(Buffer), IdentifierIndex(),
+    NumIdentifierLookups(), NumIdentifierLookupHits()
+{
+  // Read the global index.
+  bool InGlobalIndexBlock = false;
+  bool Done = false;
+  bool ValidVersion = false;
+  while (!Done && !Cursor.AtEndOfStream()) {
+    unsigned Code = Cursor.ReadCode();
+    if (Code == llvm::bitc::END_BLOCK) {
+      if (Cursor.ReadBlockEnd())
+        return;
+
+      if (InGlobalIndexBlock) {
+        InGlobalIndexBlock = false;
+        Done = true;
+      }
+      continue;
+    }
+
+    if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+      switch (Cursor.ReadSubBlockID()) {
+      case GLOBAL_INDEX_BLOCK_ID:
+        if (Cursor.EnterSubBlock(GLOBAL_INDEX_BLOCK_ID))
+          return;
+
+        InGlobalIndexBlock = true;
+        break;
+
+      default:
+        if (Cursor.SkipBlock())
+          return;
+        break;
+      }
+      continue;
+    }
+
+    if (Code == llvm::bitc::DEFINE_ABBREV) {
+      Cursor.ReadAbbrevRecord();
+      continue;
+    }
+
+    // Read and process a record.
+    SmallVector<uint64_t, 4> Record;
+    const char *BlobStart = 0;
+    unsigned BlobLen = 0;
+    unsigned RecordCode = Cursor.ReadRecord(Code, Record, &BlobStart, &BlobLen);
+    if (!InGlobalIndexBlock)
+      continue;
+
+    switch ((IndexRecordTypes)RecordCode) {
+    case INDEX_METADATA:
+      // Make sure that the version matches.
+      if (Record.size() < 1 || Record[0] != CurrentVersion)
+        return;
+
+      ValidVersion = true;
+      break;
+
+    case MODULE: {
+      if (!ValidVersion || Record.size() < 3)
+        return;
+
+      unsigned Idx = 0;
+      unsigned ID = Record[Idx++];
+      if (ID >= Modules.size())
+        Modules.resize(ID + 1);
+
+      Modules[ID].Size = Record[Idx++];
+      Modules[ID].ModTime = Record[Idx++];
+      Modules[ID].FileName = StringRef(BlobStart, BlobLen);
+      break;
+    }
+
+    case IDENTIFIER_INDEX:
+      if (!ValidVersion)
+        return;
+
+      // Wire up the identifier index.
+      if (Record[0]) {
+        IdentifierIndex = IdentifierIndexTable::Create(
+                            (const unsigned char *)BlobStart + Record[0],
+                            (const unsigned char *)BlobStart,
+                            IdentifierIndexReaderTrait());
+      }
+      break;
+    }
+  }
+}
+
+GlobalModuleIndex::~GlobalModuleIndex() {
+  delete static_cast<IdentifierIndexTable *>(IdentifierIndex);
+}
+
+std::pair<GlobalModuleIndex *, GlobalModuleIndex::ErrorCode>
+GlobalModuleIndex::readIndex(StringRef Path) {
+  // Load the index file, if it's there.
+  SmallString<128> IndexPath;
+  IndexPath += Path;
+  llvm::sys::path::append(IndexPath, IndexFileName);
+
+  // Note that we deliberately bypass the FileManager here: the index is
+  // rewritten whenever a module is built, and the FileManager may have
+  // cached the size and modification time of a previous version.
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(IndexPath.str(), Buffer))
+    return std::make_pair((GlobalModuleIndex *)0, EC_NotFound);
+
+  /// \brief The bitstream reader from which we'll read the index file.
+  llvm::BitstreamReader Reader(
+                          (const unsigned char *)Buffer->getBufferStart(),
+                          (const unsigned char *)Buffer->getBufferEnd());
+
+  /// \brief The main bitstream cursor for the main block.
+  llvm::BitstreamCursor Cursor(Reader);
+
+  // Sniff for the signature.
+  if (Cursor.Read(8) != 'B' ||
+      Cursor.Read(8) != 'C' ||
+      Cursor.Read(8) != 'G' ||
+      Cursor.Read(8) != 'I') {
+    return std::make_pair((GlobalModuleIndex *)0, EC_IOError);
+  }
+
+  GlobalModuleIndex *Index = new GlobalModuleIndex(Buffer.take(), Cursor);
+  if (!Index->IdentifierIndex) {
+    // The index was truncated, corrupted, or written by a different version
+    // of the compiler; ignore it.
+    delete Index;
+    return std::make_pair((GlobalModuleIndex *)0, EC_IOError);
+  }
+
+  return std::make_pair(Index, EC_None);
+}
+
+bool GlobalModuleIndex::lookupIdentifier(StringRef Name, HitSet &Hits) {
+  Hits.clear();
+
+  // If there's no identifier index, there is nothing we can do.
+  if (!IdentifierIndex)
+    return false;
+
+  // Look into the identifier index.
+  ++NumIdentifierLookups;
+  IdentifierIndexTable &Table
+    = *static_cast<IdentifierIndexTable *>(IdentifierIndex);
+  IdentifierIndexTable::iterator Known = Table.find(Name);
+  if (Known == Table.end()) {
+    // None of the module files known to the index mention this identifier.
+    return true;
+  }
+
+  SmallVector<unsigned, 2> ModuleIDs = *Known;
+  for (unsigned I = 0, N = ModuleIDs.size(); I != N; ++I) {
+    unsigned ID = ModuleIDs[I];
+    if (ID >= Modules.size() || !Modules[ID].File)
+      continue;
+
+    Hits.insert(Modules[ID].File);
+  }
+
+  ++NumIdentifierLookupHits;
+  return true;
+}
+
+bool GlobalModuleIndex::loadedModuleFile(ModuleFile *File) {
+  // If we already know about this module file, we're done.
+  if (ModulesByFile.count(File))
+    return false;
+
+  // Only real module files live in the module cache.
+  if (File->Kind != MK_Module || !File->File)
+    return true;
+
+  // Look for a module file with the same name, size, and modification time.
+  // The index only ever describes the module files within its own
+  // directory, so the file name is enough to identify a candidate.
+  StringRef Name = llvm::sys::path::filename(File->FileName);
+  for (unsigned I = 0, N = Modules.size(); I != N; ++I) {
+    ModuleInfo &Info = Modules[I];
+    if (Info.File || Info.FileName != Name)
+      continue;
+
+    // If the module file has changed since the index was built, the index
+    // knows nothing reliable about it.
+    if (Info.Size != File->File->getSize() ||
+        Info.ModTime != File->File->getModificationTime())
+      return true;
+
+    Info.File = File;
+    ModulesByFile[File] = I;
+    return false;
+  }
+
+  return true;
+}
+
+void GlobalModuleIndex::printStats() {
+  std::fprintf(stderr, "*** Global Module Index Statistics:\n");
+  std::fprintf(stderr, "  %u/%u module files resolved\n",
+               (unsigned)ModulesByFile.size(), (unsigned)Modules.size());
+  if (NumIdentifierLookups) {
+    std::fprintf(stderr, "  %u / %u identifier lookups succeeded (%f%%)\n",
+                 NumIdentifierLookupHits, NumIdentifierLookups,
+                 (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
+  }
+  std::fprintf(stderr, "\n");
+}
+
+//----------------------------------------------------------------------------//
+// Global module index writer.
+//----------------------------------------------------------------------------//
+
+namespace {
+  /// \brief Trait used to enumerate the identifiers stored in the identifier
+  /// table of an AST file, without deserializing any of their data.
+  class ASTIdentifierKeyTrait {
+  public:
+    typedef StringRef external_key_type;
+    typedef StringRef internal_key_type;
+    typedef StringRef data_type;
+
+    static std::pair<unsigned, unsigned>
+    ReadKeyDataLength(const unsigned char*& d) {
+      using namespace clang::io;
+      unsigned DataLen = ReadUnalignedLE16(d);
+      unsigned KeyLen = ReadUnalignedLE16(d);
+      return std::make_pair(KeyLen, DataLen);
+    }
+
+    static const external_key_type&
+    GetExternalKey(const internal_key_type& x) { return x; }
+
+    static internal_key_type ReadKey(const unsigned char* d, unsigned n) {
+      assert(n >= 2 && d[n-1] == '\0');
+      return StringRef((const char *)d, n-1);
+    }
+  };
+
+  typedef OnDiskChainedHashTable<ASTIdentifierKeyTrait> ASTIdentifierKeyTable;
+
+  /// \brief Trait used to generate the identifier index as an on-disk hash
+  /// table.
+  class IdentifierIndexWriterTrait {
+  public:
+    typedef StringRef key_type;
+    typedef StringRef key_type_ref;
+    typedef SmallVector<unsigned, 2> data_type;
+    typedef const SmallVector<unsigned, 2> &data_type_ref;
+
+    static unsigned ComputeHash(key_type_ref Key) {
+      return llvm::HashString(Key);
+    }
+
+    std::pair<unsigned,unsigned>
+    EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+      unsigned KeyLen = Key.size();
+      unsigned DataLen = Data.size() * 4;
+      clang::io::Emit16(Out, KeyLen);
+      clang::io::Emit16(Out, DataLen);
+      return std::make_pair(KeyLen, DataLen);
+    }
+
+    void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+      Out.write(Key.data(), KeyLen);
+    }
+
+    void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                  unsigned DataLen) {
+      for (unsigned I = 0, N = Data.size(); I != N; ++I)
+        clang::io::Emit32(Out, Data[I]);
+    }
+  };
+
+  /// \brief Builder that generates the global module index file.
+  class GlobalModuleIndexBuilder {
+    FileManager &FileMgr;
+
+    /// \brief Mapping from module files to their IDs within the index.
+    typedef llvm::MapVector<const FileEntry *, unsigned> ModuleFilesMap;
+
+    /// \brief The module files that have been loaded, in ID order.
+    ModuleFilesMap ModuleFiles;
+
+    typedef llvm::StringMap<SmallVector<unsigned, 2> > IdentifierMap;
+
+    /// \brief A mapping from all of the identifiers found in any module file
+    /// to the set of module files (by ID) whose identifier tables mention
+    /// them.
+    IdentifierMap Identifiers;
+
+  public:
+    explicit GlobalModuleIndexBuilder(FileManager &FileMgr)
+      : FileMgr(FileMgr) { }
+
+    /// \brief Load the contents of the given module file into the builder.
+    ///
+    /// \returns true if an error occurred, false otherwise.
+    bool loadModuleFile(const FileEntry *File);
+
+    /// \brief Write the index to the given bitstream.
+    void writeIndex(llvm::BitstreamWriter &Stream);
+  };
+}
+
+bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
+  // Open the module file.
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  Buffer.reset(FileMgr.getBufferForFile(File));
+  if (!Buffer)
+    return true;
+
+  // Initialize the input stream
+  llvm::BitstreamReader InStreamFile;
+  llvm::BitstreamCursor InStream;
+  InStreamFile.init((const unsigned char *)Buffer->getBufferStart(),
+                    (const unsigned char *)Buffer->getBufferEnd());
+  InStream.init(InStreamFile);
+
+  // Sniff for the signature.
+  if (InStream.Read(8) != 'C' ||
+      InStream.Read(8) != 'P' ||
+      InStream.Read(8) != 'C' ||
+      InStream.Read(8) != 'H') {
+    return true;
+  }
+
+  // Collect the identifiers first, so that a malformed module file does not
+  // leave a partial entry behind.
+  SmallVector<StringRef, 64> FileIdentifiers;
+
+  // Search for the identifier table, which lives directly within the AST
+  // block.
+  bool InASTBlock = false;
+  bool Done = false;
+  while (!Done && !InStream.AtEndOfStream()) {
+    unsigned Code = InStream.ReadCode();
+    if (Code == llvm::bitc::END_BLOCK) {
+      if (InStream.ReadBlockEnd())
+        return true;
+
+      // We only care about the AST block.
+      if (InASTBlock)
+        Done = true;
+      continue;
+    }
+
+    if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+      unsigned BlockID = InStream.ReadSubBlockID();
+      if (!InASTBlock && BlockID == AST_BLOCK_ID) {
+        if (InStream.EnterSubBlock(AST_BLOCK_ID))
+          return true;
+
+        InASTBlock = true;
+        continue;
+      }
+
+      if (!InASTBlock && BlockID == llvm::bitc::BLOCKINFO_BLOCK_ID) {
+        if (InStream.ReadBlockInfoBlock())
+          return true;
+        continue;
+      }
+
+      if (InStream.SkipBlock())
+        return true;
+      continue;
+    }
+
+    if (Code == llvm::bitc::DEFINE_ABBREV) {
+      InStream.ReadAbbrevRecord();
+      continue;
+    }
+
+    // Read the given record.
+    SmallVector<uint64_t, 4> Record;
+    const char *BlobStart = 0;
+    unsigned BlobLen = 0;
+    unsigned RecordCode = InStream.ReadRecord(Code, Record, &BlobStart,
+                                              &BlobLen);
+    if (!InASTBlock || RecordCode != IDENTIFIER_TABLE)
+      continue;
+
+    // Enumerate all of the identifiers in the identifier table. We don't
+    // need anything else from this module file.
+    if (Record[0]) {
+      OwningPtr<ASTIdentifierKeyTable> Table(
+        ASTIdentifierKeyTable::Create(
+          (const unsigned char *)BlobStart + Record[0],
+          (const unsigned char *)BlobStart));
+      for (ASTIdentifierKeyTable::key_iterator K = Table->key_begin(),
+                                            KEnd = Table->key_end();
+           K != KEnd; ++K)
+        FileIdentifiers.push_back(*K);
+    }
+    Done = true;
+  }
+
+  // Record this module file and assign it a unique ID.
+  unsigned ID = ModuleFiles.size();
+  ModuleFiles[File] = ID;
+  for (unsigned I = 0, N = FileIdentifiers.size(); I != N; ++I)
+    Identifiers[FileIdentifiers[I]].push_back(ID);
+
+  return false;
+}
+
+void GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
+  using namespace llvm;
+
+  // Emit the file header.
+  Stream.Emit((unsigned)'B', 8);
+  Stream.Emit((unsigned)'C', 8);
+  Stream.Emit((unsigned)'G', 8);
+  Stream.Emit((unsigned)'I', 8);
+
+  Stream.EnterSubblock(GLOBAL_INDEX_BLOCK_ID, 3);
+
+  // Write the metadata.
+  SmallVector<uint64_t, 4> Record;
+  Record.push_back(CurrentVersion);
+  Stream.EmitRecord(INDEX_METADATA, Record);
+
+  // Write the set of known module files.
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(MODULE));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // ID
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Size
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Modification time
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));   // File name
+  unsigned ModuleAbbrev = Stream.EmitAbbrev(Abbrev);
+
+  for (ModuleFilesMap::iterator M = ModuleFiles.begin(),
+                             MEnd = ModuleFiles.end();
+       M != MEnd; ++M) {
+    Record.clear();
+    Record.push_back(MODULE);
+    Record.push_back(M->second);
+    Record.push_back(M->first->getSize());
+    Record.push_back(M->first->getModificationTime());
+    Stream.EmitRecordWithBlob(ModuleAbbrev, Record,
+                              llvm::sys::path::filename(M->first->getName()));
+  }
+
+  // Write the identifier -> module file mapping.
+  {
+    OnDiskChainedHashTableGenerator<IdentifierIndexWriterTrait> Generator;
+    IdentifierIndexWriterTrait Trait;
+
+    // Populate the hash table.
+    for (IdentifierMap::iterator I = Identifiers.begin(),
+                              IEnd = Identifiers.end();
+         I != IEnd; ++I) {
+      Generator.insert(I->getKey(), I->getValue(), Trait);
+    }
+
+    // Create the on-disk hash table in a buffer.
+    SmallString<4096> IdentifierTable;
+    uint32_t BucketOffset;
+    {
+      llvm::raw_svector_ostream Out(IdentifierTable);
+      // Make sure that no bucket is at offset 0
+      clang::io::Emit32(Out, 0);
+      BucketOffset = Generator.Emit(Out, Trait);
+    }
+
+    // Create a blob abbreviation
+    BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+    Abbrev->Add(BitCodeAbbrevOp(IDENTIFIER_INDEX));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned IDTableAbbrev = Stream.EmitAbbrev(Abbrev);
+
+    // Write the identifier table
+    Record.clear();
+    Record.push_back(IDENTIFIER_INDEX);
+    Record.push_back(BucketOffset);
+    Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable.str());
+  }
+
+  Stream.ExitBlock();
+}
+
+GlobalModuleIndex::ErrorCode
+GlobalModuleIndex::writeIndex(FileManager &FileMgr, StringRef Path) {
+  SmallString<128> IndexPath;
+  IndexPath += Path;
+  llvm::sys::path::append(IndexPath, IndexFileName);
+
+  // Coordinate building the global index file with other processes that might
+  // try to do the same.
+  llvm::LockFileManager Locked(IndexPath);
+  switch (Locked) {
+  case llvm::LockFileManager::LFS_Error:
+    return EC_IOError;
+
+  case llvm::LockFileManager::LFS_Owned:
+    // We're responsible for building the index ourselves. Do so below.
+    break;
+
+  case llvm::LockFileManager::LFS_Shared:
+    // Someone else is responsible for building the index. We don't care
+    // when they finish, so we're done.
+    return EC_Building;
+  }
+
+  // The module index builder.
+  GlobalModuleIndexBuilder Builder(FileMgr);
+
+  // Load each of the module files.
+  llvm::error_code EC;
+  for (llvm::sys::fs::directory_iterator D(Path, EC), DEnd;
+       D != DEnd && !EC;
+       D.increment(EC)) {
+    // If this isn't a module file, we don't care.
+    if (llvm::sys::path::extension(D->path()) != ".pcm")
+      continue;
+
+    // If we can't find the module file, skip it.
+    const FileEntry *ModuleFile = FileMgr.getFile(D->path());
+    if (!ModuleFile)
+      continue;
+
+    // Module files we can't make sense of are simply left out of the index;
+    // clients will search them directly.
+    Builder.loadModuleFile(ModuleFile);
+  }
+
+  // The output buffer, into which the global index will be written.
+  SmallVector<char, 16> OutputBuffer;
+  {
+    llvm::BitstreamWriter OutputStream(OutputBuffer);
+    Builder.writeIndex(OutputStream);
+  }
+
+  // Write the global index file to a temporary file, and then rename it into
+  // place, so that readers never see a partially-written index.
+  SmallString<128> IndexTmpPath;
+  IndexTmpPath = IndexPath;
+  IndexTmpPath += "-%%%%%%%%";
+  int TmpFD;
+  if (llvm::sys::fs::unique_file(IndexTmpPath.str(), TmpFD, IndexTmpPath,
+                                 /*makeAbsolute=*/false))
+    return EC_IOError;
+
+  {
+    llvm::raw_fd_ostream Out(TmpFD, /*shouldClose=*/true);
+    Out.write(OutputBuffer.data(), OutputBuffer.size());
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      bool Existed;
+      llvm::sys::fs::remove(IndexTmpPath.str(), Existed);
+      return EC_IOError;
+    }
+  }
+
+  if (llvm::sys::fs::rename(IndexTmpPath.str(), IndexPath.str())) {
+    bool Existed;
+    llvm::sys::fs::remove(IndexTmpPath.str(), Existed);
+    return EC_IOError;
+  }
+
+  return EC_None;
+}
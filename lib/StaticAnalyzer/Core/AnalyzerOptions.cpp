@@ -133,6 +133,36 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldShareReportGraph() {
+  return getBooleanOption(ShareReportGraph,
+                          "shared-report-graph",
+                          /* Default = */ false);
+}
+
+bool AnalyzerOptions::shouldUseCompactRangeSets() {
+  return getBooleanOption(UseCompactRangeSets,
+                          "compact-range-sets",
+                          /* Default = */ false);
+}
+
+bool AnalyzerOptions::shouldRemoveDeadSymbolsIncrementally() {
+  return getBooleanOption(RemoveDeadSymbolsIncrementally,
+                          "incremental-dead-symbols",
+                          /* Default = */ false);
+}
+
+unsigned AnalyzerOptions::getMaxTranslationUnitTime() {
+  if (!MaxTranslationUnitTime.hasValue())
+    MaxTranslationUnitTime = getOptionAsInteger("max-tu-time", 0);
+  return MaxTranslationUnitTime.getValue();
+}
+
+unsigned AnalyzerOptions::getMaxTranslationUnitSteps() {
+  if (!MaxTranslationUnitSteps.hasValue())
+    MaxTranslationUnitSteps = getOptionAsInteger("max-tu-steps", 0);
+  return MaxTranslationUnitSteps.getValue();
+}
+
 bool AnalyzerOptions::shouldSynthesizeBodies() {
   return getBooleanOption("faux-bodies", true);
 }
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "BugReporter"
+
 #include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/BugType.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
@@ -30,11 +32,38 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Timer.h"
 #include <queue>
 
 using namespace clang;
 using namespace ento;
 
+STATISTIC(NumSharedReportGraphs,
+            "The # of report graphs shared by all the reports of a function");
+STATISTIC(NumSharedReportPaths,
+            "The # of report paths found in a shared report graph");
+
+namespace {
+/// \brief Timers for the phases of path diagnostic generation.  They are only
+/// run with -analyzer-stats.
+struct PathGenerationTimers {
+  llvm::TimerGroup Group;
+  llvm::Timer Trimming;
+  llvm::Timer ShortestPath;
+  llvm::Timer PathGeneration;
+
+  PathGenerationTimers()
+    : Group("Path diagnostic generation"),
+      Trimming("Graph trimming", Group),
+      ShortestPath("Shortest path search", Group),
+      PathGeneration("Path generation", Group) {}
+};
+}
+
+static llvm::ManagedStatic<PathGenerationTimers> PathTimers;
+
 BugReporterVisitor::~BugReporterVisitor() {}
 
 void BugReporterContext::anchor() {}
@@ -1688,6 +1717,9 @@ PathDiagnosticLocation BugReport::getLocation(const SourceManager &SM) const {
 //===----------------------------------------------------------------------===//
 
 BugReportEquivClass::~BugReportEquivClass() { }
+GRBugReporter::GRBugReporter(BugReporterData& d, ExprEngine& eng)
+  : BugReporter(d, GRBugReporterKind), Eng(eng) {}
+
 GRBugReporter::~GRBugReporter() { }
 BugReporterData::~BugReporterData() {}
 
@@ -1722,15 +1754,27 @@ void BugReporter::FlushReports() {
          I = bugTypes.begin(), E = bugTypes.end(); I != E; ++I)
     const_cast<BugType*>(*I)->FlushReports(*this);
 
+  typedef std::vector<BugReportEquivClass *> ContVecTy;
+  SmallVector<const ExplodedNode *, 32> ErrorNodes;
+  for (ContVecTy::iterator EI=EQClassesVector.begin(), EE=EQClassesVector.end();
+       EI != EE; ++EI) {
+    for (BugReportEquivClass::iterator I = (*EI)->begin(), E = (*EI)->end();
+         I != E; ++I)
+      if (const ExplodedNode *N = I->getErrorNode())
+        ErrorNodes.push_back(N);
+  }
+  willFlushReports(ErrorNodes);
+
   // We need to flush reports in deterministic order to ensure the order
   // of the reports is consistent between runs.
-  typedef std::vector<BugReportEquivClass *> ContVecTy;
   for (ContVecTy::iterator EI=EQClassesVector.begin(), EE=EQClassesVector.end();
        EI != EE; ++EI){
     BugReportEquivClass& EQ = **EI;
     FlushReport(EQ);
   }
 
+  didFlushReports();
+
   // BugReporter owns and deletes only BugTypes created implicitly through
   // EmitBasicReport.
   // FIXME: There are leaks from checkers that assume that the BugTypes they
@@ -1747,10 +1791,16 @@ void BugReporter::FlushReports() {
 // PathDiagnostics generation.
 //===----------------------------------------------------------------------===//
 
-static std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
-                 std::pair<ExplodedNode*, unsigned> >
+/// A graph with a single path to an error node, the map from its nodes to
+/// the original graph, the error node, and the index of the error node in the
+/// list of candidates.
+typedef std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
+                  std::pair<ExplodedNode*, unsigned> > ReportGraphResult;
+
+static ReportGraphResult
 MakeReportGraph(const ExplodedGraph* G,
-                SmallVectorImpl<const ExplodedNode*> &nodes) {
+                SmallVectorImpl<const ExplodedNode*> &nodes,
+                PathGenerationTimers *Timers) {
 
   // Create the trimmed graph.  It will contain the shortest paths from the
   // error nodes to the root.  In the new graph we should only have one
@@ -1760,8 +1810,12 @@ MakeReportGraph(const ExplodedGraph* G,
   InterExplodedGraphMap* NMap;
 
   llvm::DenseMap<const void*, const void*> InverseMap;
-  llvm::tie(GTrim, NMap) = G->Trim(nodes.data(), nodes.data() + nodes.size(),
-                                   &InverseMap);
+  {
+    llvm::TimeRegion T(Timers ? &Timers->Trimming : 0);
+    llvm::tie(GTrim, NMap) = G->Trim(nodes.data(), nodes.data() + nodes.size(),
+                                     &InverseMap);
+  }
+  llvm::TimeRegion T(Timers ? &Timers->ShortestPath : 0);
 
   // Create owning pointers for GTrim and NMap just to ensure that they are
   // released when this function exists.
@@ -1882,6 +1936,163 @@ MakeReportGraph(const ExplodedGraph* G,
                         std::make_pair(First, NodeIndex));
 }
 
+namespace clang {
+namespace ento {
+/// \brief The ExplodedGraph trimmed to the paths to the error nodes of all the
+/// reports of a function, together with a shortest path from a root to each
+/// of its nodes.
+///
+/// This lets the bug reporter trim the graph and search for shortest paths
+/// once, instead of once for every report.
+class TrimmedReportGraph {
+  OwningPtr<ExplodedGraph> G;
+  OwningPtr<InterExplodedGraphMap> NMap;
+
+  /// Maps the nodes of the trimmed graph to the original graph.
+  llvm::DenseMap<const void*, const void*> InverseMap;
+
+  struct PathInfo {
+    /// The previous node on a shortest path from a root.
+    const ExplodedNode *Pred;
+    /// The length of that path.
+    unsigned Distance;
+  };
+
+  /// The shortest paths from a root to every node of the trimmed graph.
+  llvm::DenseMap<const ExplodedNode*, PathInfo> Paths;
+
+public:
+  TrimmedReportGraph(const ExplodedGraph &Original,
+                     ArrayRef<const ExplodedNode*> ErrorNodes,
+                     PathGenerationTimers *Timers);
+
+  /// \brief Like MakeReportGraph(), but using the paths computed up front.
+  ///
+  /// Returns false if none of the nodes is in the trimmed graph.
+  bool makeReportGraph(ArrayRef<const ExplodedNode*> Nodes,
+                       ReportGraphResult &Result) const;
+};
+} // end namespace ento
+} // end namespace clang
+
+TrimmedReportGraph::TrimmedReportGraph(const ExplodedGraph &Original,
+                                       ArrayRef<const ExplodedNode*> ErrorNodes,
+                                       PathGenerationTimers *Timers) {
+  {
+    llvm::TimeRegion T(Timers ? &Timers->Trimming : 0);
+    ExplodedGraph *GTrim;
+    InterExplodedGraphMap *Map;
+    llvm::tie(GTrim, Map) = Original.Trim(ErrorNodes.data(),
+                                          ErrorNodes.data() + ErrorNodes.size(),
+                                          &InverseMap);
+    G.reset(GTrim);
+    NMap.reset(Map);
+  }
+  if (!G)
+    return;
+
+  // A single breadth-first search from the roots finds the shortest paths to
+  // all the error nodes at once.
+  llvm::TimeRegion T(Timers ? &Timers->ShortestPath : 0);
+  std::queue<const ExplodedNode*> WS;
+  for (ExplodedGraph::const_roots_iterator I = G->roots_begin(),
+       E = G->roots_end(); I != E; ++I) {
+    PathInfo &Info = Paths[*I];
+    Info.Pred = 0;
+    Info.Distance = 0;
+    WS.push(*I);
+  }
+
+  while (!WS.empty()) {
+    const ExplodedNode *Node = WS.front();
+    WS.pop();
+    unsigned Distance = Paths[Node].Distance + 1;
+
+    for (ExplodedNode::const_succ_iterator I = Node->succ_begin(),
+         E = Node->succ_end(); I != E; ++I) {
+      if (Paths.count(*I))
+        continue;
+      PathInfo &Info = Paths[*I];
+      Info.Pred = Node;
+      Info.Distance = Distance;
+      WS.push(*I);
+    }
+  }
+}
+
+bool TrimmedReportGraph::makeReportGraph(ArrayRef<const ExplodedNode*> Nodes,
+                                         ReportGraphResult &Result) const {
+  if (!G)
+    return false;
+
+  // Find the error node closest to a root.  On ties, prefer the first one.
+  const ExplodedNode *Closest = 0;
+  unsigned ClosestIndex = 0, ClosestDistance = 0;
+  for (unsigned I = 0, E = Nodes.size(); I != E; ++I) {
+    if (!Nodes[I])
+      continue;
+    const ExplodedNode *N = NMap->getMappedNode(Nodes[I]);
+    if (!N)
+      continue;
+    llvm::DenseMap<const ExplodedNode*, PathInfo>::const_iterator PI =
+      Paths.find(N);
+    if (PI == Paths.end())
+      continue;
+    if (!Closest || PI->second.Distance < ClosestDistance) {
+      Closest = N;
+      ClosestIndex = I;
+      ClosestDistance = PI->second.Distance;
+    }
+  }
+  if (!Closest)
+    return false;
+
+  SmallVector<const ExplodedNode*, 64> Path;
+  for (const ExplodedNode *N = Closest; N; N = Paths.find(N)->second.Pred)
+    Path.push_back(N);
+
+  // Copy the path, from the root down, into a new graph.
+  ExplodedGraph *GNew = new ExplodedGraph();
+  NodeBackMap *BM = new NodeBackMap();
+  ExplodedNode *Last = 0;
+  for (SmallVectorImpl<const ExplodedNode*>::reverse_iterator
+       I = Path.rbegin(), E = Path.rend(); I != E; ++I) {
+    const ExplodedNode *N = *I;
+    ExplodedNode *NewN = GNew->getNode(N->getLocation(), N->getState());
+
+    llvm::DenseMap<const void*, const void*>::const_iterator IMitr =
+      InverseMap.find(N);
+    assert(IMitr != InverseMap.end() && "No mapping to original node.");
+    (*BM)[NewN] = (const ExplodedNode*) IMitr->second;
+
+    if (Last)
+      NewN->addPredecessor(Last, *GNew);
+    Last = NewN;
+  }
+
+  ++NumSharedReportPaths;
+  Result = std::make_pair(std::make_pair(GNew, BM),
+                          std::make_pair(Last, ClosestIndex));
+  return true;
+}
+
+void GRBugReporter::willFlushReports(ArrayRef<const ExplodedNode*> ErrorNodes) {
+  // Sharing only pays off when there is more than one path to find.
+  if (ErrorNodes.size() < 2 ||
+      !Eng.getAnalysisManager().options.shouldShareReportGraph())
+    return;
+
+  PathGenerationTimers *Timers = 0;
+  if (Eng.getAnalysisManager().options.PrintStats)
+    Timers = &*PathTimers;
+  ReportGraph.reset(new TrimmedReportGraph(getGraph(), ErrorNodes, Timers));
+  ++NumSharedReportGraphs;
+}
+
+void GRBugReporter::didFlushReports() {
+  ReportGraph.reset();
+}
+
 /// CompactPathDiagnostic - This function postprocesses a PathDiagnostic object
 ///  and collapses PathDiagosticPieces that are expanded by macros.
 static void CompactPathDiagnostic(PathPieces &path, const SourceManager& SM) {
@@ -1999,11 +2210,15 @@ bool GRBugReporter::generatePathDiagnostic(PathDiagnostic& PD,
   if (!HasValid)
     return false;
 
+  PathGenerationTimers *Timers = 0;
+  if (Eng.getAnalysisManager().options.PrintStats)
+    Timers = &*PathTimers;
+
   // Construct a new graph that contains only a single path from the error
   // node to a root.
-  const std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
-  std::pair<ExplodedNode*, unsigned> >&
-    GPair = MakeReportGraph(&getGraph(), errorNodes);
+  ReportGraphResult GPair;
+  if (!ReportGraph || !ReportGraph->makeReportGraph(errorNodes, GPair))
+    GPair = MakeReportGraph(&getGraph(), errorNodes, Timers);
 
   // Find the BugReport with the original location.
   assert(GPair.second.second < bugReports.size());
@@ -2059,30 +2274,27 @@ bool GRBugReporter::generatePathDiagnostic(PathDiagnostic& PD,
         return false;
     }
 
-    switch (PDB.getGenerationScheme()) {
-    case PathDiagnosticConsumer::Extensive:
-      if (!GenerateExtensivePathDiagnostic(PD, PDB, N, visitors)) {
-        assert(!R->isValid() && "Failed on valid report");
-        // Try again. We'll filter out the bad report when we trim the graph.
-        // FIXME: It would be more efficient to use the same intermediate
-        // trimmed graph, and just repeat the shortest-path search.
-        return generatePathDiagnostic(PD, PC, bugReports);
-      }
-      break;
-    case PathDiagnosticConsumer::Minimal:
-      if (!GenerateMinimalPathDiagnostic(PD, PDB, N, visitors)) {
-        assert(!R->isValid() && "Failed on valid report");
-        // Try again. We'll filter out the bad report when we trim the graph.
-        return generatePathDiagnostic(PD, PC, bugReports);
-      }
-      break;
-    case PathDiagnosticConsumer::None:
-      if (!GenerateVisitorsOnlyPathDiagnostic(PD, PDB, N, visitors)) {
-        assert(!R->isValid() && "Failed on valid report");
-        // Try again. We'll filter out the bad report when we trim the graph.
-        return generatePathDiagnostic(PD, PC, bugReports);
+    bool Generated = false;
+    {
+      llvm::TimeRegion T(Timers ? &Timers->PathGeneration : 0);
+      switch (PDB.getGenerationScheme()) {
+      case PathDiagnosticConsumer::Extensive:
+        Generated = GenerateExtensivePathDiagnostic(PD, PDB, N, visitors);
+        break;
+      case PathDiagnosticConsumer::Minimal:
+        Generated = GenerateMinimalPathDiagnostic(PD, PDB, N, visitors);
+        break;
+      case PathDiagnosticConsumer::None:
+        Generated = GenerateVisitorsOnlyPathDiagnostic(PD, PDB, N, visitors);
+        break;
       }
-      break;
+    }
+    if (!Generated) {
+      assert(!R->isValid() && "Failed on valid report");
+      // Try again. We'll filter out the bad report when we trim the graph.
+      // With a shared report graph, this only repeats the shortest-path
+      // search.
+      return generatePathDiagnostic(PD, PC, bugReports);
     }
 
     // Clean up the visitors we used.
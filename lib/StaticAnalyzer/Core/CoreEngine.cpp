@@ -210,6 +210,7 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
     }
 
     NumSteps++;
+    NumStepsTaken++;
 
     const WorkListUnit& WU = WList->dequeue();
 
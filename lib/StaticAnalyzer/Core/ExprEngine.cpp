@@ -16,6 +16,7 @@
 #define DEBUG_TYPE "ExprEngine"
 
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
+#include "clang/Analysis/Analyses/LiveVariables.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/BugType.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
@@ -41,6 +42,10 @@ using llvm::APSInt;
 
 STATISTIC(NumRemoveDeadBindings,
             "The # of times RemoveDeadBindings is called");
+STATISTIC(NumRemoveDeadBindingsReused,
+            "The # of times RemoveDeadBindings reused an earlier cleanup");
+STATISTIC(NumRemoveDeadBindingsWithDeadSymbols,
+            "The # of times RemoveDeadBindings found dead symbols");
 STATISTIC(NumMaxBlockCountReached,
             "The # of aborted paths due to reaching the maximum block count in "
             "a top level function");
@@ -69,7 +74,9 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
     EntryNode(NULL),
     currStmt(NULL), currStmtIdx(0), currBldrCtx(0),
     ObjCNoRet(mgr.getASTContext()),
-    ObjCGCEnabled(gcEnabled), BR(mgr, *this),
+    ObjCGCEnabled(gcEnabled),
+    IncrementalRemoveDead(mgr.options.shouldRemoveDeadSymbolsIncrementally()),
+    BR(mgr, *this),
     VisitedCallees(VisitedCalleesIn)
 {
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
@@ -239,6 +246,10 @@ void ExprEngine::processCFGElement(const CFGElement E, ExplodedNode *Pred,
   currBldrCtx = 0;
 }
 
+/// The number of earlier cleanups which removeDead remembers before it
+/// starts over, so that the states they refer to can be reclaimed.
+static const unsigned MaxRemoveDeadCacheSize = 1 << 16;
+
 static bool shouldRemoveDeadBindings(AnalysisManager &AMgr,
                                      const CFGStmt S,
                                      const ExplodedNode *Pred,
@@ -276,6 +287,37 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
           && "PostStmt is not generally supported by the SymbolReaper yet");
   NumRemoveDeadBindings++;
   CleanedState = Pred->getState();
+
+  // A tag to track convenience transitions, which can be removed at cleanup.
+  static SimpleProgramPointTag cleanupTag("ExprEngine : Clean Node");
+
+  // The cleanup only depends on the state and on what is live before the
+  // reference statement. If this state has been cleaned up before at a
+  // statement with the same live expressions and variables, and no symbols
+  // died, reuse the cleaned state instead of sweeping again.
+  RemoveDeadKey Key;
+  bool Reusable = false;
+  if (IncrementalRemoveDead && ReferenceStmt &&
+      K == ProgramPoint::PreStmtPurgeDeadSymbolsKind) {
+    if (LiveVariables *LV = LC->getAnalysis<RelaxedLiveVariables>()) {
+      Key = RemoveDeadKey(CleanedState.getPtr(),
+                          std::make_pair(LC,
+                                         LV->getLivenessClass(ReferenceStmt)));
+      Reusable = true;
+
+      llvm::DenseMap<RemoveDeadKey,
+                     std::pair<ProgramStateRef, ProgramStateRef> >::iterator
+        I = RemoveDeadCache.find(Key);
+      if (I != RemoveDeadCache.end()) {
+        NumRemoveDeadBindingsReused++;
+        CleanedState = I->second.second;
+        StmtNodeBuilder Bldr(Pred, Out, *currBldrCtx);
+        Bldr.generateNode(DiagnosticStmt, Pred, CleanedState, &cleanupTag, K);
+        return;
+      }
+    }
+  }
+
   SymbolReaper SymReaper(LC, ReferenceStmt, SymMgr, getStoreManager());
 
   getCheckerManager().runCheckersForLiveSymbols(CleanedState, SymReaper);
@@ -287,8 +329,6 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
   CleanedState = StateMgr.removeDeadBindings(CleanedState, SFC, SymReaper);
 
   // Process any special transfer function for dead symbols.
-  // A tag to track convenience transitions, which can be removed at cleanup.
-  static SimpleProgramPointTag cleanupTag("ExprEngine : Clean Node");
   if (!SymReaper.hasDeadSymbols()) {
     // Generate a CleanedNode that has the environment and store cleaned
     // up. Since no symbols are dead, we can optimize and not clean out
@@ -296,7 +336,18 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
     StmtNodeBuilder Bldr(Pred, Out, *currBldrCtx);
     Bldr.generateNode(DiagnosticStmt, Pred, CleanedState, &cleanupTag, K);
 
+    if (Reusable) {
+      // Cleaning up the cleaned state at the same liveness changes nothing,
+      // so remember that too.
+      if (RemoveDeadCache.size() >= MaxRemoveDeadCacheSize)
+        RemoveDeadCache.clear();
+      RemoveDeadCache[Key] = std::make_pair(Pred->getState(), CleanedState);
+      Key.first = CleanedState.getPtr();
+      RemoveDeadCache[Key] = std::make_pair(CleanedState, CleanedState);
+    }
   } else {
+    NumRemoveDeadBindingsWithDeadSymbols++;
+
     // Call checkers with the non-cleaned state so that they could query the
     // values of the soon to be dead symbols.
     ExplodedNodeSet CheckedSet;
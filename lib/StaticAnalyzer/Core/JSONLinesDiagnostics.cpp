@@ -0,0 +1,239 @@
+//===--- JSONLinesDiagnostics.cpp - JSON Lines Diagnostics for Paths ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the JSONLinesDiagnostics object, which appends the
+//  reports of a translation unit to a single file holding one JSON object
+//  per line.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/StaticAnalyzer/Core/PathDiagnosticConsumers.h"
+#include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+using namespace ento;
+
+namespace {
+
+/// \brief Writes each report as a JSON object on a line of its own.
+///
+/// The reports of all translation units analyzed with the same output file
+/// are appended to it, so a whole project run produces one file that can be
+/// read sequentially. To keep that file small, file names and messages are
+/// interned: every distinct string is written once, as a "string" record, and
+/// is referred to by its index afterwards. The indices are only meaningful
+/// within the records written for one translation unit, which start with a
+/// "begin" record.
+class JSONLinesDiagnostics : public PathDiagnosticConsumer {
+  const std::string OutputFile;
+
+public:
+  JSONLinesDiagnostics(const std::string &output) : OutputFile(output) {}
+
+  virtual ~JSONLinesDiagnostics() {}
+
+  void FlushDiagnosticsImpl(std::vector<const PathDiagnostic *> &Diags,
+                            FilesMade *filesMade);
+
+  virtual StringRef getName() const {
+    return "JSONLinesDiagnostics";
+  }
+
+  PathGenerationScheme getGenerationScheme() const { return Minimal; }
+  bool supportsLogicalOpControlFlow() const { return true; }
+  bool supportsAllBlockEdges() const { return true; }
+  virtual bool supportsCrossFileDiagnostics() const { return true; }
+};
+
+/// \brief Assigns indices to strings, writing out a "string" record for each
+/// string the first time it is seen.
+class StringTable {
+  llvm::StringMap<unsigned> Indices;
+  raw_ostream &OS;
+
+public:
+  StringTable(raw_ostream &os) : OS(os) {}
+
+  unsigned intern(StringRef S);
+};
+
+} // end anonymous namespace
+
+void ento::createJSONLinesDiagnosticConsumer(PathDiagnosticConsumers &C,
+                                             const std::string &s,
+                                             const Preprocessor &PP) {
+  C.push_back(new JSONLinesDiagnostics(s));
+}
+
+static raw_ostream &EmitString(raw_ostream &o, StringRef s) {
+  o << '"';
+  for (StringRef::const_iterator I = s.begin(), E = s.end(); I != E; ++I) {
+    unsigned char c = *I;
+    switch (c) {
+    case '"':  o << "\\\""; break;
+    case '\\': o << "\\\\"; break;
+    case '\n': o << "\\n"; break;
+    case '\t': o << "\\t"; break;
+    default:
+      if (c < 0x20)
+        o << "\\u00" << hexdigit(c >> 4, true) << hexdigit(c & 0xF, true);
+      else
+        o << c;
+      break;
+    }
+  }
+  o << '"';
+  return o;
+}
+
+unsigned StringTable::intern(StringRef S) {
+  unsigned NumStrings = Indices.size();
+  unsigned Index = Indices.GetOrCreateValue(S, NumStrings).getValue();
+  if (Indices.size() != NumStrings) {
+    OS << "{\"kind\":\"string\",\"id\":" << Index << ",\"value\":";
+    EmitString(OS, S) << "}\n";
+  }
+  return Index;
+}
+
+static void EmitLocation(raw_ostream &o, StringTable &Strings,
+                         const SourceManager &SM, SourceLocation L) {
+  FullSourceLoc Loc(SM.getExpansionLoc(L), SM);
+  const FileEntry *File = SM.getFileEntryForID(Loc.getFileID());
+  o << Strings.intern(File ? File->getName() : "") << ','
+    << Loc.getExpansionLineNumber() << ','
+    << Loc.getExpansionColumnNumber();
+}
+
+static void EmitEvent(raw_ostream &o, StringTable &Strings,
+                      const SourceManager &SM, const PathDiagnosticPiece &P,
+                      unsigned depth, bool &isFirst) {
+  if (!isFirst)
+    o << ',';
+  isFirst = false;
+
+  o << '[' << depth << ',';
+  EmitLocation(o, Strings, SM, P.getLocation().asLocation());
+  o << ',' << Strings.intern(P.getString()) << ']';
+}
+
+/// \brief Emit the events of a path as [depth, file, line, column, message]
+/// tuples. Control flow pieces are left out.
+static void EmitPath(raw_ostream &o, StringTable &Strings,
+                     const SourceManager &SM, const PathPieces &Path,
+                     unsigned depth, bool &isFirst) {
+  for (PathPieces::const_iterator I = Path.begin(), E = Path.end();
+       I != E; ++I) {
+    const PathDiagnosticPiece &P = **I;
+    switch (P.getKind()) {
+    case PathDiagnosticPiece::ControlFlow:
+      break;
+    case PathDiagnosticPiece::Event:
+      EmitEvent(o, Strings, SM, P, depth, isFirst);
+      break;
+    case PathDiagnosticPiece::Macro:
+      EmitPath(o, Strings, SM, cast<PathDiagnosticMacroPiece>(P).subPieces,
+               depth, isFirst);
+      break;
+    case PathDiagnosticPiece::Call: {
+      const PathDiagnosticCallPiece &Call = cast<PathDiagnosticCallPiece>(P);
+      IntrusiveRefCntPtr<PathDiagnosticEventPiece> Event =
+        Call.getCallEnterEvent();
+      if (Event)
+        EmitEvent(o, Strings, SM, *Event, depth, isFirst);
+      Event = Call.getCallEnterWithinCallerEvent();
+      if (Event)
+        EmitEvent(o, Strings, SM, *Event, depth + 1, isFirst);
+      EmitPath(o, Strings, SM, Call.path, depth + 1, isFirst);
+      Event = Call.getCallExitEvent();
+      if (Event)
+        EmitEvent(o, Strings, SM, *Event, depth + 1, isFirst);
+      break;
+    }
+    }
+  }
+}
+
+void JSONLinesDiagnostics::FlushDiagnosticsImpl(
+                                    std::vector<const PathDiagnostic *> &Diags,
+                                    FilesMade *filesMade) {
+  if (Diags.empty())
+    return;
+
+  const SourceManager &SM =
+    (*Diags.front()->path.begin())->getLocation().getManager();
+
+  // Build all the records first, and write them to the output file at once.
+  // Several analyzer processes can then append to the same file.
+  SmallString<4096> Buf;
+  llvm::raw_svector_ostream o(Buf);
+  StringTable Strings(o);
+
+  o << "{\"kind\":\"begin\",\"version\":";
+  EmitString(o, getClangFullVersion()) << "}\n";
+
+  SmallString<1024> DiagBuf;
+  for (std::vector<const PathDiagnostic *>::iterator DI = Diags.begin(),
+       DE = Diags.end(); DI != DE; ++DI) {
+    const PathDiagnostic *D = *DI;
+
+    // The "string" records for a report need to come before the report
+    // itself, so the report is built separately.
+    DiagBuf.clear();
+    llvm::raw_svector_ostream d(DiagBuf);
+
+    d << "{\"kind\":\"diagnostic\""
+      << ",\"description\":" << Strings.intern(D->getShortDescription())
+      << ",\"category\":" << Strings.intern(D->getCategory())
+      << ",\"type\":" << Strings.intern(D->getBugType());
+
+    if (const Decl *DeclWithIssue = D->getDeclWithIssue()) {
+      if (const NamedDecl *ND = dyn_cast<NamedDecl>(DeclWithIssue))
+        d << ",\"context\":"
+          << Strings.intern(ND->getDeclName().getAsString());
+
+      // The same hash as in the plist output: the line offset of the issue
+      // from the beginning of the function body.
+      if (const Stmt *Body = DeclWithIssue->getBody()) {
+        FullSourceLoc Loc(SM.getExpansionLoc(D->getLocation().asLocation()),
+                          SM);
+        FullSourceLoc FunLoc(SM.getExpansionLoc(Body->getLocStart()), SM);
+        d << ",\"issue_hash\":"
+          << Loc.getExpansionLineNumber() - FunLoc.getExpansionLineNumber();
+      }
+    }
+
+    d << ",\"location\":[";
+    EmitLocation(d, Strings, SM, D->getLocation().asLocation());
+    d << "],\"path\":[";
+    bool isFirst = true;
+    EmitPath(d, Strings, SM, D->path, 0, isFirst);
+    d << "]}\n";
+
+    o << d.str();
+  }
+
+  std::string ErrMsg;
+  llvm::raw_fd_ostream OS(OutputFile.c_str(), ErrMsg,
+                          llvm::raw_fd_ostream::F_Append);
+  if (!ErrMsg.empty()) {
+    llvm::errs() << "warning: could not create file: " << OutputFile << '\n';
+    return;
+  }
+  OS.SetUnbuffered();
+  OS << o.str();
+}
@@ -12,18 +12,31 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "RangeConstraintManager"
 #include "SimpleConstraintManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/APSIntType.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/AlignOf.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace ento;
 
+STATISTIC(NumCompactIntersections,
+            "The # of intersections computed on compact range sets");
+STATISTIC(NumMemoizedIntersections,
+            "The # of compact range set intersections found in the memo");
+
 /// A Range represents the closed range [from, to].  The caller must
 /// guarantee that from <= to.  Note that Range is immutable, so as not
 /// to subvert RangeSet's immutability.
@@ -67,6 +80,165 @@ public:
   }
 };
 
+/// Restrict the modular range [Lower, Upper] to the values of the given type.
+///
+/// This function has nine cases, the cartesian product of range-testing
+/// both the upper and lower bounds against the symbol's type.
+/// Each case requires a different pinning operation.
+/// The function returns false if the described range is entirely outside
+/// the range of values for the associated symbol.
+static bool pinToType(APSIntType Type, llvm::APSInt &Lower,
+                      llvm::APSInt &Upper) {
+  APSIntType::RangeTestResultKind LowerTest = Type.testInRange(Lower);
+  APSIntType::RangeTestResultKind UpperTest = Type.testInRange(Upper);
+
+  switch (LowerTest) {
+  case APSIntType::RTR_Below:
+    switch (UpperTest) {
+    case APSIntType::RTR_Below:
+      // The entire range is outside the symbol's set of possible values.
+      // If this is a conventionally-ordered range, the state is infeasible.
+      if (Lower < Upper)
+        return false;
+
+      // However, if the range wraps around, it spans all possible values.
+      Lower = Type.getMinValue();
+      Upper = Type.getMaxValue();
+      break;
+    case APSIntType::RTR_Within:
+      // The range starts below what's possible but ends within it. Pin.
+      Lower = Type.getMinValue();
+      Type.apply(Upper);
+      break;
+    case APSIntType::RTR_Above:
+      // The range spans all possible values for the symbol. Pin.
+      Lower = Type.getMinValue();
+      Upper = Type.getMaxValue();
+      break;
+    }
+    break;
+  case APSIntType::RTR_Within:
+    switch (UpperTest) {
+    case APSIntType::RTR_Below:
+      // The range wraps around, but all lower values are not possible.
+      Type.apply(Lower);
+      Upper = Type.getMaxValue();
+      break;
+    case APSIntType::RTR_Within:
+      // The range may or may not wrap around, but both limits are valid.
+      Type.apply(Lower);
+      Type.apply(Upper);
+      break;
+    case APSIntType::RTR_Above:
+      // The range starts within what's possible but ends above it. Pin.
+      Type.apply(Lower);
+      Upper = Type.getMaxValue();
+      break;
+    }
+    break;
+  case APSIntType::RTR_Above:
+    switch (UpperTest) {
+    case APSIntType::RTR_Below:
+      // The range wraps but is outside the symbol's set of possible values.
+      return false;
+    case APSIntType::RTR_Within:
+      // The range starts above what's possible but ends within it (wrap).
+      Lower = Type.getMinValue();
+      Type.apply(Upper);
+      break;
+    case APSIntType::RTR_Above:
+      // The entire range is outside the symbol's set of possible values.
+      // If this is a conventionally-ordered range, the state is infeasible.
+      if (Lower < Upper)
+        return false;
+
+      // However, if the range wraps around, it spans all possible values.
+      Lower = Type.getMinValue();
+      Upper = Type.getMaxValue();
+      break;
+    }
+    break;
+  }
+
+  return true;
+}
+
+/// Append to \p NewRanges the intersections of the sorted ranges starting at
+/// \p i with the closed range [Lower, Upper].  Stops at the first range past
+/// Upper, leaving \p i there.
+template <typename IteratorTy>
+static void IntersectInRange(BasicValueFactory &BV,
+                             const llvm::APSInt &Lower,
+                             const llvm::APSInt &Upper,
+                             SmallVectorImpl<Range> &NewRanges,
+                             IteratorTy &i, IteratorTy e) {
+  // There are six cases for each range R in the set:
+  //   1. R is entirely before the intersection range.
+  //   2. R is entirely after the intersection range.
+  //   3. R contains the entire intersection range.
+  //   4. R starts before the intersection range and ends in the middle.
+  //   5. R starts in the middle of the intersection range and ends after it.
+  //   6. R is entirely contained in the intersection range.
+  // These correspond to each of the conditions below.
+  for (/* i = begin(), e = end() */; i != e; ++i) {
+    if (i->To() < Lower) {
+      continue;
+    }
+    if (i->From() > Upper) {
+      break;
+    }
+
+    if (i->Includes(Lower)) {
+      if (i->Includes(Upper)) {
+        NewRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
+        break;
+      } else
+        NewRanges.push_back(Range(BV.getValue(Lower), i->To()));
+    } else {
+      if (i->Includes(Upper)) {
+        NewRanges.push_back(Range(i->From(), BV.getValue(Upper)));
+        break;
+      } else
+        NewRanges.push_back(*i);
+    }
+  }
+}
+
+/// Intersect the sorted ranges [i, e) with the modular range [Lower, Upper],
+/// which must already be pinned to their type.
+template <typename IteratorTy>
+static void IntersectRanges(BasicValueFactory &BV,
+                            const llvm::APSInt &Lower,
+                            const llvm::APSInt &Upper,
+                            SmallVectorImpl<Range> &NewRanges,
+                            IteratorTy i, IteratorTy e) {
+  if (Lower <= Upper)
+    IntersectInRange(BV, Lower, Upper, NewRanges, i, e);
+  else {
+    // The order of the next two statements is important!
+    // IntersectInRange() does not reset the iteration state for i and e.
+    // Therefore, the lower range most be handled first.
+    IntersectInRange(BV, BV.getMinValue(Upper), Upper, NewRanges, i, e);
+    IntersectInRange(BV, Lower, BV.getMaxValue(Lower), NewRanges, i, e);
+  }
+}
+
+template <typename IteratorTy>
+static void printRanges(raw_ostream &os, IteratorTy i, IteratorTy e) {
+  bool isFirst = true;
+  os << "{ ";
+  for (; i != e; ++i) {
+    if (isFirst)
+      isFirst = false;
+    else
+      os << ", ";
+
+    os << '[' << i->From().toString(10) << ", " << i->To().toString(10)
+       << ']';
+  }
+  os << " }";
+}
+
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
@@ -102,131 +274,11 @@ public:
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower,
-                        const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges,
-                        PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
-    // There are six cases for each range R in the set:
-    //   1. R is entirely before the intersection range.
-    //   2. R is entirely after the intersection range.
-    //   3. R contains the entire intersection range.
-    //   4. R starts before the intersection range and ends in the middle.
-    //   5. R starts in the middle of the intersection range and ends after it.
-    //   6. R is entirely contained in the intersection range.
-    // These correspond to each of the conditions below.
-    for (/* i = begin(), e = end() */; i != e; ++i) {
-      if (i->To() < Lower) {
-        continue;
-      }
-      if (i->From() > Upper) {
-        break;
-      }
-
-      if (i->Includes(Lower)) {
-        if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower),
-                                             BV.getValue(Upper)));
-          break;
-        } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
-      } else {
-        if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
-          break;
-        } else
-          newRanges = F.add(newRanges, *i);
-      }
-    }
-  }
-
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
     return ranges.begin()->From();
   }
 
-  bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
-    // This function has nine cases, the cartesian product of range-testing
-    // both the upper and lower bounds against the symbol's type.
-    // Each case requires a different pinning operation.
-    // The function returns false if the described range is entirely outside
-    // the range of values for the associated symbol.
-    APSIntType Type(getMinValue());
-    APSIntType::RangeTestResultKind LowerTest = Type.testInRange(Lower);
-    APSIntType::RangeTestResultKind UpperTest = Type.testInRange(Upper);
-
-    switch (LowerTest) {
-    case APSIntType::RTR_Below:
-      switch (UpperTest) {
-      case APSIntType::RTR_Below:
-        // The entire range is outside the symbol's set of possible values.
-        // If this is a conventionally-ordered range, the state is infeasible.
-        if (Lower < Upper)
-          return false;
-
-        // However, if the range wraps around, it spans all possible values.
-        Lower = Type.getMinValue();
-        Upper = Type.getMaxValue();
-        break;
-      case APSIntType::RTR_Within:
-        // The range starts below what's possible but ends within it. Pin.
-        Lower = Type.getMinValue();
-        Type.apply(Upper);
-        break;
-      case APSIntType::RTR_Above:
-        // The range spans all possible values for the symbol. Pin.
-        Lower = Type.getMinValue();
-        Upper = Type.getMaxValue();
-        break;
-      }
-      break;
-    case APSIntType::RTR_Within:
-      switch (UpperTest) {
-      case APSIntType::RTR_Below:
-        // The range wraps around, but all lower values are not possible.
-        Type.apply(Lower);
-        Upper = Type.getMaxValue();
-        break;
-      case APSIntType::RTR_Within:
-        // The range may or may not wrap around, but both limits are valid.
-        Type.apply(Lower);
-        Type.apply(Upper);
-        break;
-      case APSIntType::RTR_Above:
-        // The range starts within what's possible but ends above it. Pin.
-        Type.apply(Lower);
-        Upper = Type.getMaxValue();
-        break;
-      }
-      break;
-    case APSIntType::RTR_Above:
-      switch (UpperTest) {
-      case APSIntType::RTR_Below:
-        // The range wraps but is outside the symbol's set of possible values.
-        return false;
-      case APSIntType::RTR_Within:
-        // The range starts above what's possible but ends within it (wrap).
-        Lower = Type.getMinValue();
-        Type.apply(Upper);
-        break;
-      case APSIntType::RTR_Above:
-        // The entire range is outside the symbol's set of possible values.
-        // If this is a conventionally-ordered range, the state is infeasible.
-        if (Lower < Upper)
-          return false;
-
-        // However, if the range wraps around, it spans all possible values.
-        Lower = Type.getMinValue();
-        Upper = Type.getMaxValue();
-        break;
-      }
-      break;
-    }
-
-    return true;
-  }
-
 public:
   // Returns a set containing the values in the receiving set, intersected with
   // the closed range [Lower, Upper]. Unlike the Range type, this range uses
@@ -237,53 +289,189 @@ public:
   // or, alternatively, /removing/ all integers between Upper and Lower.
   RangeSet Intersect(BasicValueFactory &BV, Factory &F,
                      llvm::APSInt Lower, llvm::APSInt Upper) const {
-    if (!pin(Lower, Upper))
+    if (!pinToType(APSIntType(getMinValue()), Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
-
-    PrimRangeSet::iterator i = begin(), e = end();
-    if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
-    else {
-      // The order of the next two statements is important!
-      // IntersectInRange() does not reset the iteration state for i and e.
-      // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
-    }
+    SmallVector<Range, 4> NewRanges;
+    IntersectRanges(BV, Lower, Upper, NewRanges, begin(), end());
 
+    PrimRangeSet newRanges = F.getEmptySet();
+    for (unsigned i = 0, n = NewRanges.size(); i != n; ++i)
+      newRanges = F.add(newRanges, NewRanges[i]);
     return newRanges;
   }
 
   void print(raw_ostream &os) const {
-    bool isFirst = true;
-    os << "{ ";
-    for (iterator i = begin(), e = end(); i != e; ++i) {
-      if (isFirst)
-        isFirst = false;
-      else
-        os << ", ";
-
-      os << '[' << i->From().toString(10) << ", " << i->To().toString(10)
-         << ']';
-    }
-    os << " }";
+    printRanges(os, begin(), end());
   }
 
   bool operator==(const RangeSet &other) const {
     return ranges == other.ranges;
   }
 };
+
+/// A sorted array of disjoint ranges, uniqued by CompactRangeSet::Factory.
+/// The ranges are allocated right after the object.
+class RangeArray : public llvm::FoldingSetNode {
+  unsigned NumRanges;
+
+  explicit RangeArray(unsigned N) : NumRanges(N) {}
+  friend class CompactRangeSetFactory;
+
+public:
+  typedef const Range *iterator;
+
+  iterator begin() const { return reinterpret_cast<const Range*>(this + 1); }
+  iterator end() const { return begin() + NumRanges; }
+  unsigned size() const { return NumRanges; }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, ArrayRef<Range>(begin(), end()));
+  }
+
+  static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+    ID.AddInteger(Ranges.size());
+    for (unsigned i = 0, n = Ranges.size(); i != n; ++i)
+      Ranges[i].Profile(ID);
+  }
+};
+
+/// Uniques the arrays of CompactRangeSets, and memoizes their intersections.
+class CompactRangeSetFactory {
+  llvm::BumpPtrAllocator Alloc;
+  llvm::FoldingSet<RangeArray> Arrays;
+
+  typedef std::pair<const llvm::APSInt*, const llvm::APSInt*> Bounds;
+  typedef std::pair<const RangeArray*, Bounds> IntersectionKey;
+  llvm::DenseMap<IntersectionKey, const RangeArray*> Intersections;
+
+public:
+  /// Returns the unique array holding the given ranges, or null if there are
+  /// no ranges.
+  const RangeArray *getArray(ArrayRef<Range> Ranges) {
+    if (Ranges.empty())
+      return 0;
+
+    llvm::FoldingSetNodeID ID;
+    RangeArray::Profile(ID, Ranges);
+    void *InsertPos;
+    if (RangeArray *A = Arrays.FindNodeOrInsertPos(ID, InsertPos))
+      return A;
+
+    void *Mem = Alloc.Allocate(sizeof(RangeArray) +
+                                 Ranges.size() * sizeof(Range),
+                               llvm::alignOf<RangeArray>());
+    RangeArray *A = new (Mem) RangeArray(Ranges.size());
+    std::uninitialized_copy(Ranges.begin(), Ranges.end(),
+                            const_cast<Range*>(A->begin()));
+    Arrays.InsertNode(A, InsertPos);
+    return A;
+  }
+
+  /// Looks up the intersection of \p A with the interned range
+  /// [Lower, Upper], if it was computed before.
+  bool lookupIntersection(const RangeArray *A, const llvm::APSInt &Lower,
+                          const llvm::APSInt &Upper,
+                          const RangeArray *&Result) const {
+    llvm::DenseMap<IntersectionKey, const RangeArray*>::const_iterator I =
+      Intersections.find(IntersectionKey(A, Bounds(&Lower, &Upper)));
+    if (I == Intersections.end())
+      return false;
+    Result = I->second;
+    return true;
+  }
+
+  void addIntersection(const RangeArray *A, const llvm::APSInt &Lower,
+                       const llvm::APSInt &Upper, const RangeArray *Result) {
+    Intersections[IntersectionKey(A, Bounds(&Lower, &Upper))] = Result;
+  }
+};
+
+/// A RangeSet stored as a pointer to a uniqued, sorted array of ranges.
+///
+/// Unlike RangeSet, this does not build a balanced tree for every
+/// intersection: a symbol rarely has more than a few ranges, so a flat array
+/// is smaller and faster to scan.  Since the arrays are uniqued, two sets are
+/// equal exactly if they point to the same array, and an intersection only
+/// has to be computed once for each set and range.
+class CompactRangeSet {
+  const RangeArray *Ranges; // null if the set is empty.
+
+public:
+  typedef CompactRangeSetFactory Factory;
+  typedef RangeArray::iterator iterator;
+
+  CompactRangeSet(const RangeArray *R) : Ranges(R) {}
+
+  /// Construct a new CompactRangeSet representing '{ [from, to] }'.
+  CompactRangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
+    : Ranges(F.getArray(Range(from, to))) {}
+
+  iterator begin() const { return Ranges ? Ranges->begin() : 0; }
+  iterator end() const { return Ranges ? Ranges->end() : 0; }
+
+  bool isEmpty() const { return !Ranges; }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Ranges); }
+
+  const llvm::APSInt* getConcreteValue() const {
+    if (!Ranges || Ranges->size() != 1)
+      return 0;
+    return Ranges->begin()->getConcreteValue();
+  }
+
+  /// \sa RangeSet::Intersect
+  CompactRangeSet Intersect(BasicValueFactory &BV, Factory &F,
+                            llvm::APSInt Lower, llvm::APSInt Upper) const {
+    assert(!isEmpty());
+
+    // The bounds are uniqued too, so that they can key the memo table.
+    const llvm::APSInt &UniqueLower = BV.getValue(Lower);
+    const llvm::APSInt &UniqueUpper = BV.getValue(Upper);
+    const RangeArray *Result;
+    if (F.lookupIntersection(Ranges, UniqueLower, UniqueUpper, Result)) {
+      ++NumMemoizedIntersections;
+      return Result;
+    }
+
+    ++NumCompactIntersections;
+    Result = 0;
+    if (pinToType(APSIntType(begin()->From()), Lower, Upper)) {
+      SmallVector<Range, 4> NewRanges;
+      IntersectRanges(BV, Lower, Upper, NewRanges, begin(), end());
+      Result = F.getArray(NewRanges);
+    }
+    F.addIntersection(Ranges, UniqueLower, UniqueUpper, Result);
+    return Result;
+  }
+
+  void print(raw_ostream &os) const {
+    printRanges(os, begin(), end());
+  }
+
+  bool operator==(const CompactRangeSet &other) const {
+    return Ranges == other.Ranges;
+  }
+};
 } // end anonymous namespace
 
 REGISTER_TRAIT_WITH_PROGRAMSTATE(ConstraintRange,
                                  CLANG_ENTO_PROGRAMSTATE_MAP(SymbolRef,
                                                              RangeSet))
+REGISTER_TRAIT_WITH_PROGRAMSTATE(CompactConstraintRange,
+                                 CLANG_ENTO_PROGRAMSTATE_MAP(SymbolRef,
+                                                             CompactRangeSet))
 
 namespace {
+/// \p Trait is the program state trait which maps symbols to their ranges.
+/// Its value type, RangeSet or CompactRangeSet, selects how the ranges are
+/// represented.
+template <typename Trait>
 class RangeConstraintManager : public SimpleConstraintManager{
-  RangeSet GetRange(ProgramStateRef state, SymbolRef sym);
+  typedef typename ProgramStateTrait<Trait>::data_type ConstraintRangeTy;
+  typedef typename ProgramStateTrait<Trait>::value_type RangeSetTy;
+
+  RangeSetTy GetRange(ProgramStateRef state, SymbolRef sym);
 public:
   RangeConstraintManager(SubEngine *subengine, BasicValueFactory &BVF)
     : SimpleConstraintManager(subengine, BVF) {}
@@ -321,25 +509,32 @@ public:
              const char* nl, const char *sep);
 
 private:
-  RangeSet::Factory F;
+  typename RangeSetTy::Factory F;
 };
 
 } // end anonymous namespace
 
 ConstraintManager *
 ento::CreateRangeConstraintManager(ProgramStateManager &StMgr, SubEngine *Eng) {
-  return new RangeConstraintManager(Eng, StMgr.getBasicVals());
+  if (Eng && Eng->getAnalysisManager().options.shouldUseCompactRangeSets())
+    return new RangeConstraintManager<CompactConstraintRange>(
+                                               Eng, StMgr.getBasicVals());
+  return new RangeConstraintManager<ConstraintRange>(Eng, StMgr.getBasicVals());
 }
 
-const llvm::APSInt* RangeConstraintManager::getSymVal(ProgramStateRef St,
-                                                      SymbolRef sym) const {
-  const ConstraintRangeTy::data_type *T = St->get<ConstraintRange>(sym);
+template <typename Trait>
+const llvm::APSInt *
+RangeConstraintManager<Trait>::getSymVal(ProgramStateRef St,
+                                         SymbolRef sym) const {
+  const RangeSetTy *T = St->get<Trait>(sym);
   return T ? T->getConcreteValue() : NULL;
 }
 
-ConditionTruthVal RangeConstraintManager::checkNull(ProgramStateRef State,
-                                                    SymbolRef Sym) {
-  const RangeSet *Ranges = State->get<ConstraintRange>(Sym);
+template <typename Trait>
+ConditionTruthVal
+RangeConstraintManager<Trait>::checkNull(ProgramStateRef State,
+                                         SymbolRef Sym) {
+  const RangeSetTy *Ranges = State->get<Trait>(Sym);
 
   // If we don't have any information about this symbol, it's underconstrained.
   if (!Ranges)
@@ -363,25 +558,28 @@ ConditionTruthVal RangeConstraintManager::checkNull(ProgramStateRef State,
 
 /// Scan all symbols referenced by the constraints. If the symbol is not alive
 /// as marked in LSymbols, mark it as dead in DSymbols.
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::removeDeadBindings(ProgramStateRef state,
-                                           SymbolReaper& SymReaper) {
+RangeConstraintManager<Trait>::removeDeadBindings(ProgramStateRef state,
+                                                  SymbolReaper& SymReaper) {
 
-  ConstraintRangeTy CR = state->get<ConstraintRange>();
-  ConstraintRangeTy::Factory& CRFactory = state->get_context<ConstraintRange>();
+  ConstraintRangeTy CR = state->get<Trait>();
+  typename ConstraintRangeTy::Factory &CRFactory = state->get_context<Trait>();
 
-  for (ConstraintRangeTy::iterator I = CR.begin(), E = CR.end(); I != E; ++I) {
+  for (typename ConstraintRangeTy::iterator I = CR.begin(), E = CR.end();
+       I != E; ++I) {
     SymbolRef sym = I.getKey();
     if (SymReaper.maybeDead(sym))
       CR = CRFactory.remove(CR, sym);
   }
 
-  return state->set<ConstraintRange>(CR);
+  return state->set<Trait>(CR);
 }
 
-RangeSet
-RangeConstraintManager::GetRange(ProgramStateRef state, SymbolRef sym) {
-  if (ConstraintRangeTy::data_type* V = state->get<ConstraintRange>(sym))
+template <typename Trait>
+typename RangeConstraintManager<Trait>::RangeSetTy
+RangeConstraintManager<Trait>::GetRange(ProgramStateRef state, SymbolRef sym) {
+  if (const RangeSetTy *V = state->get<Trait>(sym))
     return *V;
 
   // Lazily generate a new RangeSet representing all possible values for the
@@ -389,7 +587,7 @@ RangeConstraintManager::GetRange(ProgramStateRef state, SymbolRef sym) {
   BasicValueFactory &BV = getBasicVals();
   QualType T = sym->getType();
 
-  RangeSet Result(F, BV.getMinValue(T), BV.getMaxValue(T));
+  RangeSetTy Result(F, BV.getMinValue(T), BV.getMaxValue(T));
 
   // Special case: references are known to be non-zero.
   if (T->isReferenceType()) {
@@ -413,10 +611,11 @@ RangeConstraintManager::GetRange(ProgramStateRef state, SymbolRef sym) {
 // As an example, the range [UINT_MAX-1, 3) contains five values: UINT_MAX-1,
 // UINT_MAX, 0, 1, and 2.
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymNE(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymNE(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   if (AdjustmentType.testInRange(Int) != APSIntType::RTR_Within)
@@ -429,14 +628,15 @@ RangeConstraintManager::assumeSymNE(ProgramStateRef St, SymbolRef Sym,
 
   // [Int-Adjustment+1, Int-Adjustment-1]
   // Notice that the lower bound is greater than the upper bound.
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Upper, Lower);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, Upper, Lower);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymEQ(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymEQ(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   if (AdjustmentType.testInRange(Int) != APSIntType::RTR_Within)
@@ -444,14 +644,16 @@ RangeConstraintManager::assumeSymEQ(ProgramStateRef St, SymbolRef Sym,
 
   // [Int-Adjustment, Int-Adjustment]
   llvm::APSInt AdjInt = AdjustmentType.convert(Int) - Adjustment;
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, AdjInt, AdjInt);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, AdjInt,
+                                                AdjInt);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymLT(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymLT(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   switch (AdjustmentType.testInRange(Int)) {
@@ -473,14 +675,15 @@ RangeConstraintManager::assumeSymLT(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Upper = ComparisonVal-Adjustment;
   --Upper;
 
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymGT(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymGT(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   switch (AdjustmentType.testInRange(Int)) {
@@ -502,14 +705,15 @@ RangeConstraintManager::assumeSymGT(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Upper = Max-Adjustment;
   ++Lower;
 
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymGE(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymGE(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   switch (AdjustmentType.testInRange(Int)) {
@@ -531,14 +735,15 @@ RangeConstraintManager::assumeSymGE(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Lower = ComparisonVal-Adjustment;
   llvm::APSInt Upper = Max-Adjustment;
 
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
+template <typename Trait>
 ProgramStateRef 
-RangeConstraintManager::assumeSymLE(ProgramStateRef St, SymbolRef Sym,
-                                    const llvm::APSInt &Int,
-                                    const llvm::APSInt &Adjustment) {
+RangeConstraintManager<Trait>::assumeSymLE(ProgramStateRef St, SymbolRef Sym,
+                                           const llvm::APSInt &Int,
+                                           const llvm::APSInt &Adjustment) {
   // Before we do any real work, see if the value can even show up.
   APSIntType AdjustmentType(Adjustment);
   switch (AdjustmentType.testInRange(Int)) {
@@ -560,18 +765,19 @@ RangeConstraintManager::assumeSymLE(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Lower = Min-Adjustment;
   llvm::APSInt Upper = ComparisonVal-Adjustment;
 
-  RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  RangeSetTy New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
+  return New.isEmpty() ? NULL : St->set<Trait>(Sym, New);
 }
 
 //===------------------------------------------------------------------------===
 // Pretty-printing.
 //===------------------------------------------------------------------------===/
 
-void RangeConstraintManager::print(ProgramStateRef St, raw_ostream &Out,
-                                   const char* nl, const char *sep) {
+template <typename Trait>
+void RangeConstraintManager<Trait>::print(ProgramStateRef St, raw_ostream &Out,
+                                          const char* nl, const char *sep) {
 
-  ConstraintRangeTy Ranges = St->get<ConstraintRange>();
+  ConstraintRangeTy Ranges = St->get<Trait>();
 
   if (Ranges.isEmpty()) {
     Out << nl << sep << "Ranges are empty." << nl;
@@ -579,7 +785,8 @@ void RangeConstraintManager::print(ProgramStateRef St, raw_ostream &Out,
   }
 
   Out << nl << sep << "Ranges of symbol values:";
-  for (ConstraintRangeTy::iterator I=Ranges.begin(), E=Ranges.end(); I!=E; ++I){
+  for (typename ConstraintRangeTy::iterator I = Ranges.begin(),
+       E = Ranges.end(); I != E; ++I) {
     Out << nl << ' ' << I.getKey() << " : ";
     I.getData().print(Out);
   }
@@ -34,17 +34,21 @@
 
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 
+#include <algorithm>
+#include <cmath>
 #include <queue>
 
 using namespace clang;
@@ -59,6 +63,9 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                      "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsSkippedByBudget,
+                     "The # of functions not analyzed because the analysis "
+                     "budget of the translation unit was exhausted.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -112,6 +119,81 @@ public:
 };
 } // end anonymous namespace
 
+//===----------------------------------------------------------------------===//
+// Analysis budget of a translation unit.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief Tracks how much of the wall-clock time and of the work list steps
+/// allowed for the path-sensitive analysis of a translation unit is used.
+class AnalysisBudget {
+  unsigned MaxTime;
+  unsigned MaxSteps;
+  double StartTime;
+  unsigned StepsTaken;
+
+public:
+  AnalysisBudget() : MaxTime(0), MaxSteps(0), StartTime(0), StepsTaken(0) {}
+
+  /// \brief Start spending a budget of \p Time seconds and \p Steps work
+  /// list steps. Zero means no limit.
+  void start(unsigned Time, unsigned Steps) {
+    MaxTime = Time;
+    MaxSteps = Steps;
+    StartTime = llvm::TimeRecord::getCurrentTime(true).getWallTime();
+    StepsTaken = 0;
+  }
+
+  bool isLimited() const { return MaxTime != 0 || MaxSteps != 0; }
+
+  void addSteps(unsigned Steps) { StepsTaken += Steps; }
+
+  /// \brief Returns the fraction of the budget which is left, between 0 and
+  /// 1, by whichever of the limits is closer to being reached.
+  double getRemaining() const {
+    double Remaining = 1.0;
+    if (MaxTime) {
+      double Elapsed =
+        llvm::TimeRecord::getCurrentTime(false).getWallTime() - StartTime;
+      Remaining = std::min(Remaining, 1.0 - Elapsed / MaxTime);
+    }
+    if (MaxSteps)
+      Remaining = std::min(Remaining, 1.0 - double(StepsTaken) / MaxSteps);
+    return std::max(Remaining, 0.0);
+  }
+
+  bool isExhausted() const { return isLimited() && getRemaining() == 0.0; }
+
+  /// \brief Returns the number of work list steps left, or 0 if the steps
+  /// are not limited.
+  unsigned getRemainingSteps() const {
+    if (!MaxSteps)
+      return 0;
+    return MaxSteps - std::min(StepsTaken, MaxSteps);
+  }
+};
+
+/// \brief Orders the root functions, which no other function in the
+/// translation unit calls, so that the ones which call the most other
+/// functions come first, as analyzing them covers the most code through
+/// inlining, and among those the smallest ones, which are the cheapest to
+/// analyze.
+struct FunctionPriority {
+  CallGraphNode *Node;
+  unsigned Degree;
+  unsigned Size;
+
+  FunctionPriority(CallGraphNode *N, unsigned Degree, unsigned Size)
+    : Node(N), Degree(Degree), Size(Size) {}
+
+  bool operator<(const FunctionPriority &RHS) const {
+    if (Degree != RHS.Degree)
+      return Degree > RHS.Degree;
+    return Size < RHS.Size;
+  }
+};
+} // end anonymous namespace
+
 //===----------------------------------------------------------------------===//
 // AnalysisConsumer declaration.
 //===----------------------------------------------------------------------===//
@@ -162,12 +244,24 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The time and steps which the path-sensitive analysis may still take.
+  AnalysisBudget Budget;
+
+  /// The inlining depth requested by the user, before it is reduced to save
+  /// budget.
+  unsigned InitialInlineMaxStackDepth;
+
+  /// The functions which were not analyzed path-sensitively because the
+  /// budget was exhausted.
+  SmallVector<const Decl *, 8> SkippedFunctions;
+
   AnalysisConsumer(const Preprocessor& pp,
                    const std::string& outdir,
                    AnalyzerOptionsRef opts,
                    ArrayRef<std::string> plugins)
     : RecVisitorMode(0), RecVisitorBR(0),
-      Ctx(0), PP(pp), OutDir(outdir), Opts(opts), Plugins(plugins) {
+      Ctx(0), PP(pp), OutDir(outdir), Opts(opts), Plugins(plugins),
+      InitialInlineMaxStackDepth(0) {
     DigestAnalyzerOptions();
     if (Opts->PrintStats) {
       llvm::EnableStatistics();
@@ -272,6 +366,14 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// \brief Sort the root functions among the top level functions by
+  /// FunctionPriority, leaving the functions they call where they are.
+  void prioritizeFunctions(CallGraph &CG,
+                           SmallVectorImpl<CallGraphNode*> &Functions);
+
+  /// \brief Report the functions which were skipped to stay in the budget.
+  void reportSkippedFunctions();
+
   /// \brief Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -400,11 +502,15 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   // translation unit. This step is very important for performance. It ensures 
   // that we analyze the root functions before the externally available 
   // subroutines.
-  std::deque<CallGraphNode*> BFSQueue;
-  for (llvm::SmallVector<CallGraphNode*, 24>::reverse_iterator
-         TI = TopLevelFunctions.rbegin(), TE = TopLevelFunctions.rend();
-         TI != TE; ++TI)
-    BFSQueue.push_back(*TI);
+  std::reverse(TopLevelFunctions.begin(), TopLevelFunctions.end());
+
+  // If the analysis may not get to all of the functions, start with the ones
+  // which are the most worth analyzing.
+  if (Budget.isLimited())
+    prioritizeFunctions(CG, TopLevelFunctions);
+
+  std::deque<CallGraphNode*> BFSQueue(TopLevelFunctions.begin(),
+                                      TopLevelFunctions.end());
 
   // BFS over all of the functions, while skipping the ones inlined into
   // the previously processed functions. Use external Visited set, which is
@@ -444,6 +550,63 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   }
 }
 
+void AnalysisConsumer::prioritizeFunctions(CallGraph &CG,
+                                   SmallVectorImpl<CallGraphNode*> &Functions) {
+  // Count the callers of each function.
+  llvm::DenseMap<CallGraphNode*, unsigned> NumCallers;
+  for (CallGraph::iterator I = CG.begin(), E = CG.end(); I != E; ++I) {
+    CallGraphNode *Caller = I->second;
+    if (!Caller->getDecl())
+      continue;
+    for (CallGraphNode::iterator CI = Caller->begin(), CE = Caller->end();
+         CI != CE; ++CI)
+      ++NumCallers[*CI];
+  }
+
+  // Only reorder the roots. The functions they call must stay after their
+  // callers, so that they are analyzed by inlining rather than as roots of
+  // their own.
+  SourceManager &SM = Ctx->getSourceManager();
+  SmallVector<unsigned, 16> RootIndices;
+  std::vector<FunctionPriority> Priorities;
+  for (unsigned i = 0, n = Functions.size(); i != n; ++i) {
+    CallGraphNode *N = Functions[i];
+    if (NumCallers.lookup(N))
+      continue;
+
+    // Estimate the size of the function by the length of its body.
+    unsigned Size = 0;
+    if (const Stmt *Body = N->getDecl()->getBody()) {
+      std::pair<FileID, unsigned> Begin =
+        SM.getDecomposedExpansionLoc(Body->getLocStart());
+      std::pair<FileID, unsigned> End =
+        SM.getDecomposedExpansionLoc(Body->getLocEnd());
+      if (Begin.first == End.first && Begin.second <= End.second)
+        Size = End.second - Begin.second;
+    }
+    RootIndices.push_back(i);
+    Priorities.push_back(FunctionPriority(N, N->size(), Size));
+  }
+
+  std::stable_sort(Priorities.begin(), Priorities.end());
+  for (unsigned i = 0, n = Priorities.size(); i != n; ++i)
+    Functions[RootIndices[i]] = Priorities[i].Node;
+}
+
+void AnalysisConsumer::reportSkippedFunctions() {
+  if (SkippedFunctions.empty())
+    return;
+
+  DiagnosticsEngine &Diags = PP.getDiagnostics();
+  Diags.Report(diag::warn_analyzer_budget_exhausted)
+    << unsigned(SkippedFunctions.size());
+  for (unsigned i = 0, n = SkippedFunctions.size(); i != n; ++i)
+    if (const NamedDecl *ND = dyn_cast<NamedDecl>(SkippedFunctions[i]))
+      Diags.Report(ND->getLocation(), diag::note_analyzer_function_skipped)
+        << ND;
+  SkippedFunctions.clear();
+}
+
 void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // Don't run the actions if an error has occurred with parsing the file.
   DiagnosticsEngine &Diags = PP.getDiagnostics();
@@ -453,6 +616,10 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
+    Budget.start(Mgr->options.getMaxTranslationUnitTime(),
+                 Mgr->options.getMaxTranslationUnitSteps());
+    InitialInlineMaxStackDepth = Mgr->options.InlineMaxStackDepth;
+
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
@@ -484,6 +651,8 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
     RecVisitorBR = 0;
+    Mgr->options.InlineMaxStackDepth = InitialInlineMaxStackDepth;
+    reportSkippedFunctions();
   }
 
   // Explicitly destroy the PathDiagnosticConsumer.  This will flush its output.
@@ -550,6 +719,15 @@ AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
 void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
                                   SetOfConstDecls *VisitedCallees) {
   Mode = getModeForDecl(D, Mode);
+
+  // Once the budget is used up, only run the syntactic checks.
+  if ((Mode & AM_Path) && Budget.isExhausted() &&
+      checkerMgr->hasPathSensitiveCheckers()) {
+    Mode &= ~AM_Path;
+    SkippedFunctions.push_back(D);
+    NumFunctionsSkippedByBudget++;
+  }
+
   if (Mode == AM_None)
     return;
 
@@ -599,6 +777,18 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   if (!Mgr->getAnalysisDeclContext(D)->getAnalysis<RelaxedLiveVariables>())
     return;
 
+  // As the budget runs out, inline less deeply, and never take more steps
+  // than are left.
+  unsigned MaxSteps = Mgr->options.MaxNodes;
+  if (Budget.isLimited()) {
+    double Depth =
+      std::ceil(InitialInlineMaxStackDepth * Budget.getRemaining());
+    Mgr->options.InlineMaxStackDepth = std::max(1U, unsigned(Depth));
+    if (unsigned RemainingSteps = Budget.getRemainingSteps())
+      MaxSteps = MaxSteps ? std::min(MaxSteps, RemainingSteps)
+                          : RemainingSteps;
+  }
+
   ExprEngine Eng(*Mgr, ObjCGCEnabled, VisitedCallees, &FunctionSummaries);
 
   // Set the graph auditor.
@@ -610,7 +800,8 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
 
   // Execute the worklist algorithm.
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
-                      Mgr->options.MaxNodes);
+                      MaxSteps);
+  Budget.addSteps(Eng.getCoreEngine().getNumSteps());
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
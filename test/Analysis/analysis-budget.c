@@ -0,0 +1,22 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config max-tu-steps=1 %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config max-tu-steps=100000 -verify %s
+
+int *getNull(void) { return 0; }
+
+int deref(void) {
+  int *p = getNull();
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
+
+// Functions which do not call others are analyzed last. Callees are not
+// analyzed before their callers, so 'deref' is analyzed first even though
+// 'getNull' is as well connected and smaller.
+void leaf1(void) {}
+void leaf2(void) {}
+
+// CHECK: warning: analysis budget of the translation unit was exhausted; {{[0-9]+}} functions were not analyzed path-sensitively
+// CHECK-NOT: 'deref' was not analyzed
+// CHECK: note: 'leaf{{[12]}}' was not analyzed
+// CHECK-NOT: 'deref' was not analyzed
+// CHECK: note: 'leaf{{[12]}}' was not analyzed
+// CHECK-NOT: 'deref' was not analyzed
@@ -6,8 +6,12 @@ void foo() { bar(); }
 
 // CHECK: [config]
 // CHECK-NEXT: cfg-temporary-dtors = false
+// CHECK-NEXT: compact-range-sets = false
 // CHECK-NEXT: faux-bodies = true
 // CHECK-NEXT: graph-trim-interval = 1000
+// CHECK-NEXT: incremental-dead-symbols = false
 // CHECK-NEXT: ipa-always-inline-size = 3
+// CHECK-NEXT: max-tu-steps = 0
+// CHECK-NEXT: max-tu-time = 0
 // CHECK-NEXT: [stats]
-// CHECK-NEXT: num-entries = 4
+// CHECK-NEXT: num-entries = 8
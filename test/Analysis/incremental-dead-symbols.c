@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config incremental-dead-symbols=true -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config incremental-dead-symbols=true -analyzer-stats %s 2>&1 | FileCheck %s
+
+void clang_analyzer_eval(int);
+
+int unused(int x) {
+  // Nothing dies between these declarations, so the state cleaned up before
+  // the first one is cleaned up again, unchanged, before the second one.
+  int a;
+  int b;
+  if (x > 10)
+    return 1;
+  clang_analyzer_eval(x <= 10); // expected-warning{{TRUE}}
+  return 0;
+}
+
+int dies(int *p, int n) {
+  int v = *p;
+  if (n == 0)
+    return v;
+  // The symbol for 'n' is still constrained after 'v' is dead.
+  clang_analyzer_eval(n != 0); // expected-warning{{TRUE}}
+  return 0;
+}
+
+// CHECK: ... Statistics Collected ...
+// CHECK: The # of times RemoveDeadBindings is called
+// CHECK: {{[1-9][0-9]*}} ExprEngine - The # of times RemoveDeadBindings reused an earlier cleanup
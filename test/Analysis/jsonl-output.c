@@ -0,0 +1,34 @@
+// RUN: rm -f %t.jsonl
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=jsonl -o %t.jsonl %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=jsonl -o %t.jsonl %s
+// RUN: FileCheck --input-file=%t.jsonl %s
+
+void first(int *p) {
+  if (p)
+    return;
+  *p = 1;
+}
+
+void second(int *q) {
+  if (q)
+    return;
+  *q = 2;
+}
+
+// Strings are written once per run, before the first report using them.
+// CHECK: {"kind":"begin","version":"{{.*}}"}
+// CHECK-NEXT: {"kind":"string","id":0,"value":"Dereference of null pointer (loaded from variable 'p')"}
+// CHECK-NEXT: {"kind":"string","id":1,"value":"Logic error"}
+// CHECK-NEXT: {"kind":"string","id":2,"value":"Dereference of null pointer"}
+// CHECK-NEXT: {"kind":"string","id":3,"value":"first"}
+// CHECK-NEXT: {"kind":"string","id":4,"value":"{{.*}}jsonl-output.c"}
+// CHECK-NEXT: {"kind":"string","id":5,"value":"Assuming 'p' is null"}
+// CHECK-NEXT: {"kind":"diagnostic","description":0,"category":1,"type":2,"context":3,"issue_hash":3,"location":[4,9,3],"path":{{\[\[}}0,4,7,7,5],[0,4,9,3,0]]}
+// CHECK-NEXT: {"kind":"string","id":6,"value":"Dereference of null pointer (loaded from variable 'q')"}
+// CHECK-NEXT: {"kind":"string","id":7,"value":"second"}
+// CHECK-NEXT: {"kind":"string","id":8,"value":"Assuming 'q' is null"}
+// CHECK-NEXT: {"kind":"diagnostic","description":6,"category":1,"type":2,"context":7,"issue_hash":3,"location":[4,15,3],"path":{{\[\[}}0,4,13,7,8],[0,4,15,3,6]]}
+
+// The second run is appended, and numbers its strings from zero again.
+// CHECK-NEXT: {"kind":"begin","version":"{{.*}}"}
+// CHECK-NEXT: {"kind":"string","id":0,"value":"Dereference of null pointer (loaded from variable 'p')"}
@@ -1,4 +1,5 @@
 // RUN: %clang_cc1 -analyze -analyzer-checker=core,alpha.core -analyzer-store=region -analyzer-constraints=range -verify -fblocks %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,alpha.core -analyzer-store=region -analyzer-constraints=range -analyzer-config compact-range-sets=true -verify -fblocks %s
 
 // <rdar://problem/6776949>
 // main's 'argc' argument is always > 0
@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config shared-report-graph=true -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=plist -o %t.default.plist %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config shared-report-graph=true -analyzer-output=plist -o %t.shared.plist %s
+// RUN: diff %t.default.plist %t.shared.plist
+
+// Several reports in one function, each reached by a unique shortest path,
+// get the same paths whether or not the report graph is shared.
+
+int several(int *p, int *q, int x) {
+  if (x == 1) {
+    if (p)
+      return 0;
+    return *p; // expected-warning{{Dereference of null pointer}}
+  }
+  if (x == 2) {
+    if (q)
+      return 0;
+    return *q; // expected-warning{{Dereference of null pointer}}
+  }
+  if (x == 3)
+    return 10 / (x - 3); // expected-warning{{Division by zero}}
+  return x;
+}
+
+int single(int *p) {
+  if (p)
+    return 0;
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
@@ -0,0 +1,28 @@
+struct Widget {
+  int getFooBar();
+  int getFoo();
+  int GetFrame();
+  int setFoo(int);
+  int width;
+};
+
+void test(Widget w) {
+  w.getFoo();
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-at=%s:10:5 -code-completion-filter getF %s -o - | FileCheck -check-prefix=CHECK-PREFIX %s
+  // CHECK-PREFIX-NOT: setFoo
+  // CHECK-PREFIX-NOT: width
+  // CHECK-PREFIX: COMPLETION: getFoo : [#int#]getFoo()
+  // CHECK-PREFIX: COMPLETION: getFooBar : [#int#]getFooBar()
+  // CHECK-PREFIX: COMPLETION: GetFrame : [#int#]GetFrame()
+  // CHECK-PREFIX-NOT: setFoo
+  // CHECK-PREFIX-NOT: width
+
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-at=%s:10:5 -code-completion-filter gfb %s -o - | FileCheck -check-prefix=CHECK-FUZZY %s
+  // CHECK-FUZZY-NOT: COMPLETION: getFoo :
+  // CHECK-FUZZY: COMPLETION: getFooBar : [#int#]getFooBar()
+  // CHECK-FUZZY-NOT: COMPLETION:
+
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-at=%s:10:5 -code-completion-filter getfoo -code-completion-max-results 1 %s -o - | FileCheck -check-prefix=CHECK-MAX %s
+  // CHECK-MAX: COMPLETION: getFoo : [#int#]getFoo()
+  // CHECK-MAX-NOT: COMPLETION:
+}
@@ -0,0 +1,61 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O2 -backend-threads 4 -emit-llvm -o %t1.ll %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O2 -backend-threads 4 -emit-llvm -o %t2.ll %s
+// RUN: diff %t1.ll %t2.ll
+// RUN: FileCheck -check-prefix=STR %s < %t1.ll
+// RUN: FileCheck -check-prefix=NAMES %s < %t1.ll
+// RUN: FileCheck -check-prefix=HELPER %s < %t1.ll
+// RUN: FileCheck %s < %t1.ll
+// RUN: FileCheck -check-prefix=DCE %s < %t1.ll
+// RUN: FileCheck -check-prefix=FOLD %s < %t1.ll
+// RUN: %clang -target x86_64-unknown-unknown -### -c -O2 -fbackend-threads=4 %s 2>&1 | FileCheck -check-prefix=DRIVER %s
+
+// The symbols which were local to the module are local again after the
+// partitions are linked back together.
+// STR: @.str{{[0-9]*}} = private unnamed_addr constant [2 x i8] c"a\00"
+// NAMES: @names = internal {{.*}}[2 x i8*]
+static const char *names[] = { "a", "b" };
+
+// HELPER: define internal i32 @helper(
+__attribute__((noinline)) static int helper(int x) {
+  return x * 3 + names[x & 1][0];
+}
+
+// The partitions that do not own this static function get a copy of it, so
+// it is inlined into every caller, and then removed.
+// DCE-NOT: @twice
+static int twice(int x) { return x * 2; }
+
+// CHECK: define i32 @f0(
+int f0(int x) { return helper(x) + twice(x); }
+// CHECK: define i32 @f1(
+int f1(int x) { return helper(x + 1) + twice(x); }
+// CHECK: define i32 @f2(
+int f2(int x) { return helper(x + 2) + twice(x); }
+// CHECK: define i32 @f3(
+int f3(int x) { return helper(x + 3) + twice(x); }
+// CHECK: define i32 @f4(
+int f4(int x) { return helper(x + 4) + twice(x); }
+// CHECK: define i32 @f5(
+int f5(int x) { return helper(x + 5) + twice(x); }
+// CHECK: define i32 @f6(
+int f6(int x) { return helper(x + 6) + twice(x); }
+// CHECK: define i32 @f7(
+int f7(int x) { return f0(x) + f6(x); }
+
+// Every partition keeps the initializers of the constants, so loads from
+// them are folded whichever partition owns the function.
+static const int table[] = { 10, 20, 30, 40 };
+// FOLD: define i32 @t0(
+// FOLD: ret i32 10
+int t0(void) { return table[0]; }
+// FOLD: define i32 @t1(
+// FOLD: ret i32 20
+int t1(void) { return table[1]; }
+// FOLD: define i32 @t2(
+// FOLD: ret i32 30
+int t2(void) { return table[2]; }
+// FOLD: define i32 @t3(
+// FOLD: ret i32 40
+int t3(void) { return table[3]; }
+
+// DRIVER: "-backend-threads" "4"
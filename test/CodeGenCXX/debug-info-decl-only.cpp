@@ -0,0 +1,32 @@
+// RUN: %clang_cc1 -emit-llvm -g -triple x86_64-apple-darwin %s -o - | FileCheck %s
+// RUN: %clang_cc1 -emit-llvm -g -triple x86_64-apple-darwin -fno-limit-debug-info %s -o - | FileCheck -check-prefix=FULL %s
+
+// The translation unit that defines the key function of a dynamic class, or
+// that explicitly instantiates a class template specialization, describes
+// the class. Others only declare it.
+
+struct Elsewhere {
+  virtual void key();
+  int member;
+};
+Elsewhere elsewhere;
+
+template<typename T> struct Instantiated { T member; };
+extern template struct Instantiated<int>;
+Instantiated<int> instantiated;
+
+// The key function is defined after the first use of the class.
+struct Here {
+  virtual void key();
+  int member;
+};
+Here here;
+void Here::key() { }
+
+// CHECK-NOT: metadata !"Elsewhere", {{.*}}, i64 128, i64 64, i32 0, i32 0
+// CHECK-NOT: metadata !"Instantiated<int>", {{.*}}, i64 32, i64 32, i32 0, i32 0
+// CHECK: metadata !"Here", {{.*}}, i64 128, i64 64, i32 0, i32 0
+// CHECK-NOT: metadata !"Elsewhere", {{.*}}, i64 128, i64 64, i32 0, i32 0
+// CHECK-NOT: metadata !"Instantiated<int>", {{.*}}, i64 32, i64 32, i32 0, i32 0
+
+// FULL: metadata !"Elsewhere", {{.*}}, i64 128, i64 64, i32 0, i32 0
@@ -0,0 +1,61 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include %S/free-ast-after-codegen.h -emit-llvm -free-ast-after-codegen -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include %S/free-ast-after-codegen.h -emit-llvm -free-ast-after-codegen -print-stats -o %t %s 2>&1 | FileCheck -check-prefix=STATS %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include %S/free-ast-after-codegen.h -emit-llvm -free-ast-after-codegen -o - %s | FileCheck -check-prefix=STATIC %s
+
+// Statements deserialized from a PCH while a body is being built are shared.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -x c++-header -emit-pch -o %t.pch %S/free-ast-after-codegen.h
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include-pch %t.pch -emit-llvm -free-ast-after-codegen -o - %s | FileCheck %s
+
+struct A {
+  A(int);
+  A();
+  virtual void key();
+  int value;
+};
+
+// The initializers are released along with the body.
+A::A(int x) : value(x * 2) { }
+A::A() : A(1) { }
+void A::key() { value = 0; }
+// CHECK: @_ZTV1A = unnamed_addr constant
+
+template<typename T> T twice(T x) { return x + x; }
+
+// Instantiations are shared, and survive the release of their first user.
+int first(int x) { return twice(x); }
+int second(int x) { return twice(x) + 1; }
+
+// Implicit definitions too.
+struct B { A a; };
+B make_b() { return B(); }
+B copy_b(const B &b) { return b; }
+
+// Static functions are generated at the end of the translation unit, so
+// their bodies are kept.
+static int helper(int x) { return x - 1; }
+int use_helper(int x) { return helper(x); }
+// STATIC: define internal i32 @_ZL6helperi
+// STATIC: sub nsw i32 %{{.*}}, 1
+
+// The initializers of the constants come from the header, and are still
+// there for the second function once the first one is released.
+int use_pch_first() { return pch_constant * pch_pair.second; }
+int use_pch_second() { return pch_constant + pch_pair.first; }
+
+// CHECK: define void @_ZN1AC2Ei
+// CHECK: mul nsw i32 %{{.*}}, 2
+// CHECK: define void @_ZN1AC2Ev
+// CHECK: call void @_ZN1AC1Ei
+// CHECK: define i32 @_Z5firsti
+// CHECK: define i32 @_Z6secondi
+// CHECK: call i32 @_Z5twiceIiET_S0_
+// CHECK: define void @_Z6copy_bRK1B
+// CHECK: define i32 @_Z13use_pch_firstv
+// CHECK: ret i32 42
+// CHECK: define i32 @_Z14use_pch_secondv
+// CHECK: ret i32 22
+// CHECK: define linkonce_odr i32 @_Z5twiceIiET_S0_
+// CHECK: add nsw i32
+
+// STATS: function bodies released
+// STATS: Peak memory usage: {{[0-9]+}} bytes
@@ -0,0 +1,6 @@
+// Header for free-ast-after-codegen.cpp.
+
+const int pch_constant = 20 + 1;
+
+struct PCHPair { int first, second; };
+constexpr PCHPair pch_pair = { 1, 2 };
@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -emit-llvm -o - %s | FileCheck %s
+
+// Names that start with the same prefix must get the same substitutions,
+// whether or not the prefix was mangled before.
+namespace ns {
+  template<typename T> struct Outer {
+    struct Inner {
+      void f(Inner *, Outer *);
+      void g(Outer *, Inner *);
+      static int x;
+    };
+  };
+
+  void h(Outer<int>::Inner *);
+}
+
+void use(ns::Outer<int>::Inner *);
+
+// CHECK: @_ZN2ns5OuterIiE5Inner1xE =
+template<> int ns::Outer<int>::Inner::x = 0;
+
+// CHECK: define void @_ZN2ns5OuterIiE5Inner1fEPS2_PS1_(
+template<> void ns::Outer<int>::Inner::f(Inner *, Outer *) { }
+// CHECK: define void @_ZN2ns5OuterIiE5Inner1gEPS1_PS2_(
+template<> void ns::Outer<int>::Inner::g(Outer *, Inner *) { }
+
+// The prefix comes after other substitutions here.
+// CHECK: define void @_ZN2ns1hEPNS_5OuterIiE5InnerE(
+void ns::h(Outer<int>::Inner *) { }
+
+// CHECK: define void @_Z3usePN2ns5OuterIiE5InnerE(
+void use(ns::Outer<int>::Inner *) { }
+
+// CHECK: define void @_ZN2ns5OuterIcE5Inner1fEPS2_PS1_(
+template<> void ns::Outer<char>::Inner::f(Inner *, Outer *) { }
@@ -0,0 +1,40 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-llvm -stream-functions -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-llvm -O1 -stream-functions -o - %s | FileCheck -check-prefix=OPT %s
+
+// The vtable is emitted here because the key function is defined here, even
+// though its body has been released by then.
+struct A {
+  virtual void key();
+};
+void A::key() { }
+// CHECK: @_ZTV1A = unnamed_addr constant
+
+// Constexpr functions can still be evaluated after they are generated.
+constexpr int square(int x) { return x * x; }
+int squares[square(3)];
+// CHECK: @squares = global [9 x i32]
+
+// Static functions are only generated once they are used.
+static int helper(int x) { return x + 1; }
+int caller(int x) { return helper(x); }
+
+// Lambdas are generated after the function containing them.
+int lambda_user() {
+  auto twice = [](int x) { return x * 2; };
+  return twice(21);
+}
+
+namespace N {
+  int local(int x) { int y = x; return y; }
+}
+
+// CHECK: define i32 @_Z6calleri
+// CHECK: define internal i32 @_ZL6helperi
+// CHECK: define i32 @_Z11lambda_userv
+// CHECK: define internal i32 @{{.*}}lambda_user
+// CHECK: define i32 @_ZN1N5localEi
+// CHECK: ret i32
+
+// OPT: define i32 @_ZN1N5localEi(i32 %x)
+// OPT-NOT: alloca
+// OPT: ret i32 %x
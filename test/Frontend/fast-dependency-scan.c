@@ -0,0 +1,54 @@
+// REQUIRES: shell
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir
+// RUN: echo '#ifndef A_H' > %t.dir/a.h
+// RUN: echo '#define A_H' >> %t.dir/a.h
+// RUN: echo 'int a(void); /* #include "c.h" */' >> %t.dir/a.h
+// RUN: echo '#endif' >> %t.dir/a.h
+// RUN: echo 'const char *b = "#include \"c.h\"";' > %t.dir/b.h
+// RUN: echo '#include "e.h"' >> %t.dir/b.h
+// RUN: echo > %t.dir/c.h
+// RUN: echo > %t.dir/d.h
+// RUN: echo 'int e;' > %t.dir/e.h
+// RUN: %clang_cc1 -Eonly -I %t.dir %s -dependency-file %t.dir/slow.d -MT out.o
+// RUN: %clang_cc1 -Eonly -fast-dependency-scan -I %t.dir %s -dependency-file %t.dir/fast.d -MT out.o
+// RUN: diff %t.dir/slow.d %t.dir/fast.d
+// RUN: FileCheck %s < %t.dir/fast.d
+// RUN: %clang -### -M %s 2>&1 | FileCheck -check-prefix=DRIVER %s
+
+// CHECK: out.o:
+// CHECK-NOT: {{[/\\]}}c.h
+// CHECK: a.h
+// CHECK-NOT: {{[/\\]}}c.h
+// CHECK: b.h
+// CHECK-NOT: {{[/\\]}}c.h
+// CHECK: e.h
+// CHECK-NOT: {{[/\\]}}c.h
+// CHECK: d.h
+// CHECK-NOT: {{[/\\]}}c.h
+
+// DRIVER: "-Eonly" "-fast-dependency-scan"
+
+#include "a.h"
+#include "a.h"
+
+int f(void) { return '"'; } /* "
+#include "c.h"
+*/
+char g = '\''; // #include "c.h"
+int x = 1; \
+#include "c.h"
+
+/* A comment that ends
+   on the line of a directive. */ #include "b.h"
+
+#if 0
+const char *s = "unterminated;
+#include "c.h"
+#endif
+
+// A line comment that continues \
+#include "c.h"
+
+#define DEPENDENCY "d.h"
+#include DEPENDENCY
@@ -0,0 +1,26 @@
+// Note: the RUN lines are near the end of the file, since line/column
+// matter for this test.
+
+struct Widget {
+  int getFooBar();
+  int getFoo();
+  int setFoo(int);
+  int width;
+};
+
+void test(Widget w) {
+  w.getFoo();
+}
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=gfb c-index-test -code-completion-at=%s:12:5 %s | FileCheck -check-prefix=CHECK-FUZZY %s
+// CHECK-FUZZY-NOT: TypedText getFoo}
+// CHECK-FUZZY: CXXMethod:{ResultType int}{TypedText getFooBar}{LeftParen (}{RightParen )}
+// CHECK-FUZZY-NOT: TypedText setFoo
+// CHECK-FUZZY-NOT: TypedText width
+// CHECK-FUZZY: Completion contexts:
+// CHECK-FUZZY-NEXT: Dot member access
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=get CINDEXTEST_COMPLETION_MAX_RESULTS=1 c-index-test -code-completion-at=%s:12:5 %s | FileCheck -check-prefix=CHECK-MAX %s
+// CHECK-MAX: CXXMethod:{ResultType int}{TypedText getFoo}{LeftParen (}{RightParen )}
+// CHECK-MAX-NOT: TypedText getFooBar
+// CHECK-MAX: Completion contexts:
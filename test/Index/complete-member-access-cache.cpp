@@ -0,0 +1,53 @@
+// Note: the RUN lines are near the end of the file, since line/column
+// matter for this test.
+
+struct Base {
+  int base_member;
+  void base_method();
+};
+
+struct Derived : Base {
+  int derived_member;
+};
+
+namespace N {
+  int n_var;
+}
+
+void test(Derived d) {
+  d.derived;
+  N::n_v;
+}
+
+// Repeated member-access and qualified-name completions with unchanged
+// unsaved files reuse the results of the first request.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHE_HITS=1 c-index-test -code-completion-at=%s:18:5 -remap-file="%s;%s" %s | FileCheck -check-prefix=CHECK-MEMBER %s
+// CHECK-MEMBER: Completion cache hits: 4 of 5
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText base_member}
+// CHECK-MEMBER: CXXMethod:{ResultType void}{TypedText base_method}{LeftParen (}{RightParen )}
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText derived_member}
+// CHECK-MEMBER: Completion contexts:
+// CHECK-MEMBER-NEXT: Dot member access
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHE_HITS=1 c-index-test -code-completion-at=%s:19:6 -remap-file="%s;%s" %s | FileCheck -check-prefix=CHECK-QUALIFIED %s
+// CHECK-QUALIFIED: Completion cache hits: 4 of 5
+// CHECK-QUALIFIED: VarDecl:{ResultType int}{TypedText n_var}
+
+// Without unsaved files, the contents of the file are unknown, so every
+// request reparses.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHE_HITS=1 c-index-test -code-completion-at=%s:18:5 %s | FileCheck -check-prefix=CHECK-NOCACHE %s
+// CHECK-NOCACHE: Completion cache hits: 0 of 5
+// CHECK-NOCACHE: FieldDecl:{ResultType int}{TypedText derived_member}
+
+// Filtered requests are answered from the complete cached result set.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHE_HITS=1 CINDEXTEST_COMPLETION_FILTER=derived c-index-test -code-completion-at=%s:18:5 -remap-file="%s;%s" %s | FileCheck -check-prefix=CHECK-FILTER %s
+// CHECK-FILTER: Completion cache hits: 4 of 5
+// CHECK-FILTER-NOT: TypedText base_member
+// CHECK-FILTER: FieldDecl:{ResultType int}{TypedText derived_member}
+// CHECK-FILTER: Completion contexts:
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHE_HITS=1 CINDEXTEST_COMPLETION_FILTER=base CINDEXTEST_COMPLETION_MAX_RESULTS=1 c-index-test -code-completion-at=%s:18:5 -remap-file="%s;%s" %s | FileCheck -check-prefix=CHECK-FILTER-MAX %s
+// CHECK-FILTER-MAX: Completion cache hits: 4 of 5
+// CHECK-FILTER-MAX: {TypedText base_me
+// CHECK-FILTER-MAX-NOT: TypedText
+// CHECK-FILTER-MAX: Completion contexts:
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t
+// Build the modules on demand, which also builds the global module index.
+// RUN: %clang_cc1 -fmodules -x objective-c -fmodule-cache-path %t -I %S/Inputs -verify %s
+// RUN: ls %t/*/modules.idx
+// Use the global module index to satisfy identifier lookups.
+// RUN: %clang_cc1 -fmodules -x objective-c -fmodule-cache-path %t -I %S/Inputs -verify -print-stats %s 2>&1 | FileCheck %s
+// Ignore the global module index entirely.
+// RUN: %clang_cc1 -fmodules -fno-modules-global-index -x objective-c -fmodule-cache-path %t -I %S/Inputs -verify -print-stats %s 2>&1 | FileCheck -check-prefix=NO-INDEX %s
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fno-modules-global-index -x objective-c -fmodule-cache-path %t -I %S/Inputs -verify %s
+// RUN: not ls %t/*/modules.idx
+
+// in diamond-bottom.h: expected-note{{passing argument to parameter 'x' here}}
+
+@__experimental_modules_import diamond_bottom;
+
+void test_diamond(int i, float f, double d, char c) {
+  top(&i);
+  left(&f);
+  right(&d);
+  bottom(&c);
+  bottom(&d); // expected-warning{{incompatible pointer types passing 'double *' to parameter of type 'char *'}}
+
+  // Names in multiple places in the diamond.
+  top_left(&c);
+
+  left_and_right(&i);
+  struct left_and_right lr;
+  lr.left = 17;
+}
+
+// CHECK: *** Global Module Index Statistics:
+// CHECK: {{[1-9][0-9]*}} / {{[0-9]+}} identifier lookups succeeded
+
+// NO-INDEX: *** AST File Statistics:
+// NO-INDEX-NOT: Global Module Index Statistics
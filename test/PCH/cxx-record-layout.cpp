@@ -0,0 +1,51 @@
+// Test this without pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include %s -fsyntax-only -fdump-record-layouts %s 2>&1 | FileCheck %s
+
+// Test with pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -x c++-header -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -fsyntax-only -fdump-record-layouts %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -fsyntax-only -print-stats %s 2>&1 | FileCheck -check-prefix=STATS %s
+
+#ifndef HEADER
+#define HEADER
+
+struct Empty { };
+struct A { virtual void f(); int a; };
+struct B : Empty, virtual A { char b; };
+struct C : B { double c; };
+
+#else
+
+int sizes[] = { sizeof(Empty), sizeof(A), sizeof(B), sizeof(C) };
+
+// CHECK:        0 | struct A
+// CHECK-NEXT:   0 |   (A vtable pointer)
+// CHECK-NEXT:   8 |   int a
+// CHECK-NEXT:   sizeof=16, dsize=12, align=8
+// CHECK-NEXT:   nvsize=12, nvalign=8
+
+// CHECK:        0 | struct B
+// CHECK-NEXT:   0 |   (B vtable pointer)
+// CHECK-NEXT:   0 |   struct Empty (base) (empty)
+// CHECK-NEXT:   8 |   char b
+// CHECK-NEXT:  16 |   struct A (virtual base)
+// CHECK-NEXT:  16 |     (A vtable pointer)
+// CHECK-NEXT:  24 |     int a
+// CHECK-NEXT:   sizeof=32, dsize=28, align=8
+// CHECK-NEXT:   nvsize=9, nvalign=8
+
+// CHECK:        0 | struct C
+// CHECK-NEXT:   0 |   struct B (primary base)
+// CHECK-NEXT:   0 |     (B vtable pointer)
+// CHECK-NEXT:   0 |     struct Empty (base) (empty)
+// CHECK-NEXT:   8 |     char b
+// CHECK-NEXT:  16 |   double c
+// CHECK-NEXT:  24 |   struct A (virtual base)
+// CHECK-NEXT:  24 |     (A vtable pointer)
+// CHECK-NEXT:  32 |     int a
+// CHECK-NEXT:   sizeof=40, dsize=36, align=8
+// CHECK-NEXT:   nvsize=24, nvalign=8
+
+// STATS: {{[0-9]+}}/{{[0-9]+}} record layouts read
+
+#endif
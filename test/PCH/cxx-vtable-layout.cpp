@@ -0,0 +1,45 @@
+// Test this without pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include %s -emit-llvm -o - %s | FileCheck %s
+
+// Test with pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -x c++-header -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -emit-llvm -o %t.ll -print-stats %s 2>&1 | FileCheck -check-prefix=STATS %s
+
+#ifndef HEADER
+#define HEADER
+
+struct A { virtual void f(); virtual ~A(); int a; };
+struct B { virtual void g(); int b; };
+struct C : A, B { void g(); virtual void h(); };
+struct D : virtual A { void f(); };
+
+#else
+
+void C::g() { }
+void C::h() { }
+void D::f() { }
+
+// CHECK: @_ZTV1C = unnamed_addr constant [10 x i8*]
+// CHECK: @_ZN1A1fEv
+// CHECK: @_ZN1CD1Ev
+// CHECK: @_ZN1CD0Ev
+// CHECK: @_ZN1C1gEv
+// CHECK: @_ZN1C1hEv
+// CHECK: @_ZThn16_N1C1gEv
+
+// CHECK: @_ZTV1D = unnamed_addr constant
+// CHECK: @_ZN1D1fEv
+// CHECK: @_ZTv0_n24_N1D1fEv
+
+// CHECK: define void @_Z4callP1C
+// CHECK: i64 4
+void call(C *c) { c->h(); }
+
+// CHECK: define %struct.A* @_Z3toAP1D
+// CHECK: i64 -24
+A *toA(D *d) { return d; }
+
+// STATS: vtable layouts read
+
+#endif
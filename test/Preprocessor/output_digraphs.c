@@ -0,0 +1,15 @@
+// RUN: %clang_cc1 -E -trigraphs %s -o - | FileCheck -strict-whitespace %s
+
+// Punctuators keep their original spelling in -E output.
+A: <: :> <% %> %: %:%: [ ] { } # ## ->* <<= ...
+// CHECK: A: <: :> <% %> %: %:%: [ ] { } # ## ->* <<= ...
+
+#define LB <:
+#define RB ]
+B: LB 0 RB
+// CHECK: B: <: 0 ]
+
+// Tokens that need cleaning are printed in their cleaned form.
+C: ??( ??) -??/
+>
+// CHECK: C: [ ] ->
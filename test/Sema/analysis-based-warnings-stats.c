@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -fsyntax-only -Wuninitialized -Wunreachable-code -print-stats %s 2>&1 | FileCheck %s
+
+// Bodies that no enabled analysis could find anything in do not get a CFG.
+int straight_line(int x) {
+  int y = x + 1;
+  return y;
+}
+
+int trivial(int x) {
+  return x;
+}
+
+int sometimes_uninit(int x) {
+  int y;
+  if (x)
+    y = 1;
+  // CHECK: warning: variable 'y' is used uninitialized whenever 'if' condition is false
+  return y;
+}
+
+int falls_off(int x) {
+  if (x)
+    return 1;
+  // CHECK: warning: control may reach end of non-void function
+}
+
+int self_init(int x) {
+  // CHECK: warning: variable 'y' is uninitialized when used within its own initialization
+  int y = y + x;
+  return y;
+}
+
+// CHECK: *** Analysis Based Warnings Stats:
+// CHECK: 3 functions analyzed (0 w/o CFGs).
+// CHECK: 2 functions skipped (no CFG needed).
+// CHECK: Time spent (seconds):
+// CHECK: building CFGs.
+// CHECK: checking for uninitialized variables.
@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -verify -ftypo-correction-time-limit 100000 %s
+
+// The first typo is corrected by computing the edit distance to every
+// identifier; the following ones use an index of the identifiers.
+
+int counter; // expected-note{{'counter' declared here}}
+int vertex_count; // expected-note{{'vertex_count' declared here}}
+int edge_weight; // expected-note{{'edge_weight' declared here}}
+
+void f(void) {
+  countr = 1; // expected-error{{use of undeclared identifier 'countr'; did you mean 'counter'?}}
+  vertex_cuont = 2; // expected-error{{use of undeclared identifier 'vertex_cuont'; did you mean 'vertex_count'?}}
+  int edge_wieght_local;
+  edge_wieght = 3; // expected-error{{use of undeclared identifier 'edge_wieght'; did you mean 'edge_weight'?}}
+  xyzzy = 4; // expected-error{{use of undeclared identifier 'xyzzy'}}
+}
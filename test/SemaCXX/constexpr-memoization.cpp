@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s -fconstexpr-depth 128
+
+// Without memoization, this makes more than 10^16 calls.
+constexpr unsigned long long fib(unsigned n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+static_assert(fib(80) == 23416728348467685ULL, "");
+static_assert(fib(81) == 37889062373143906ULL, "");
+
+// A memoized call is still subject to the depth limit.
+constexpr int sum(int n) { return n ? n + sum(n - 1) : 0; } // expected-note {{exceeded maximum depth of 128}} expected-note +{{}}
+static_assert(sum(100) == 5050, "");
+constexpr int tooDeep = sum(200); // expected-error {{must be initialized by a constant expression}} expected-note {{in call to 'sum(200)'}}
+static_assert(sum(110) == 6105, "");
+
+// Calls with floating-point arguments are memoized too.
+constexpr double half(double d) { return d / 2; }
+static_assert(half(3.0) == 1.5 && half(-0.0) == 0.0 && half(0.0) == 0.0, "");
+
+// Calls with pointer arguments are not memoized.
+constexpr int len(const char *s) { return *s ? 1 + len(s + 1) : 0; }
+static_assert(len("abc") == 3 && len("hello") == 5 && len("abc") == 3, "");
+
+// Results containing arrays.
+struct Row { int v[4]; };
+constexpr Row fill(int n) { return Row{{n, n, n, n}}; }
+static_assert(fill(3).v[0] == 3 && fill(3).v[3] == 3 && fill(4).v[2] == 4, "");
+
+// Trailing runs of identical values share the array filler.
+constexpr int table[10] = { 1, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+static_assert(table[2] == 3 && table[3] == 0 && table[9] == 0, "");
+constexpr int partial[8] = { 1, 7, 7 };
+static_assert(partial[0] == 1 && partial[2] == 7 && partial[3] == 0, "");
+constexpr double ftable[6] = { 0.5, 1.5, 1.5, 1.5, 1.5, 1.5 };
+static_assert(ftable[0] == 0.5 && ftable[1] == 1.5 && ftable[5] == 1.5, "");
+constexpr int nested[3][4] = { { 1, 1, 1, 1 }, { 2, 5, 5, 5 } };
+static_assert(nested[0][3] == 1 && nested[1][0] == 2 && nested[1][3] == 5 &&
+              nested[2][0] == 0, "");
@@ -0,0 +1,41 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Overload sets with more than a handful of functions keep an index of their
+// declarations. Make sure redeclarations still replace the right entry, also
+// after using declarations have been inserted in front of them.
+
+namespace other {
+  void f(char *);
+}
+
+namespace big {
+  struct S0 {}; struct S1 {}; struct S2 {}; struct S3 {}; struct S4 {};
+  struct S5 {}; struct S6 {}; struct S7 {}; struct S8 {}; struct S9 {};
+  struct S10 {}; struct S11 {}; struct S12 {}; struct S13 {}; struct S14 {};
+  struct S15 {}; struct S16 {}; struct S17 {}; struct S18 {}; struct S19 {};
+
+  int f(S0); int f(S1); int f(S2); int f(S3); int f(S4);
+  int f(S5); int f(S6); int f(S7); int f(S8); int f(S9);
+  int f(S10); int f(S11); int f(S12); int f(S13); int f(S14);
+  int f(S15); int f(S16); int f(S17); int f(S18); int f(S19);
+
+  template <typename T> int f(T *, T *);
+  template <typename T> int f(T *, T *);
+
+  int f(S3);
+  int f(S17);
+
+  using other::f;
+
+  int f(S0) { return 0; }
+  int f(S19) { return 19; } // expected-note{{previous definition is here}}
+  int f(S19) { return 19; } // expected-error{{redefinition of 'f'}}
+
+  template <typename T> int f(T *, T *) { return 2; }
+}
+
+int test(char *p, int *q) {
+  other::f(p);
+  big::f(p);
+  return big::f(S0()) + big::f(S17()) + big::f(q, q);
+}
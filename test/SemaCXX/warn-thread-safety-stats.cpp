@@ -0,0 +1,45 @@
+// RUN: %clang_cc1 -fsyntax-only -Wthread-safety -print-stats %s 2>&1 | FileCheck %s
+
+class __attribute__((lockable)) Mutex {
+ public:
+  void Lock() __attribute__((exclusive_lock_function));
+  void Unlock() __attribute__((unlock_function));
+};
+
+Mutex mu;
+int a __attribute__((guarded_by(mu)));
+
+// Both branches leave the lockset as they found it.
+void balanced(bool c) {
+  if (c) {
+    mu.Lock();
+    a = 1;
+    mu.Unlock();
+  } else {
+    mu.Lock();
+    a = 2;
+    mu.Unlock();
+  }
+}
+
+// Joins which find errors are never answered from the cache.
+void unbalanced(bool c) {
+  if (c)
+    mu.Lock();
+  // CHECK: warning: mutex 'mu' is not locked on every path through here
+  a = 3;
+  if (c)
+    mu.Lock();
+  // CHECK: warning: mutex 'mu' is not locked on every path through here
+  a = 4;
+}
+
+// CHECK: *** Analysis Based Warnings Stats:
+// CHECK: 2 functions analyzed for thread safety
+// CHECK: lockset joins ({{[1-9][0-9]*}} trivial, {{[0-9]+}} cached).
+// CHECK: distinct locksets.
+// CHECK: distinct mutex expressions.
+// CHECK: Time spent (seconds):
+// CHECK: checking thread safety.
+// CHECK-NEXT: computing local variable contexts.
+// CHECK-NEXT: computing locksets.
@@ -1731,11 +1731,15 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   CXTranslationUnit TU = 0;
   unsigned I, Repeats = 1;
   unsigned completionOptions = clang_defaultCodeCompleteOptions();
+  const char *completionFilter = getenv("CINDEXTEST_COMPLETION_FILTER");
+  unsigned maxResults = 0;
   
   if (getenv("CINDEXTEST_CODE_COMPLETE_PATTERNS"))
     completionOptions |= CXCodeComplete_IncludeCodePatterns;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     completionOptions |= CXCodeComplete_IncludeBriefComments;
+  if (getenv("CINDEXTEST_COMPLETION_MAX_RESULTS"))
+    maxResults = atoi(getenv("CINDEXTEST_COMPLETION_MAX_RESULTS"));
   
   if (timing_only)
     input += strlen("-code-completion-timing=");
@@ -1769,9 +1773,10 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   }
   
   for (I = 0; I != Repeats; ++I) {
-    results = clang_codeCompleteAt(TU, filename, line, column,
-                                   unsaved_files, num_unsaved_files,
-                                   completionOptions);
+    results = clang_codeCompleteAtWithFilter(TU, filename, line, column,
+                                             unsaved_files, num_unsaved_files,
+                                             completionOptions,
+                                             completionFilter, maxResults);
     if (!results) {
       fprintf(stderr, "Unable to perform code completion!\n");
       return 1;
@@ -1780,6 +1785,11 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
       clang_disposeCodeCompleteResults(results);
   }
 
+  if (getenv("CINDEXTEST_COMPLETION_CACHE_HITS"))
+    printf("Completion cache hits: %u of %u\n",
+           clang_codeCompleteGetNumCacheHits(TU),
+           clang_codeCompleteGetLatencyHistogram(TU, 0, 0));
+
   if (results) {
     unsigned i, n = results->NumResults, containerIsIncomplete = 0;
     unsigned long long contexts;
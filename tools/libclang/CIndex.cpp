@@ -63,6 +63,7 @@ CXTranslationUnit cxtu::MakeCXTranslationUnit(CIndexer *CIdx, ASTUnit *TU) {
   D->StringPool = createCXStringPool();
   D->Diagnostics = 0;
   D->OverridenCursorsPool = createOverridenCXCursorsPool();
+  D->CodeCompletionCache = cxcodecomplete::createCodeCompletionCache();
   return D;
 }
 
@@ -2776,6 +2777,7 @@ void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
     disposeCXStringPool(CTUnit->StringPool);
     delete static_cast<CXDiagnosticSetImpl *>(CTUnit->Diagnostics);
     disposeOverridenCXCursorsPool(CTUnit->OverridenCursorsPool);
+    cxcodecomplete::disposeCodeCompletionCache(CTUnit->CodeCompletionCache);
     delete CTUnit;
   }
 }
@@ -2816,6 +2818,10 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
 
   ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+
+  // Code-completion results retained from the previous parse may no longer
+  // be valid.
+  cxcodecomplete::resetCodeCompletionCache(TU->CodeCompletionCache);
   
   OwningPtr<std::vector<ASTUnit::RemappedFile> >
     RemappedFiles(new std::vector<ASTUnit::RemappedFile>());
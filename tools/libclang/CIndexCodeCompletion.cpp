@@ -27,6 +27,7 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Atomic.h"
@@ -35,8 +36,11 @@
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Program.h"
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
 #include <cstdio>
+#include <sys/stat.h>
 
 
 #ifdef UDP_CODE_COMPLETION_LOGGER
@@ -237,10 +241,13 @@ clang_getCompletionBriefComment(CXCompletionString completion_string) {
 }
 
   
+struct CachedCodeCompleteResults;
+
 /// \brief The CXCodeCompleteResults structure we allocate internally;
 /// the client only sees the initial CXCodeCompleteResults structure.
 struct AllocatedCXCodeCompleteResults : public CXCodeCompleteResults {
   AllocatedCXCodeCompleteResults(const FileSystemOptions& FileSystemOpts);
+  explicit AllocatedCXCodeCompleteResults(CachedCodeCompleteResults *Cached);
   ~AllocatedCXCodeCompleteResults();
   
   /// \brief Diagnostics produced while performing code completion.
@@ -296,6 +303,44 @@ struct AllocatedCXCodeCompleteResults : public CXCodeCompleteResults {
   /// \brief A string containing the Objective-C selector entered thus far for a
   /// message send.
   std::string Selector;
+
+  /// \brief When these results are a copy of results cached by the
+  /// translation unit, the cached results, which own the completion strings,
+  /// source manager and buffers referenced by this copy.
+  IntrusiveRefCntPtr<CachedCodeCompleteResults> SharedResults;
+};
+
+/// \brief A set of code-completion results retained by a translation unit,
+/// so that a subsequent code-completion request at the same position can be
+/// answered without reparsing.
+struct CachedCodeCompleteResults
+  : public llvm::RefCountedBase<CachedCodeCompleteResults> {
+  /// \brief The results themselves, which are never handed out to the client
+  /// directly.
+  OwningPtr<AllocatedCXCodeCompleteResults> Results;
+
+  /// \brief The file, line and column at which code completion occurred.
+  std::string FileName;
+  unsigned Line;
+  unsigned Column;
+
+  /// \brief The code-completion options used to produce the results.
+  unsigned Options;
+
+  /// \brief The hash of the unsaved files at the time code completion
+  /// occurred, as computed by \c hashCompletionBuffers().
+  size_t BuffersHash;
+
+  /// \brief The state on disk of a file read while producing the results.
+  struct FileState {
+    std::string Name;
+    off_t Size;
+    time_t ModTime;
+  };
+
+  /// \brief The files read while producing the results, so that changes made
+  /// to them on disk without a reparse invalidate the results.
+  std::vector<FileState> Files;
 };
 
 /// \brief Tracks the number of code-completion result objects that are 
@@ -315,6 +360,7 @@ AllocatedCXCodeCompleteResults::AllocatedCXCodeCompleteResults(
     FileMgr(new FileManager(FileSystemOpts)),
     SourceMgr(new SourceManager(*Diag, *FileMgr)),
     CodeCompletionAllocator(new clang::GlobalCodeCompletionAllocator),
+    ContextKind(CodeCompletionContext::CCC_Other),
     Contexts(CXCompletionContext_Unknown),
     ContainerKind(CXCursor_InvalidCode),
     ContainerUSR(createCXString("")),
@@ -326,6 +372,40 @@ AllocatedCXCodeCompleteResults::AllocatedCXCodeCompleteResults(
   }    
 }
   
+AllocatedCXCodeCompleteResults::AllocatedCXCodeCompleteResults(
+                                          CachedCodeCompleteResults *Cached)
+  : CXCodeCompleteResults(),
+    Diagnostics(Cached->Results->Diagnostics),
+    DiagOpts(Cached->Results->DiagOpts),
+    Diag(Cached->Results->Diag),
+    LangOpts(Cached->Results->LangOpts),
+    FileSystemOpts(Cached->Results->FileSystemOpts),
+    FileMgr(Cached->Results->FileMgr),
+    SourceMgr(Cached->Results->SourceMgr),
+    CachedCompletionAllocator(Cached->Results->CachedCompletionAllocator),
+    CodeCompletionAllocator(Cached->Results->CodeCompletionAllocator),
+    ContextKind(Cached->Results->ContextKind),
+    Contexts(Cached->Results->Contexts),
+    ContainerKind(Cached->Results->ContainerKind),
+    ContainerUSR(createCXString(
+                   clang_getCString(Cached->Results->ContainerUSR), true)),
+    ContainerIsIncomplete(Cached->Results->ContainerIsIncomplete),
+    Selector(Cached->Results->Selector),
+    SharedResults(Cached)
+{
+  // The diagnostics, completion strings and buffers are owned by the cached
+  // results; only the array of results is copied, since clients sort it.
+  NumResults = Cached->Results->NumResults;
+  Results = new CXCompletionResult [NumResults];
+  std::memcpy(Results, Cached->Results->Results,
+              NumResults * sizeof(CXCompletionResult));
+
+  if (getenv("LIBCLANG_OBJTRACKING")) {
+    llvm::sys::AtomicIncrement(&CodeCompletionResultObjects);
+    fprintf(stderr, "+++ %d completion results\n", CodeCompletionResultObjects);
+  }
+}
+
 AllocatedCXCodeCompleteResults::~AllocatedCXCodeCompleteResults() {
   delete [] Results;
   
@@ -653,6 +733,224 @@ namespace {
   };
 }
 
+namespace {
+  /// \brief The number of buckets in the code-completion latency histogram.
+  ///
+  /// Bucket 0 counts requests that took less than a millisecond, bucket I
+  /// counts requests that took [2^(I-1), 2^I) milliseconds, and the last
+  /// bucket also counts everything slower than that.
+  const unsigned NumLatencyBuckets = 16;
+
+  /// \brief The code-completion state kept for each translation unit.
+  struct CodeCompletionCache {
+    CodeCompletionCache()
+      : UncachedLine(0), UncachedColumn(0), UncachedBuffersHash(0),
+        NumCompletions(0), NumCacheHits(0) {
+      std::memset(LatencyBuckets, 0, sizeof(LatencyBuckets));
+    }
+
+    /// \brief The most recent code-completion results that are eligible for
+    /// reuse, if any.
+    IntrusiveRefCntPtr<CachedCodeCompleteResults> Cached;
+
+    /// \brief The position and unsaved-file hash of the most recent request
+    /// whose results were not eligible for reuse. Later requests with the
+    /// same key let Sema apply their filter, instead of producing the
+    /// complete result set.
+    std::string UncachedFileName;
+    unsigned UncachedLine;
+    unsigned UncachedColumn;
+    size_t UncachedBuffersHash;
+
+    /// \brief The code-completion latency histogram.
+    unsigned LatencyBuckets[NumLatencyBuckets];
+
+    /// \brief The number of code-completion requests performed.
+    unsigned NumCompletions;
+
+    /// \brief The number of code-completion requests that were satisfied by
+    /// cached results.
+    unsigned NumCacheHits;
+
+    /// \brief Record a code-completion request that took \p Seconds.
+    void addLatency(double Seconds) {
+      double Milliseconds = Seconds * 1000.0;
+      unsigned Bucket = 0;
+      while (Bucket + 1 != NumLatencyBuckets &&
+             Milliseconds >= double(1u << Bucket))
+        ++Bucket;
+      ++LatencyBuckets[Bucket];
+      ++NumCompletions;
+    }
+  };
+}
+
+void *cxcodecomplete::createCodeCompletionCache() {
+  return new CodeCompletionCache();
+}
+
+void cxcodecomplete::resetCodeCompletionCache(void *Cache) {
+  if (Cache) {
+    static_cast<CodeCompletionCache *>(Cache)->Cached = 0;
+    static_cast<CodeCompletionCache *>(Cache)->UncachedFileName.clear();
+  }
+}
+
+void cxcodecomplete::disposeCodeCompletionCache(void *Cache) {
+  delete static_cast<CodeCompletionCache *>(Cache);
+}
+
+/// \brief Determine whether the results of code completion in the given
+/// context are worth retaining for subsequent requests.
+///
+/// Member access and qualified-name completions are the common case while
+/// typing, and their result sets are determined entirely by the base type or
+/// the nested-name-specifier, which precede the completion point.
+static bool isCacheableCompletionContext(CodeCompletionContext::Kind Kind) {
+  switch (Kind) {
+  case CodeCompletionContext::CCC_DotMemberAccess:
+  case CodeCompletionContext::CCC_ArrowMemberAccess:
+  case CodeCompletionContext::CCC_ObjCPropertyAccess:
+  case CodeCompletionContext::CCC_Name:
+  case CodeCompletionContext::CCC_PotentiallyQualifiedName:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/// \brief Hash the unsaved files, to determine whether cached code-completion
+/// results can be reused.
+///
+/// The identifier characters immediately following the completion point in
+/// the file being completed are not hashed: parsing stops at the completion
+/// point, so the results do not depend on the name the user is typing there.
+/// This lets every keystroke of that name reuse the same results.
+///
+/// \returns false if the file being completed is not one of the unsaved
+/// files, in which case its contents are unknown and the results cannot be
+/// reused.
+static bool hashCompletionBuffers(StringRef FileName, unsigned Line,
+                                  unsigned Column,
+                                  struct CXUnsavedFile *unsaved_files,
+                                  unsigned num_unsaved_files,
+                                  size_t &Hash) {
+  using llvm::hash_combine;
+  using llvm::hash_value;
+
+  bool FoundCompletionFile = false;
+  llvm::hash_code Code = hash_value(num_unsaved_files);
+  for (unsigned I = 0; I != num_unsaved_files; ++I) {
+    StringRef Name(unsaved_files[I].Filename);
+    StringRef Contents(unsaved_files[I].Contents, unsaved_files[I].Length);
+    Code = hash_combine(Code, Name);
+    if (FoundCompletionFile || Name != FileName) {
+      Code = hash_combine(Code, Contents);
+      continue;
+    }
+
+    // Find the completion point.
+    FoundCompletionFile = true;
+    size_t Offset = 0;
+    for (unsigned CurLine = 1; CurLine < Line && Offset < Contents.size();
+         ++Offset) {
+      if (Contents[Offset] == '\n' || Contents[Offset] == '\r') {
+        if (Offset + 1 < Contents.size() &&
+            (Contents[Offset + 1] == '\n' || Contents[Offset + 1] == '\r') &&
+            Contents[Offset] != Contents[Offset + 1])
+          ++Offset;
+        ++CurLine;
+      }
+    }
+    Offset = std::min(Offset + Column - 1, Contents.size());
+
+    // Skip the identifier being typed.
+    size_t End = Offset;
+    while (End < Contents.size() &&
+           (isalnum(static_cast<unsigned char>(Contents[End])) ||
+            Contents[End] == '_' || Contents[End] == '$'))
+      ++End;
+
+    Code = hash_combine(Code, Contents.substr(0, Offset),
+                        Contents.substr(End));
+  }
+
+  Hash = Code;
+  return FoundCompletionFile;
+}
+
+/// \brief Record the size and modification time of each file that
+/// \p FileMgr read while producing code-completion results.
+static void recordFileStates(FileManager &FileMgr,
+                     std::vector<CachedCodeCompleteResults::FileState> &Files) {
+  SmallVector<const FileEntry *, 16> Entries;
+  FileMgr.GetUniqueIDMapping(Entries);
+  for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
+    if (!Entries[I])
+      continue;
+
+    // Remapped files that do not exist on disk are covered by the hash of
+    // the unsaved files.
+    struct stat StatBuf;
+    if (FileMgr.getNoncachedStatValue(Entries[I]->getName(), StatBuf))
+      continue;
+    CachedCodeCompleteResults::FileState State;
+    State.Name = Entries[I]->getName();
+    State.Size = StatBuf.st_size;
+    State.ModTime = StatBuf.st_mtime;
+    Files.push_back(State);
+  }
+}
+
+/// \brief Determine whether any of the files read while producing cached
+/// code-completion results has changed on disk since.
+static bool haveFilesChanged(CachedCodeCompleteResults *Cached) {
+  FileManager &FileMgr = *Cached->Results->FileMgr;
+  for (unsigned I = 0, N = Cached->Files.size(); I != N; ++I) {
+    const CachedCodeCompleteResults::FileState &State = Cached->Files[I];
+    struct stat StatBuf;
+    if (FileMgr.getNoncachedStatValue(State.Name, StatBuf) ||
+        StatBuf.st_size != State.Size || StatBuf.st_mtime != State.ModTime)
+      return true;
+  }
+  return false;
+}
+
+/// \brief Keep only the code-completion results that match the given filter
+/// text, ranked and limited to \p MaxResults as Sema does for filtered
+/// requests.
+static void filterCompletionResults(AllocatedCXCodeCompleteResults &Results,
+                                    StringRef Filter, unsigned MaxResults) {
+  if (Filter.empty() && !MaxResults)
+    return;
+
+  SmallVector<RankedCodeCompletionResult, 64> Ranked;
+  Ranked.reserve(Results.NumResults);
+  for (unsigned I = 0; I != Results.NumResults; ++I) {
+    CodeCompletionString *CCS
+      = static_cast<CodeCompletionString *>(
+                                        Results.Results[I].CompletionString);
+    const char *TypedText = CCS->getTypedText();
+    StringRef Name = TypedText ? TypedText : "";
+    unsigned Quality = getCodeCompletionFilterQuality(Name, Filter);
+    if (!Quality)
+      continue;
+
+    RankedCodeCompletionResult R = { Quality, CCS->getPriority(),
+                                     static_cast<unsigned>(Name.size()), I };
+    Ranked.push_back(R);
+  }
+
+  unsigned NumKept = rankCodeCompletionResults(Ranked, MaxResults);
+  SmallVector<CXCompletionResult, 64> Kept;
+  Kept.reserve(NumKept);
+  for (unsigned I = 0; I != NumKept; ++I)
+    Kept.push_back(Results.Results[Ranked[I].Index]);
+  std::copy(Kept.begin(), Kept.end(), Results.Results);
+  Results.NumResults = NumKept;
+}
+
 extern "C" {
 struct CodeCompleteAtInfo {
   CXTranslationUnit TU;
@@ -662,6 +960,8 @@ struct CodeCompleteAtInfo {
   struct CXUnsavedFile *unsaved_files;
   unsigned num_unsaved_files;
   unsigned options;
+  const char *filter;
+  unsigned max_results;
   CXCodeCompleteResults *result;
 };
 void clang_codeCompleteAt_Impl(void *UserData) {
@@ -674,13 +974,11 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   unsigned num_unsaved_files = CCAI->num_unsaved_files;
   unsigned options = CCAI->options;
   bool IncludeBriefComments = options & CXCodeComplete_IncludeBriefComments;
+  StringRef filter = CCAI->filter ? CCAI->filter : "";
+  unsigned max_results = CCAI->max_results;
   CCAI->result = 0;
 
-#ifdef UDP_CODE_COMPLETION_LOGGER
-#ifdef UDP_CODE_COMPLETION_LOGGER_PORT
   const llvm::TimeRecord &StartTime =  llvm::TimeRecord::getCurrentTime();
-#endif
-#endif
 
   bool EnableLogging = getenv("LIBCLANG_CODE_COMPLETION_LOGGING") != 0;
   
@@ -694,6 +992,42 @@ void clang_codeCompleteAt_Impl(void *UserData) {
 
   ASTUnit::ConcurrencyCheck Check(*AST);
 
+  // If the previous request was made at this position, and nothing but the
+  // name being completed has changed since, answer this one from its
+  // results. Only complete result sets are cached, so that each request can
+  // apply its own filter text and result limit to them.
+  CodeCompletionCache &Cache
+    = *static_cast<CodeCompletionCache *>(TU->CodeCompletionCache);
+  size_t BuffersHash = 0;
+  bool CanCache = hashCompletionBuffers(complete_filename, complete_line,
+                                        complete_column, unsaved_files,
+                                        num_unsaved_files, BuffersHash);
+  if (CanCache && Cache.Cached &&
+      Cache.Cached->FileName == complete_filename &&
+      Cache.Cached->Line == complete_line &&
+      Cache.Cached->Column == complete_column &&
+      Cache.Cached->Options == options &&
+      Cache.Cached->BuffersHash == BuffersHash &&
+      !haveFilesChanged(Cache.Cached.getPtr())) {
+    AllocatedCXCodeCompleteResults *Results
+      = new AllocatedCXCodeCompleteResults(Cache.Cached.getPtr());
+    filterCompletionResults(*Results, filter, max_results);
+    CCAI->result = Results;
+    ++Cache.NumCacheHits;
+    Cache.addLatency(llvm::TimeRecord::getCurrentTime().getWallTime() -
+                     StartTime.getWallTime());
+    return;
+  }
+  Cache.Cached = 0;
+
+  // Produce the complete result set if it may be cached, unless the previous
+  // request with the same key was in a context whose results are not reused.
+  if (CanCache && Cache.UncachedFileName == complete_filename &&
+      Cache.UncachedLine == complete_line &&
+      Cache.UncachedColumn == complete_column &&
+      Cache.UncachedBuffersHash == BuffersHash)
+    CanCache = false;
+
   // Perform the remapping of source files.
   SmallVector<ASTUnit::RemappedFile, 4> RemappedFiles;
   for (unsigned I = 0; I != num_unsaved_files; ++I) {
@@ -717,6 +1051,10 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   // Create a code-completion consumer to capture the results.
   CodeCompleteOptions Opts;
   Opts.IncludeBriefComments = IncludeBriefComments;
+  if (!CanCache) {
+    Opts.Filter = filter;
+    Opts.MaxResults = max_results;
+  }
   CaptureCompletionResults Capture(Opts, *Results, &TU);
 
   // Perform completion.
@@ -736,11 +1074,11 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   // results are still active).
   Results->CachedCompletionAllocator = AST->getCachedCompletionAllocator();
 
-  
+  const llvm::TimeRecord &EndTime =  llvm::TimeRecord::getCurrentTime();
+  Cache.addLatency(EndTime.getWallTime() - StartTime.getWallTime());
 
 #ifdef UDP_CODE_COMPLETION_LOGGER
 #ifdef UDP_CODE_COMPLETION_LOGGER_PORT
-  const llvm::TimeRecord &EndTime =  llvm::TimeRecord::getCurrentTime();
   SmallString<256> LogResult;
   llvm::raw_svector_ostream os(LogResult);
 
@@ -810,6 +1148,29 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   }
 #endif
 #endif
+
+  // Retain member-access and qualified-name results, handing the client a
+  // filtered copy, so that they can be reused while the user types.
+  if (CanCache) {
+    if (isCacheableCompletionContext(Results->ContextKind)) {
+      Cache.Cached = new CachedCodeCompleteResults;
+      Cache.Cached->Results.reset(Results);
+      Cache.Cached->FileName = complete_filename;
+      Cache.Cached->Line = complete_line;
+      Cache.Cached->Column = complete_column;
+      Cache.Cached->Options = options;
+      Cache.Cached->BuffersHash = BuffersHash;
+      recordFileStates(*Results->FileMgr, Cache.Cached->Files);
+      Results = new AllocatedCXCodeCompleteResults(Cache.Cached.getPtr());
+    } else {
+      Cache.UncachedFileName = complete_filename;
+      Cache.UncachedLine = complete_line;
+      Cache.UncachedColumn = complete_column;
+      Cache.UncachedBuffersHash = BuffersHash;
+    }
+    filterCompletionResults(*Results, filter, max_results);
+  }
+
   CCAI->result = Results;
 }
 CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
@@ -819,9 +1180,24 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             struct CXUnsavedFile *unsaved_files,
                                             unsigned num_unsaved_files,
                                             unsigned options) {
+  return clang_codeCompleteAtWithFilter(TU, complete_filename, complete_line,
+                                        complete_column, unsaved_files,
+                                        num_unsaved_files, options, 0, 0);
+}
+
+CXCodeCompleteResults *
+clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line,
+                               unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files,
+                               unsigned options,
+                               const char *filter,
+                               unsigned max_results) {
   CodeCompleteAtInfo CCAI = { TU, complete_filename, complete_line,
                               complete_column, unsaved_files, num_unsaved_files,
-                              options, 0 };
+                              options, filter, max_results, 0 };
   llvm::CrashRecoveryContext CRC;
 
   if (!RunSafely(CRC, clang_codeCompleteAt_Impl, &CCAI)) {
@@ -911,6 +1287,45 @@ CXString clang_codeCompleteGetObjCSelector(CXCodeCompleteResults *ResultsIn) {
   
   return createCXString(Results->Selector);
 }
+
+unsigned clang_codeCompleteGetLatencyHistogram(CXTranslationUnit TU,
+                                               unsigned *Buckets,
+                                               unsigned NumBuckets) {
+  if (!TU || !TU->CodeCompletionCache)
+    return 0;
+
+  CodeCompletionCache &Cache
+    = *static_cast<CodeCompletionCache *>(TU->CodeCompletionCache);
+  if (Buckets) {
+    for (unsigned I = 0; I != NumBuckets; ++I) {
+      if (I < NumLatencyBuckets)
+        Buckets[I] = Cache.LatencyBuckets[I];
+      else
+        Buckets[I] = 0;
+    }
+  }
+
+  return Cache.NumCompletions;
+}
+
+unsigned clang_codeCompleteGetNumCacheHits(CXTranslationUnit TU) {
+  if (!TU || !TU->CodeCompletionCache)
+    return 0;
+
+  return static_cast<CodeCompletionCache *>(TU->CodeCompletionCache)
+           ->NumCacheHits;
+}
+
+void clang_codeCompleteResetLatencyHistogram(CXTranslationUnit TU) {
+  if (!TU || !TU->CodeCompletionCache)
+    return;
+
+  CodeCompletionCache &Cache
+    = *static_cast<CodeCompletionCache *>(TU->CodeCompletionCache);
+  std::memset(Cache.LatencyBuckets, 0, sizeof(Cache.LatencyBuckets));
+  Cache.NumCompletions = 0;
+  Cache.NumCacheHits = 0;
+}
   
 } // end extern "C"
 
@@ -99,6 +99,20 @@ public:
   namespace cxindex {
     void printDiagsToStderr(ASTUnit *Unit);
   }
+
+  namespace cxcodecomplete {
+    /// \brief Create the per-translation-unit code-completion state, which
+    /// holds the most recent reusable code-completion results along with
+    /// code-completion latency statistics.
+    void *createCodeCompletionCache();
+
+    /// \brief Drop any code-completion results retained for reuse, e.g.,
+    /// because the translation unit has been reparsed.
+    void resetCodeCompletionCache(void *Cache);
+
+    /// \brief Dispose of the per-translation-unit code-completion state.
+    void disposeCodeCompletionCache(void *Cache);
+  }
 }
 
 #endif
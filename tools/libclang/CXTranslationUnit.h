@@ -21,6 +21,7 @@ struct CXTranslationUnitImpl {
   void *StringPool;
   void *Diagnostics;
   void *OverridenCursorsPool;
+  void *CodeCompletionCache;
 };
 }
 
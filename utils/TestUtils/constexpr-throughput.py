@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+
+"""
+Measure the time clang takes to evaluate constexpr-heavy code.
+
+This generates a few typical constexpr workloads and times clang parsing each
+of them:
+
+  recursion  naive recursive functions that call themselves repeatedly with
+             the same arguments, such as Fibonacci numbers
+  tables     compile-time lookup tables with one constexpr call per entry
+  padding    large constexpr arrays padded with a repeated value
+  parser     a recursive descent parser run over string literals
+
+Usage: constexpr-throughput.py [--clang=path/to/clang] [--runs=N]
+                               [--size=N]
+"""
+
+import throughput
+
+def generate_recursion(f, size):
+    print >>f, 'constexpr unsigned long long fib(unsigned n) {'
+    print >>f, '  return n < 2 ? n : fib(n - 1) + fib(n - 2);'
+    print >>f, '}'
+    print >>f, 'constexpr unsigned long long binom(unsigned n, unsigned k) {'
+    print >>f, '  return k == 0 || k == n ? 1 : binom(n - 1, k - 1) + ' \
+               'binom(n - 1, k);'
+    print >>f, '}'
+    for i in range(size / 100):
+        print >>f, 'static_assert(fib(%d) > 0, "");' % (18 + i % 10)
+        print >>f, 'static_assert(binom(%d, %d) > 0, "");' % (20 + i % 10,
+                                                               i % 10)
+
+def generate_tables(f, size):
+    print >>f, 'constexpr unsigned crc(unsigned c, int k = 8) {'
+    print >>f, '  return k == 0 ? c : crc(c & 1 ? 0xedb88320u ^ (c >> 1) ' \
+               ': c >> 1, k - 1);'
+    print >>f, '}'
+    print >>f, 'constexpr unsigned table[] = {'
+    for i in range(size):
+        print >>f, '  crc(%d),' % (i % 256)
+    print >>f, '};'
+    print >>f, 'static_assert(table[%d] == crc(%d), "");' % (size - 1,
+                                                            (size - 1) % 256)
+
+def generate_padding(f, size):
+    for i in range(size / 1000):
+        print >>f, 'constexpr int padded%d[%d] = { %d, %s };' % (
+            i, size, i, ', '.join(['0'] * (size - 1)))
+        print >>f, 'static_assert(padded%d[%d] == 0, "");' % (i, size - 1)
+
+def generate_parser(f, size):
+    print >>f, 'constexpr bool isdigit(char c) { return c >= \'0\' && ' \
+               'c <= \'9\'; }'
+    print >>f, 'constexpr int number(const char *s, int v = 0) {'
+    print >>f, '  return isdigit(*s) ? number(s + 1, v * 10 + (*s - \'0\')) ' \
+               ': v;'
+    print >>f, '}'
+    print >>f, 'constexpr const char *skip(const char *s) {'
+    print >>f, '  return isdigit(*s) ? skip(s + 1) : s;'
+    print >>f, '}'
+    print >>f, 'constexpr int sum(const char *s) {'
+    print >>f, '  return *s == 0 ? 0 : *s == \'+\' ? sum(s + 1) : ' \
+               'number(s) + sum(skip(s));'
+    print >>f, '}'
+    terms = '+'.join([str(i) for i in range(50)])
+    for i in range(size / 100):
+        print >>f, 'static_assert(sum("%s+%d") == %d, "");' % (
+            terms, i, sum(range(50)) + i)
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--size', type='int', default=10000,
+                      help='scale of the generated workloads')
+    opts, args = parser.parse_args()
+
+    workloads = [('recursion', generate_recursion),
+                 ('tables', generate_tables),
+                 ('padding', generate_padding),
+                 ('parser', generate_parser)]
+    sources = []
+    try:
+        for name, generate in workloads:
+            source = throughput.generate_file('.cpp', generate, opts.size)
+            sources.append(source)
+            throughput.measure(opts.clang, source, name,
+                               ['-fsyntax-only', '-std=c++11', '-x', 'c++'],
+                               opts.runs)
+    finally:
+        throughput.remove_files(sources)
+
+if __name__ == "__main__":
+    main()
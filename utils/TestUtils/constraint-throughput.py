@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+"""
+Measure the speed of the analyzer's range constraint manager.
+
+This generates functions which index arrays with symbolic values after many
+bounds checks, then times the analyzer on them with the tree-based and the
+compact representation of range sets.
+
+Usage: constraint-throughput.py [--clang=path/to/clang] [--runs=N]
+                                [--functions=N] [--checks=N]
+"""
+
+import throughput
+
+def generate_source(f, functions, checks):
+    print >>f, 'int g(int);'
+    for i in range(functions):
+        print >>f, 'int f%d(int *a, int n, int i, int j) {' % i
+        print >>f, '  int sum = 0;'
+        for k in range(checks):
+            # Check the same indices against different bounds over and over,
+            # so that the same ranges are intersected on many paths.
+            print >>f, '  if (i >= %d && i < n - %d && j != %d)' % (
+                k % 4, k % 8, k)
+            print >>f, '    sum += a[i] + a[j];'
+            print >>f, '  if (g(%d) && j > i)' % k
+            print >>f, '    sum -= a[j - i];'
+        print >>f, '  return sum;'
+        print >>f, '}'
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--functions', type='int', default=50,
+                      help='number of generated functions')
+    parser.add_option('--checks', type='int', default=40,
+                      help='number of bounds checks in each function')
+    opts, args = parser.parse_args()
+
+    source = throughput.generate_file('.c', generate_source, opts.functions,
+                                      opts.checks)
+    analyze = ['-analyze', '-analyzer-checker=core,alpha.security.ArrayBound',
+               '-analyzer-constraints=range']
+    try:
+        throughput.measure(opts.clang, source, 'range sets (tree)',
+                           analyze, opts.runs)
+        throughput.measure(opts.clang, source, 'range sets (compact)',
+                           analyze + ['-analyzer-config',
+                                      'compact-range-sets=true'],
+                           opts.runs)
+    finally:
+        throughput.remove_files([source])
+
+if __name__ == "__main__":
+    main()
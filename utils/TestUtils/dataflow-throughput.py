@@ -0,0 +1,52 @@
+#!/usr/bin/env python
+
+"""
+Measure the speed of the intraprocedural dataflow analyses.
+
+This generates functions with thousands of locals and many branches and loops,
+then times clang's -Wuninitialized (uninitialized values) and the analyzer's
+dead store checker (live variables) on them.
+
+Usage: dataflow-throughput.py [--clang=path/to/clang] [--runs=N] [--locals=N]
+"""
+
+import throughput
+
+def generate_source(f, N):
+    print >>f, 'int g(int);'
+    print >>f, 'int f(int n) {'
+    for i in range(N):
+        print >>f, '  int x%d;' % i
+    for i in range(N):
+        # Alternate between initializing in a branch and in a loop, so that
+        # values keep changing until the analysis reaches a fixed point.
+        if i % 2:
+            print >>f, '  if (g(%d)) x%d = n; else x%d = %d;' % (i, i, i, i)
+        else:
+            print >>f, '  for (int i = 0; i < n; ++i) x%d = g(x%d);' % (
+                i, (i + 1) % N)
+    print >>f, '  return %s;' % ' + '.join(['x%d' % i for i in range(0, N, 7)])
+    print >>f, '}'
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--locals', type='int', default=4000,
+                      help='number of local variables in the generated '
+                           'function')
+    opts, args = parser.parse_args()
+
+    source = throughput.generate_file('.c', generate_source, opts.locals)
+    try:
+        throughput.measure(opts.clang, source, 'parsing only',
+                           ['-fsyntax-only'], opts.runs)
+        throughput.measure(opts.clang, source, 'uninitialized values',
+                           ['-fsyntax-only', '-Wuninitialized'], opts.runs)
+        throughput.measure(opts.clang, source, 'live variables',
+                           ['-analyze',
+                            '-analyzer-checker=deadcode.DeadStores'],
+                           opts.runs)
+    finally:
+        throughput.remove_files([source])
+
+if __name__ == "__main__":
+    main()
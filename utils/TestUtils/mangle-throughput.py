@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+
+"""
+Measure the time clang spends mangling names.
+
+This generates a few template-heavy translation units, emits LLVM IR for
+each of them, and reports the time clang spends mangling the names of the
+emitted functions and variables, as measured by its "Name Mangling Time"
+timer (-ftime-report):
+
+  nested     many members of classes nested in several namespaces
+  templates  the members of a class template instantiated with many
+             template arguments
+  mixed      nested class templates whose members take each other as
+             parameters
+
+Usage: mangle-throughput.py [--clang=path/to/clang] [--runs=N] [--size=N]
+"""
+
+import os
+
+import throughput
+
+def generate_nested(f, size):
+    print >>f, 'namespace first { namespace second { namespace third {'
+    print >>f, 'struct Container { struct Element {'
+    for i in range(size):
+        print >>f, '  void member%d(Element *, Container *) { }' % i
+    print >>f, '}; };'
+    print >>f, '} } }'
+    print >>f, 'void use(first::second::third::Container::Element *e) {'
+    for i in range(size):
+        print >>f, '  e->member%d(e, 0);' % i
+    print >>f, '}'
+
+def generate_templates(f, size):
+    print >>f, 'namespace library { namespace detail {'
+    print >>f, 'template<typename T, int N> struct Storage {'
+    for i in range(10):
+        print >>f, '  void method%d(Storage *, T *) { }' % i
+    print >>f, '};'
+    print >>f, '} }'
+    print >>f, 'template<int N> struct Tag { };'
+    print >>f, 'template<typename T, int N> void use() {'
+    print >>f, '  library::detail::Storage<T, N> s;'
+    for i in range(10):
+        print >>f, '  s.method%d(0, 0);' % i
+    print >>f, '}'
+    for i in range(size / 10):
+        print >>f, 'template void use<Tag<%d>, %d>();' % (i, i % 7)
+
+def generate_mixed(f, size):
+    print >>f, 'namespace outer { namespace inner {'
+    print >>f, 'template<typename T> struct List {'
+    print >>f, '  template<typename U> struct Node {'
+    for i in range(10):
+        print >>f, '    void link%d(Node *, List *, U *) { }' % i
+    print >>f, '  };'
+    print >>f, '};'
+    print >>f, '} }'
+    print >>f, 'template<int N> struct Key { };'
+    print >>f, 'template<int N> void use() {'
+    print >>f, '  outer::inner::List<Key<N> >::template Node<Key<N + 1> > n;'
+    for i in range(10):
+        print >>f, '  n.link%d(0, 0, 0);' % i
+    print >>f, '}'
+    for i in range(size / 10):
+        print >>f, 'template void use<%d>();' % i
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--size', type='int', default=10000,
+                      help='number of functions in the generated workloads')
+    opts, args = parser.parse_args()
+
+    workloads = [('nested', generate_nested),
+                 ('templates', generate_templates),
+                 ('mixed', generate_mixed)]
+    sources = []
+    try:
+        for name, generate in workloads:
+            source = throughput.generate_file('.cpp', generate, opts.size)
+            sources.append(source)
+            mangling = throughput.time_timer(opts.clang, source,
+                                             ['-x', 'c++', '-O0',
+                                              '-emit-llvm', '-o', os.devnull],
+                                             'Name Mangling Time', opts.runs)
+            throughput.report(name, mangling)
+    finally:
+        throughput.remove_files(sources)
+
+if __name__ == "__main__":
+    main()
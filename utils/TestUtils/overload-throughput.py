@@ -0,0 +1,50 @@
+#!/usr/bin/env python
+
+"""
+Measure how the time to build a namespace scales with the size of the overload
+sets in it.
+
+This generates a namespace with many functions, either all overloads of the
+same name or all with different names, and optionally redeclares each of them,
+then times clang parsing it. Both variants should take about the same time.
+
+Usage: overload-throughput.py [--clang=path/to/clang] [--runs=N]
+                              [--functions=N] [--redeclare]
+"""
+
+import throughput
+
+def generate_source(f, functions, overloaded, redeclare):
+    print >>f, 'namespace gen {'
+    for i in range(functions):
+        print >>f, 'struct S%d;' % i
+    passes = 2 if redeclare else 1
+    for p in range(passes):
+        for i in range(functions):
+            name = 'f' if overloaded else 'f%d' % i
+            print >>f, 'void %s(S%d *);' % (name, i)
+    print >>f, '}'
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--functions', type='int', default=100000,
+                      help='number of generated functions')
+    parser.add_option('--redeclare', action='store_true', default=False,
+                      help='declare every function twice')
+    opts, args = parser.parse_args()
+
+    sources = []
+    try:
+        for overloaded in (False, True):
+            source = throughput.generate_file('.cpp', generate_source,
+                                              opts.functions, overloaded,
+                                              opts.redeclare)
+            sources.append(source)
+            throughput.measure(opts.clang, source,
+                               'overloaded' if overloaded else 'distinct names',
+                               ['-fsyntax-only', '-x', 'c++'], opts.runs)
+    finally:
+        throughput.remove_files(sources)
+
+if __name__ == "__main__":
+    main()
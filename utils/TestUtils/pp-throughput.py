@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+"""
+Measure the throughput of preprocessor-only (-E) mode.
+
+By default this generates a large synthetic header, heavy on identifiers,
+punctuators, literals and macro expansions, and reports how fast clang
+preprocesses it. Any files given on the command line (e.g.,
+INPUTS/all-std-headers.cpp) are measured as well.
+
+Usage: pp-throughput.py [--clang=path/to/clang] [--runs=N] [--size=N] [files]
+"""
+
+import os
+
+import throughput
+
+def generate_header(f, N):
+    print >>f, '#define CONCAT(a, b) a ## b'
+    print >>f, '#define FIELD(type, name) type name;'
+    print >>f, '#define MAX(a, b) ((a) > (b) ? (a) : (b))'
+    for i in range(N):
+        print >>f, 'struct S%d {' % i
+        print >>f, '  FIELD(int, x%d) FIELD(double, y%d)' % (i, i)
+        print >>f, '  FIELD(const char *, name)'
+        print >>f, '};'
+        print >>f, 'static inline int f%d(struct S%d *s, int n) {' % (i, i)
+        print >>f, '  int CONCAT(tmp, %d) = MAX(s->x%d, n) << 2;' % (i, i)
+        print >>f, '  s->name = "s%d";' % i
+        print >>f, '  return CONCAT(tmp, %d) + (int)(s->y%d * 1.5e3) - \'a\';' % (
+            i, i)
+        print >>f, '}'
+
+def measure(clang, path, runs):
+    elapsed, size = throughput.time_output(clang, path, ['-E'], runs)
+    print '%-40s %10d bytes  %8.3f s  %8.2f MB/s' % (
+        os.path.basename(path), size, elapsed, size / elapsed / (1 << 20))
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--size', type='int', default=20000,
+                      help='number of declaration groups in the generated '
+                           'header')
+    opts, args = parser.parse_args()
+
+    header = throughput.generate_file('.h', generate_header, opts.size)
+    try:
+        measure(opts.clang, header, opts.runs)
+        for path in args:
+            measure(opts.clang, path, opts.runs)
+    finally:
+        throughput.remove_files([header])
+
+if __name__ == "__main__":
+    main()
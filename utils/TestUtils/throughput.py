@@ -0,0 +1,109 @@
+"""
+Helpers shared by the *-throughput.py scripts, which generate source files
+and time clang -cc1 on them.
+"""
+
+import optparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+def create_parser(doc):
+    """Return an option parser with the --clang and --runs options."""
+    parser = optparse.OptionParser(usage=doc.strip())
+    parser.add_option('--clang', default='clang',
+                      help='the clang binary to measure')
+    parser.add_option('--runs', type='int', default=3,
+                      help='number of runs; the fastest run is reported')
+    return parser
+
+def generate_file(suffix, generate, *args):
+    """Write a temporary file with generate(f, *args) and return its path."""
+    fd, path = tempfile.mkstemp(suffix=suffix)
+    f = os.fdopen(fd, 'w')
+    try:
+        generate(f, *args)
+    finally:
+        f.close()
+    return path
+
+def remove_files(paths):
+    for path in paths:
+        os.remove(path)
+
+def time_cc1(clang, path, args, runs):
+    """Run clang -cc1 with args on path runs times and return the fastest
+    time, exiting if any run fails."""
+    best = None
+    devnull = open(os.devnull, 'w')
+    for i in range(runs):
+        start = time.time()
+        if subprocess.call([clang, '-cc1'] + args + [path],
+                           stderr=devnull) != 0:
+            print >>sys.stderr, 'error: %s %s failed' % (clang, ' '.join(args))
+            sys.exit(1)
+        elapsed = time.time() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+def time_output(clang, path, args, runs):
+    """Run the clang driver with args on path runs times, reading what it
+    writes to stdout, and return the fastest time and the size of the output,
+    exiting if any run fails."""
+    best = None
+    size = 0
+    devnull = open(os.devnull, 'w')
+    for i in range(runs):
+        start = time.time()
+        p = subprocess.Popen([clang] + args + [path], stdout=subprocess.PIPE,
+                             stderr=devnull)
+        size = 0
+        for chunk in iter(lambda: p.stdout.read(1 << 16), ''):
+            size += len(chunk)
+        if p.wait() != 0:
+            print >>sys.stderr, 'error: %s %s failed' % (clang, ' '.join(args))
+            sys.exit(1)
+        elapsed = time.time() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best, size
+
+def report(name, seconds):
+    print '%-30s %8.3f s' % (name, seconds)
+
+def measure(clang, path, name, args, runs):
+    """Time clang -cc1 with args on path, report the fastest run under name
+    and return it."""
+    best = time_cc1(clang, path, args, runs)
+    report(name, best)
+    return best
+
+def time_timer(clang, path, args, timer, runs):
+    """Run clang -cc1 -ftime-report with args on path runs times and return
+    the lowest wall time reported for the named timer, exiting if any run
+    fails or does not report the timer."""
+    best = None
+    devnull = open(os.devnull, 'w')
+    for i in range(runs):
+        p = subprocess.Popen([clang, '-cc1', '-ftime-report'] + args + [path],
+                             stdout=devnull, stderr=subprocess.PIPE)
+        report = p.communicate()[1]
+        if p.returncode != 0:
+            print >>sys.stderr, 'error: %s %s failed' % (clang, ' '.join(args))
+            sys.exit(1)
+        elapsed = None
+        for line in report.splitlines():
+            if line.strip().endswith(timer):
+                # The wall time is the last column before the name.
+                elapsed = float(re.findall(r'([0-9.]+) \(', line)[-1])
+        if elapsed is None:
+            print >>sys.stderr, 'error: %s does not report "%s"' % (clang,
+                                                                    timer)
+            sys.exit(1)
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
@@ -0,0 +1,84 @@
+#!/usr/bin/env python
+
+"""
+Measure the time clang spends on vtables of classes from a precompiled header.
+
+This generates a header with a hierarchy of dynamic classes, where each class
+derives from an earlier one and some also derive virtually from a common
+base, and a source file that defines the key function of every class and
+calls each virtual method. The header is precompiled, and the source file is
+compiled with -fsyntax-only and with -emit-llvm against it. Most of the
+difference between the two is spent emitting the vtables and the virtual
+calls, which includes laying out the vtables of the classes in the header
+unless they were stored in it.
+
+Pass --baseline to compare with another clang, e.g. one that does not store
+vtable layouts in precompiled headers.
+
+Usage: vtable-pch-throughput.py [--clang=path/to/clang]
+                                [--baseline=path/to/clang] [--runs=N]
+                                [--size=N]
+"""
+
+import os
+import tempfile
+
+import throughput
+
+def generate_header(f, size):
+    print >>f, 'struct Root { virtual ~Root(); virtual void root(); };'
+    print >>f, 'struct Class0 { virtual ~Class0(); virtual void f0(); };'
+    for i in range(1, size):
+        bases = ['public Class%d' % ((i - 1) / 2)]
+        if i % 10 == 0:
+            bases.append('public virtual Root')
+        print >>f, 'struct Class%d : %s {' % (i, ', '.join(bases))
+        print >>f, '  virtual void f%d();' % i
+        print >>f, '  void f%d();' % ((i - 1) / 2)
+        print >>f, '};'
+
+def generate_source(f, size):
+    print >>f, 'Root::~Root() { }'
+    print >>f, 'void Root::root() { }'
+    print >>f, 'Class0::~Class0() { }'
+    print >>f, 'void Class0::f0() { }'
+    for i in range(1, size):
+        print >>f, 'void Class%d::f%d() { }' % (i, i)
+        print >>f, 'void Class%d::f%d() { }' % (i, (i - 1) / 2)
+        print >>f, 'void call%d(Class%d *c) { c->f%d(); }' % (i, i, i)
+
+def main():
+    parser = throughput.create_parser(__doc__)
+    parser.add_option('--baseline', default=None,
+                      help='another clang binary to compare with')
+    parser.add_option('--size', type='int', default=1000,
+                      help='number of classes in the generated hierarchy')
+    opts, args = parser.parse_args()
+
+    clangs = [('clang', opts.clang)]
+    if opts.baseline:
+        clangs.append(('baseline', opts.baseline))
+
+    header = throughput.generate_file('.h', generate_header, opts.size)
+    source = throughput.generate_file('.cpp', generate_source, opts.size)
+    fd, pch = tempfile.mkstemp(suffix='.pch')
+    os.close(fd)
+    try:
+        for name, clang in clangs:
+            throughput.time_cc1(clang, header,
+                                ['-x', 'c++-header', '-emit-pch', '-o', pch],
+                                1)
+            common = ['-x', 'c++', '-O0', '-include-pch', pch]
+            parse = throughput.time_cc1(clang, source,
+                                        common + ['-fsyntax-only'], opts.runs)
+            codegen = throughput.time_cc1(clang, source,
+                                          common + ['-emit-llvm', '-o',
+                                                    os.devnull],
+                                          opts.runs)
+            throughput.report(name + ' (parse)', parse)
+            throughput.report(name + ' (codegen)', max(codegen - parse, 0))
+    finally:
+        throughput.remove_files([header, source, pch])
+
+if __name__ == "__main__":
+    main()